@@ -0,0 +1,272 @@
+/**
+ *  @file   ckptBench.c
+ *  @date   October, 2018
+ *  @brief  Checkpoint/recovery benchmark for FTI.
+ *
+ *  The program protects synthetic datasets and measures the time and the
+ *  bandwidth of FTI_Checkpoint, resp. FTI_Recover, and the peak RSS of
+ *  the application processes. It takes the following arguments:
+ *
+ *    - arg1: FTI configuration file
+ *    - arg2: checkpoint level passed to FTI_Checkpoint (1-4, 8 = L4 dCP)
+ *    - arg3: size of the protected data per process in MB
+ *    - arg4: number of protected variables
+ *    - arg5: number of checkpoints
+ *    - arg6: percentage of the data modified between two checkpoints
+ *    - arg7: result file (CSV, JSON lines if the name ends with .json)
+ *    - arg8: label of the run (optional, e.g. the commit)
+ *
+ *  The first execution (FTI_Status() == 0) takes the checkpoints and stops
+ *  without finalizing FTI, to simulate a failure. The second execution with
+ *  the same configuration file recovers and validates the data. Each
+ *  execution appends one result line per measurement to the result file.
+ *
+ *  See run-bench.sh for the sweep over I/O modes, levels and head/inline
+ *  settings.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <fti.h>
+#include "../deps/iniparser/iniparser.h"
+
+#define MB (1024L*1024L)
+
+#define BENCH_OK 0
+#define BENCH_WRONG_ARGS 1
+#define BENCH_RECOVERY_FAILED 2
+#define BENCH_DATA_CORRUPT 3
+
+/** Settings of the run, for the result records. */
+typedef struct benchInfo {
+    char label[256];
+    int ioMode;
+    int head;
+    int inlineLvl;
+    int dcp;
+    int nbProcs;
+    int level;
+    long sizeMB;
+    int nbVar;
+    int dirty;
+} benchInfo;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the peak RSS of the process in KB.
+ **/
+/*-------------------------------------------------------------------------*/
+static long peakRss()
+{
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        return -1;
+    }
+    return ru.ru_maxrss;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Fills a part of the data with values depending on the iteration.
+ **/
+/*-------------------------------------------------------------------------*/
+static void fillData(uint64_t* data, size_t count, int var, int iter, int dirty)
+{
+    size_t n = (count * dirty) / 100;
+    size_t i;
+    for (i = 0; i < n; i++) {
+        data[i] = ((uint64_t)var << 48) ^ ((uint64_t)iter << 32) ^ i;
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Checks the data recovered from the checkpoint of iteration iter.
+ **/
+/*-------------------------------------------------------------------------*/
+static int checkData(uint64_t* data, size_t count, int var, int iter, int dirty)
+{
+    size_t n = (count * dirty) / 100;
+    size_t i;
+    for (i = 0; i < count; i++) {
+        // the untouched part holds the values of the first checkpoint
+        int it = (i < n) ? iter : 1;
+        if (data[i] != (((uint64_t)var << 48) ^ ((uint64_t)it << 32) ^ i)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Appends one measurement to the result file (rank 0 only).
+ **/
+/*-------------------------------------------------------------------------*/
+static void writeResult(const char* fn, benchInfo* info, const char* phase,
+        int iter, double time, double bytes, long rss)
+{
+    double bw = (time > 0) ? bytes / MB / time : 0;
+    size_t len = strlen(fn);
+    int json = (len > 5 && strcmp(fn + len - 5, ".json") == 0);
+
+    FILE* fd = fopen(fn, "a+");
+    if (fd == NULL) {
+        fprintf(stderr, "[ckptBench] cannot open result file '%s'\n", fn);
+        return;
+    }
+    fseek(fd, 0, SEEK_END);
+    if (!json && ftell(fd) == 0) {
+        fprintf(fd, "label,phase,io,level,head,inline,dcp,nprocs,size_mb,nbvar,dirty,iter,"
+                "time_s,bw_mbs,maxrss_kb\n");
+    }
+    if (json) {
+        fprintf(fd, "{\"label\":\"%s\",\"phase\":\"%s\",\"io\":%d,\"level\":%d,\"head\":%d,"
+                "\"inline\":%d,\"dcp\":%d,\"nprocs\":%d,\"size_mb\":%ld,\"nbvar\":%d,"
+                "\"dirty\":%d,\"iter\":%d,\"time_s\":%.6f,\"bw_mbs\":%.2f,\"maxrss_kb\":%ld}\n",
+                info->label, phase, info->ioMode, info->level, info->head, info->inlineLvl,
+                info->dcp, info->nbProcs, info->sizeMB, info->nbVar, info->dirty, iter,
+                time, bw, rss);
+    } else {
+        fprintf(fd, "%s,%s,%d,%d,%d,%d,%d,%d,%ld,%d,%d,%d,%.6f,%.2f,%ld\n",
+                info->label, phase, info->ioMode, info->level, info->head, info->inlineLvl,
+                info->dcp, info->nbProcs, info->sizeMB, info->nbVar, info->dirty, iter,
+                time, bw, rss);
+    }
+    fclose(fd);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 8) {
+        fprintf(stderr, "usage: %s <config> <level> <size MB> <nb. var.> <nb. ckpt.> "
+                "<dirty %%> <result file> [label]\n", argv[0]);
+        return BENCH_WRONG_ARGS;
+    }
+
+    MPI_Init(&argc, &argv);
+    int res = FTI_Init(argv[1], MPI_COMM_WORLD);
+    if (res == FTI_NREC) {
+        exit(BENCH_RECOVERY_FAILED);
+    }
+
+    benchInfo info;
+    memset(&info, 0, sizeof(benchInfo));
+    info.level = atoi(argv[2]);
+    info.sizeMB = atol(argv[3]);
+    info.nbVar = atoi(argv[4]);
+    int nbCkpt = atoi(argv[5]);
+    info.dirty = atoi(argv[6]);
+    char* resFile = argv[7];
+    snprintf(info.label, sizeof(info.label), "%s", (argc > 8) ? argv[8] : "");
+
+    if (info.sizeMB <= 0 || info.nbVar <= 0 || nbCkpt <= 0 || info.dirty < 0 || info.dirty > 100) {
+        fprintf(stderr, "[ckptBench] wrong arguments\n");
+        MPI_Abort(MPI_COMM_WORLD, BENCH_WRONG_ARGS);
+    }
+
+    dictionary* ini = iniparser_load(argv[1]);
+    info.ioMode = iniparser_getint(ini, "Basic:ckpt_io", 1);
+    info.head = iniparser_getint(ini, "Basic:head", 0);
+    info.dcp = iniparser_getboolean(ini, "Basic:enable_dcp", 0);
+    int nodeSize = iniparser_getint(ini, "Basic:node_size", 1);
+    int finalTag = iniparser_getint(ini, "Advanced:final_tag", 3107);
+    if (info.level >= 2 && info.level <= 4) {
+        char key[64];
+        snprintf(key, sizeof(key), "Basic:inline_l%d", info.level);
+        info.inlineLvl = iniparser_getint(ini, key, 1);
+    } else {
+        info.inlineLvl = 1;
+    }
+    iniparser_freedict(ini);
+
+    int rank, grank;
+    MPI_Comm_rank(FTI_COMM_WORLD, &rank);
+    MPI_Comm_size(FTI_COMM_WORLD, &info.nbProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &grank);
+
+    // protect the datasets
+    size_t count = (info.sizeMB * MB) / info.nbVar / sizeof(uint64_t);
+    uint64_t** data = (uint64_t**) malloc(info.nbVar * sizeof(uint64_t*));
+    int i;
+    for (i = 0; i < info.nbVar; i++) {
+        data[i] = (uint64_t*) malloc(count * sizeof(uint64_t));
+        if (data[i] == NULL) {
+            fprintf(stderr, "[ckptBench] cannot allocate %zu bytes\n", count * sizeof(uint64_t));
+            MPI_Abort(MPI_COMM_WORLD, BENCH_WRONG_ARGS);
+        }
+        FTI_Protect(i, data[i], count, FTI_ULNG);
+    }
+    int iter = 0;
+    FTI_Protect(info.nbVar, &iter, 1, FTI_INTG);
+
+    double bytes = (double)count * sizeof(uint64_t) * info.nbVar * info.nbProcs;
+    double t, tmax;
+    long rss, rssMax;
+
+    if (FTI_Status() == 0) {
+        for (iter = 1; iter <= nbCkpt; iter++) {
+            for (i = 0; i < info.nbVar; i++) {
+                fillData(data[i], count, i, iter, (iter == 1) ? 100 : info.dirty);
+            }
+            MPI_Barrier(FTI_COMM_WORLD);
+            t = MPI_Wtime();
+            res = FTI_Checkpoint(iter, info.level);
+            t = MPI_Wtime() - t;
+            if (res != FTI_DONE && res != FTI_SCES) {
+                fprintf(stderr, "[ckptBench] checkpoint %d failed\n", iter);
+            }
+            rss = peakRss();
+            MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, FTI_COMM_WORLD);
+            MPI_Reduce(&rss, &rssMax, 1, MPI_LONG, MPI_MAX, 0, FTI_COMM_WORLD);
+            if (rank == 0) {
+                writeResult(resFile, &info, "ckpt", iter, tmax, bytes, rssMax);
+            }
+        }
+
+        // simulate a failure, the heads are stopped as in FTI_Finalize
+        if (info.head > 0) {
+            int value = FTI_ENDW;
+            MPI_Send(&value, 1, MPI_INT, grank - grank % nodeSize, finalTag, MPI_COMM_WORLD);
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        MPI_Finalize();
+        return BENCH_OK;
+    }
+
+    MPI_Barrier(FTI_COMM_WORLD);
+    t = MPI_Wtime();
+    res = FTI_Recover();
+    t = MPI_Wtime() - t;
+    if (res != FTI_SCES) {
+        fprintf(stderr, "[ckptBench] recovery failed\n");
+        exit(BENCH_RECOVERY_FAILED);
+    }
+    rss = peakRss();
+    MPI_Reduce(&t, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, FTI_COMM_WORLD);
+    MPI_Reduce(&rss, &rssMax, 1, MPI_LONG, MPI_MAX, 0, FTI_COMM_WORLD);
+    if (rank == 0) {
+        writeResult(resFile, &info, "reco", iter, tmax, bytes, rssMax);
+    }
+
+    int err = 0, allErr;
+    for (i = 0; i < info.nbVar; i++) {
+        err += checkData(data[i], count, i, iter, info.dirty);
+    }
+    MPI_Allreduce(&err, &allErr, 1, MPI_INT, MPI_SUM, FTI_COMM_WORLD);
+    if (rank == 0 && allErr) {
+        fprintf(stderr, "[ckptBench] recovered data of iteration %d is corrupted\n", iter);
+    }
+
+    for (i = 0; i < info.nbVar; i++) {
+        free(data[i]);
+    }
+    free(data);
+
+    FTI_Finalize();
+    MPI_Finalize();
+    return (allErr) ? BENCH_DATA_CORRUPT : BENCH_OK;
+}
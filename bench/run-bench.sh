@@ -0,0 +1,147 @@
+#!/usr/bin/env bash
+#
+#  @file   run-bench.sh
+#  @date   October, 2018
+#  @brief  Checkpoint/recovery benchmark sweep for FTI.
+#
+#    Runs ckptBench for each combination of I/O mode, level, head and
+#    inline setting (and dCP if requested) on a single node and appends
+#    the results to a CSV (or JSON lines) file. The checkpoint, global
+#    and meta directories are created in a tmpfs directory by default so
+#    that the results measure FTI rather than the storage.
+#
+#  Hit ./run-bench.sh -h for info
+#
+NP=8
+NODE_SIZE=4
+GROUP_SIZE=2
+SIZE=64
+NBVAR=4
+ITERS=3
+DIRTY=100
+IOS="1 2 3"
+LEVELS="1 2 3 4"
+HEADS="0 1"
+INLINES="1"
+DCPS="0"
+WORK=/dev/shm/fti-bench
+OUT=$PWD/fti-bench.csv
+LABEL=$(git -C "$(dirname "$0")" rev-parse --short HEAD 2>/dev/null)
+BENCH=$(dirname "$(readlink -f "$0")")/ckptBench
+MPIRUN=${MPIRUN:-mpirun}
+TIMEOUT=600
+
+display_usage() {
+cat <<EOF
+Usage: ./run-bench.sh [options]
+
+-h|--help            shows this help.
+
+-n|--procs N         number of MPI processes (default: $NP)
+-s|--node-size N     processes per node, including the head (default: $NODE_SIZE)
+-g|--group-size N    size of the encoding groups (default: $GROUP_SIZE)
+-m|--size MB         protected data per process in MB (default: $SIZE)
+-v|--vars N          number of protected variables (default: $NBVAR)
+-i|--iters N         checkpoints per run (default: $ITERS)
+-d|--dirty P         percentage of data modified between checkpoints (default: $DIRTY)
+--io "LIST"          I/O modes: 1 POSIX, 2 MPI-IO, 3 FTI-FF, 4 SIONlib, 5 HDF5 (default: "$IOS")
+--levels "LIST"      checkpoint levels (default: "$LEVELS")
+--heads "LIST"       head settings (default: "$HEADS")
+--inline "LIST"      inline settings of L2-L4, 0 needs a head (default: "$INLINES")
+--dcp "LIST"         dCP settings, 1 only runs L4 with FTI-FF (default: "$DCPS")
+-w|--work DIR        working directory, should be on tmpfs (default: $WORK)
+-o|--output FILE     result file, JSON lines if it ends with .json (default: $OUT)
+-l|--label STR       label of the results (default: current commit)
+
+Each configuration is executed twice: the first run takes the checkpoints
+and simulates a failure, the second run recovers. Results are appended.
+EOF
+}
+
+while [ $# -gt 0 ]; do
+    case $1 in
+        -h|--help) display_usage; exit 0 ;;
+        -n|--procs) NP=$2; shift ;;
+        -s|--node-size) NODE_SIZE=$2; shift ;;
+        -g|--group-size) GROUP_SIZE=$2; shift ;;
+        -m|--size) SIZE=$2; shift ;;
+        -v|--vars) NBVAR=$2; shift ;;
+        -i|--iters) ITERS=$2; shift ;;
+        -d|--dirty) DIRTY=$2; shift ;;
+        --io) IOS=$2; shift ;;
+        --levels) LEVELS=$2; shift ;;
+        --heads) HEADS=$2; shift ;;
+        --inline) INLINES=$2; shift ;;
+        --dcp) DCPS=$2; shift ;;
+        -w|--work) WORK=$2; shift ;;
+        -o|--output) OUT=$(readlink -f "$2"); shift ;;
+        -l|--label) LABEL=$2; shift ;;
+        *) echo "unknown option '$1'"; display_usage; exit 1 ;;
+    esac
+    shift
+done
+
+write_config() { # head inline dcp io
+cat > config.fti <<EOF
+[basic]
+head = $1
+node_size = $NODE_SIZE
+ckpt_dir = $WORK/Local
+glbl_dir = $WORK/Global
+meta_dir = $WORK/Meta
+ckpt_l1 = 0
+ckpt_l2 = 0
+ckpt_l3 = 0
+ckpt_l4 = 0
+inline_l2 = $2
+inline_l3 = $2
+inline_l4 = $2
+keep_last_ckpt = 0
+group_size = $GROUP_SIZE
+verbosity = 3
+ckpt_io = $4
+enable_dcp = $3
+dcp_mode = 0
+dcp_block_size = 16384
+[restart]
+failure = 0
+exec_id = NULL
+[injection]
+rank = 0
+number = 0
+position = 0
+frequency = 0
+[advanced]
+block_size = 1024
+transfer_size = 16
+local_test = 1
+EOF
+}
+
+mkdir -p "$WORK" || exit 1
+cd "$WORK" || exit 1
+FAILED=0
+for io in $IOS; do for head in $HEADS; do for inl in $INLINES; do for dcp in $DCPS; do for level in $LEVELS; do
+    # async post-processing needs a head, dCP is benchmarked for L4 FTI-FF
+    [ "$inl" = "0" ] && { [ "$head" = "0" ] || [ "$level" = "1" ]; } && continue
+    [ "$dcp" = "1" ] && { [ "$io" != "3" ] || [ "$level" != "4" ]; } && continue
+    lvl=$level
+    [ "$dcp" = "1" ] && lvl=8
+    rm -rf Local Global Meta
+    mkdir -p Local Global Meta
+    write_config $head $inl $dcp $io
+    printf "io=%s head=%s inline=%s dcp=%s L%s ... " $io $head $inl $dcp $level
+    timeout $TIMEOUT $MPIRUN -n $NP $BENCH config.fti $lvl $SIZE $NBVAR $ITERS $DIRTY "$OUT" "$LABEL" > ckpt.log 2>&1
+    r1=$?
+    timeout $TIMEOUT $MPIRUN -n $NP $BENCH config.fti $lvl $SIZE $NBVAR $ITERS $DIRTY "$OUT" "$LABEL" > reco.log 2>&1
+    r2=$?
+    if [ $r1 = 0 ] && [ $r2 = 0 ]; then
+        echo "done"
+    else
+        echo "FAILED ($r1 $r2)"
+        FAILED=$((FAILED+1))
+    fi
+done; done; done; done; done
+rm -rf Local Global Meta config.fti ckpt.log reco.log
+echo "Results appended to $OUT"
+exit $FAILED
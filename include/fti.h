@@ -121,6 +121,34 @@ typedef size_t 	hsize_t;
 #define FTI_DCP_MODE_OFFSET 2000
 #define FTI_DCP_MODE_MD5 2001
 #define FTI_DCP_MODE_CRC32 2002
+#define FTI_DCP_MODE_CRC32C 2003
+#define FTI_DCP_MODE_XXH64 2004
+
+/** Compression of FTI-FF chunks: chunks are stored as they are.           */
+#define FTI_COMP_NONE 0
+/** Compression of FTI-FF chunks: built-in LZ codec.                       */
+#define FTI_COMP_LZ 1
+/** Compression of FTI-FF chunks: zlib (deflate).                          */
+#define FTI_COMP_ZLIB 2
+
+/** Stats phase: waiting for the previous post-processing of the head.     */
+#define FTI_STAT_WAIT 0
+/** Stats phase: writing the protected data to the ckpt. file.             */
+#define FTI_STAT_WRITE 1
+/** Stats phase: computing the checksum of the ckpt. file.                 */
+#define FTI_STAT_CHECKSUM 2
+/** Stats phase: agreeing on the success of the write (MPI_Allreduce).     */
+#define FTI_STAT_SYNC 3
+/** Stats phase: creating the metadata (includes FTI_STAT_CHECKSUM).       */
+#define FTI_STAT_META 4
+/** Stats phase: post-processing (L2 copy, L3 encoding, L4 flush).         */
+#define FTI_STAT_POST 5
+/** Stats phase: cleaning and renaming the ckpt. directories.              */
+#define FTI_STAT_CLEAN 6
+/** Stats phase: recovering the protected data (FTI_Recover).              */
+#define FTI_STAT_RECOVER 7
+/** Number of stats phases.                                                */
+#define FTI_STAT_NB 8
 
 #ifdef __cplusplus
 extern "C" {
@@ -164,7 +192,8 @@ extern "C" {
     int lastCkptLvel;           /**< holds last successful cp level         */
     int lastCkptID;             /**< holds last successful cp ID            */
     int countVar;               /**< counts datasets written                */
-    int isWritten[FTI_BUFS];    /**< holds IDs of datasets in cp file       */
+    int nbVar;                  /**< number of elements of isWritten        */
+    bool* isWritten;            /**< TRUE if dataset (index) in cp file     */
     double t0;                  /**< timing for CP statistics               */
     double t1;                  /**< timing for CP statistics               */
     char fh[FTI_ICP_FH_SIZE];   /**< generic fh container                   */
@@ -205,10 +234,12 @@ extern "C" {
   typedef struct              FTIT_DataDiffHash
   {
     unsigned char*          md5hash[2];    /**< MD5 digest                       */
-    uint32_t*               bit32hash[2];  /**< CRC32 digest                     */
+    uint32_t*               bit32hash[2];  /**< CRC32 and CRC32C digest          */
+    uint64_t*               bit64hash[2];  /**< XXH64 digest                     */
     unsigned short*         blockSize;  /**< data block size                  */
     bool*                   isValid;    /**< indicates if data block is valid */
     long                    nbHashes;     /**< holds the number of hashes for the data chunk                    */ 
+    long                    nbAlloc[2];   /**< number of hashes allocated in each hash table                    */ 
     int                     currentId;
     int                     creationType;
     int                     lifetime;
@@ -233,6 +264,9 @@ extern "C" {
     uintptr_t fptr;     /**< file pointer offset                              */
     long chunksize;     /**< chunk size stored aof prot. var. in this block   */
     long containersize; /**< chunk size stored aof prot. var. in this block   */
+    uintptr_t cfptr;    /**< file offset of the stored (compressed) chunk     */
+    long csize;         /**< size of the stored (compressed) chunk in file    */
+    int codec;          /**< codec of the stored chunk (FTI_COMP_*)           */
     unsigned char hash[MD5_DIGEST_LENGTH];  /**< hash of variable chunk       */
     unsigned char myhash[MD5_DIGEST_LENGTH];  /**< hash of this structure     */
     bool update;        /**< TRUE if struct needs to be updated in ckpt file  */
@@ -404,6 +438,7 @@ extern "C" {
     bool                isDevicePtr;        /**< True if this data are stored in a device memory*/
     void                *devicePtr;         /**< Pointer to data in the device                  */
     FTIT_sharedData     sharedData;         /**< Info if dataset is sub-set (VPR)               */
+    FTIT_DataDiffHash*  dcpHash;            /**< dCP meta data (POSIX and MPI-IO)               */
   } FTIT_dataset;
 
   /** @typedef    FTIT_metadata
@@ -419,8 +454,8 @@ extern "C" {
     char*            ckptFile;           /**< Ckpt file name. [FTI_BUFS]            */
     char*            currentL4CkptFile;  /**< Current Ckpt file name. [FTI_BUFS]    */        
     int*             nbVar;              /**< Number of variables. [FTI_BUFS]       */
-    int*             varID;              /**< Variable id for size.[FTI_BUFS]       */
-    long*            varSize;            /**< Variable size. [FTI_BUFS]             */
+    int*             varID;              /**< Variable id for size.[nbVarMax]       */
+    long*            varSize;            /**< Variable size. [nbVarMax]             */
   } FTIT_metadata;
 
   /** @typedef    FTIT_execution
@@ -436,6 +471,9 @@ extern "C" {
     int             ckptIntv;           /**< Ckpt. interval in minutes.     */
     int             lastCkptLvel;       /**< Last checkpoint level.         */
     int             wasLastOffline;     /**< TRUE if last ckpt. offline.    */
+    int             asyncSent;          /**< Ckpt. requests sent to head.   */
+    int             asyncDone;          /**< Ckpt. requests done by head.   */
+    bool            postAsync;          /**< TRUE if head post-processes.   */
     double          iterTime;           /**< Current wall time.             */
     double          lastIterTime;       /**< Time spent in the last iter.   */
     double          meanIterTime;       /**< Mean iteration time.           */
@@ -453,12 +491,14 @@ extern "C" {
     unsigned int    ckptLast;           /**< Iteration for last checkpoint. */
     long            ckptSize;           /**< Checkpoint size.               */
     unsigned int    nbVar;              /**< Number of protected variables. */
+    unsigned int    nbVarMax;           /**< Variable slots (per process).  */
     unsigned int    nbVarStored;        /**< Nr. prot. var. stored in file  */
     unsigned int    nbType;             /**< Number of data types.          */
     int             nbGroup;            /**< Number of protected groups.    */
     int             metaAlloc;          /**< TRUE if meta allocated.        */
     int             initSCES;           /**< TRUE if FTI initialized.       */
     char    h5SingleFileLast[FTI_BUFS]; /**< Last HDF5 single file name     */
+    char    integrity[MD5_DIGEST_STRING_LENGTH]; /**< Checksum of last write */
     FTIT_metadata   meta[5];            /**< Metadata for each ckpt level   */
     FTIFF_db         *firstdb;          /**< Pointer to first datablock     */
     FTIFF_db         *lastdb;           /**< Pointer to first datablock     */
@@ -485,6 +525,7 @@ extern "C" {
     bool            keepHeadsAlive;     /**< TRUE if heads return           */
     int             dcpMode;            /**< dCP mode.                      */
     int             dcpBlockSize;       /**< Block size for dCP hash        */
+    int             dcpThreads;         /**< Threads for dCP hashing        */
     char            cfgFile[FTI_BUFS];  /**< Configuration file name.       */
     int             saveLastCkpt;       /**< TRUE to save last checkpoint.  */
     int             verbosity;          /**< Verbosity level.               */
@@ -501,7 +542,18 @@ extern "C" {
     int             generalTag;         /**< MPI tag for general comm.          */
     int             test;               /**< TRUE if local test.                */
     int             l3WordSize;         /**< RS encoding word size.             */
+    int             rsThreads;          /**< Threads for RS encoding/decoding.  */
+    int             flushBuffers;       /**< In-flight buffers of L4 flush.     */
+    bool            metaIni;            /**< TRUE if metadata written as INI.   */
+    long            headPollMax;        /**< Max. head sleep between polls (us).*/
+    int             asyncDepth;         /**< Max. async. ckpts. in flight.      */
+    bool            directIO;           /**< TRUE if local ckpts. use O_DIRECT. */
+    bool            l2Delta;            /**< TRUE if L2 sends changed blocks.   */
+    bool            statsEnabled;       /**< TRUE if ckpt. stats are collected. */
+    char            traceFile[FTI_BUFS]; /**< Prefix of the trace files.        */
+    MPI_Info        mpiioInfo;          /**< MPI-IO hints for ckpt. files.      */
     int             ioMode;             /**< IO mode for L4 ckpt.               */
+    int             compMode;           /**< Codec of FTI-FF chunks (FTI_COMP_*)*/
     bool            h5SingleFileEnable; /**< TRUE if VPR enabled                */
     bool            h5SingleFileKeep;   /**< TRUE if VPR files to keep          */
     char            h5SingleFileDir[FTI_BUFS]; /**< HDF5 single file dir        */
@@ -582,6 +634,26 @@ extern "C" {
     double          timer;              /**< Timer to measure frequency     */
   } FTIT_injection;
 
+  /** @typedef    FTIT_phaseStats
+   *  @brief      Time and data volume of a checkpoint phase.
+   */
+  typedef struct FTIT_phaseStats {
+    unsigned long   count;              /**< Number of measurements.        */
+    double          time;               /**< Accumulated time (sec.)        */
+    unsigned long long bytes;           /**< Accumulated data volume.       */
+  } FTIT_phaseStats;
+
+  /** @typedef    FTIT_stats
+   *  @brief      Checkpoint statistics of the process.
+   *
+   *  phase[l][p] accumulates the phase p (FTI_STAT_*) of the checkpoints
+   *  (resp. recoveries) of level l = 1..4, phase[0][p] over all levels.
+   */
+  typedef struct FTIT_stats {
+    int             ioMode;             /**< IO mode of the ckpt. files.    */
+    FTIT_phaseStats phase[5][FTI_STAT_NB]; /**< Stats per level and phase.  */
+  } FTIT_stats;
+
   /*---------------------------------------------------------------------------
     Global variables
     ---------------------------------------------------------------------------*/
@@ -645,6 +717,7 @@ extern "C" {
   int FTI_InitICP(int id, int level, bool activate);
   int FTI_AddVarICP( int varID ); 
   int FTI_FinalizeICP(); 
+  int FTI_GetStats(FTIT_stats* stats);
 
 #ifdef __cplusplus
 }
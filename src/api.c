@@ -63,7 +63,10 @@ static FTIT_execution FTI_Exec;
 static FTIT_topology FTI_Topo;
 
 /** Array of datasets and all their internal information.                  */
-static FTIT_dataset FTI_Data[FTI_BUFS];
+static FTIT_dataset* FTI_Data = NULL;
+
+/** Number of elements allocated in FTI_Data.                              */
+static int FTI_DataMax = 0;
 
 /** SDC injection model and all the required information.                  */
 static FTIT_injection FTI_Inje;
@@ -136,12 +139,24 @@ int FTI_Init(char* configFile, MPI_Comm globalComm)
         return FTI_NSCS;
     }
     FTI_Try(FTI_InitGroupsAndTypes(&FTI_Exec), "malloc arrays for groups and types.");
+    free(FTI_Data);
+    FTI_FreeDatasetRegistry();
+    FTI_DataMax = FTI_BUFS;
+    FTI_Data = calloc(FTI_DataMax, sizeof(FTIT_dataset));
+    if (FTI_Data == NULL) {
+        FTI_Print("Unable to allocate memory for the datasets.", FTI_EROR);
+        return FTI_NSCS;
+    }
     FTI_Try(FTI_InitBasicTypes(FTI_Data), "create the basic data types.");
     if (FTI_Topo.myRank == 0) {
         int restart = (FTI_Exec.reco != 3) ? FTI_Exec.reco : 0;
         FTI_Try(FTI_UpdateConf(&FTI_Conf, &FTI_Exec, restart), "update configuration file.");
     }
     MPI_Barrier(FTI_Exec.globalComm); //wait for myRank == 0 process to save config file
+    FTI_InitStats(&FTI_Conf);
+    // the pool is shared by the L3 encoding and the dCP hashing
+    FTI_InitThreadPool((FTI_Conf.dcpEnabled && FTI_Conf.dcpThreads > FTI_Conf.rsThreads) ?
+            FTI_Conf.dcpThreads : FTI_Conf.rsThreads);
     FTI_MallocMeta(&FTI_Exec, &FTI_Topo);
     res = FTI_Try(FTI_LoadMeta(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt), "load metadata");
     if (res == FTI_NSCS) {
@@ -699,51 +714,62 @@ int FTI_Protect(int id, void* ptr, long count, FTIT_type type)
         return res;
 #endif
 
-    int i;
     char memLocation[4];
-    for (i = 0; i < FTI_BUFS; i++) {
-        if (id == FTI_Data[i].id) { //Search for dataset with given id
-            long prevSize = FTI_Data[i].size;
+    int i = FTI_GetDatasetIdx(id);
+    if (i != -1) { //Dataset with given id already protected
+        long prevSize = FTI_Data[i].size;
 #ifdef GPUSUPPORT
-            if ( ptrInfo.type == FTIT_PTRTYPE_CPU) {
-                strcpy(memLocation,"CPU");
-                FTI_Data[i].isDevicePtr = false;
-                FTI_Data[i].devicePtr= NULL;
-                FTI_Data[i].ptr = ptr;
-            }
-            else if( ptrInfo.type == FTIT_PTRTYPE_GPU ){
-                strcpy(memLocation,"GPU");
-                FTI_Data[i].isDevicePtr = true;
-                FTI_Data[i].devicePtr= ptr;
-                FTI_Data[i].ptr = NULL; //(void *) malloc (type.size *count);
-            }
-            else{
-                FTI_Print("ptr Should be either a device location or a cpu location\n",FTI_EROR);
-                FTI_Data[i].ptr = NULL; //(void *) malloc (type.size *count);
-                return FTI_NSCS;
-            }
-#else            
+        if ( ptrInfo.type == FTIT_PTRTYPE_CPU) {
             strcpy(memLocation,"CPU");
             FTI_Data[i].isDevicePtr = false;
             FTI_Data[i].devicePtr= NULL;
             FTI_Data[i].ptr = ptr;
-#endif  
-            FTI_Data[i].count = count;
-            FTI_Data[i].type = FTI_Exec.FTI_Type[type.id];
-            FTI_Data[i].eleSize = type.size;
-            FTI_Data[i].size = type.size * count;
-            FTI_Data[i].dimLength[0] = count;
-            FTI_Exec.ckptSize = FTI_Exec.ckptSize + ((type.size * count) - prevSize);
-            sprintf(str, "Variable ID %d reseted. (Stored In %s).  Current ckpt. size per rank is %.2fMB.", id, memLocation, (float) FTI_Exec.ckptSize / (1024.0 * 1024.0));
-            FTI_Print(str, FTI_DBUG);
-            return FTI_SCES;
         }
+        else if( ptrInfo.type == FTIT_PTRTYPE_GPU ){
+            strcpy(memLocation,"GPU");
+            FTI_Data[i].isDevicePtr = true;
+            FTI_Data[i].devicePtr= ptr;
+            FTI_Data[i].ptr = NULL; //(void *) malloc (type.size *count);
+        }
+        else{
+            FTI_Print("ptr Should be either a device location or a cpu location\n",FTI_EROR);
+            FTI_Data[i].ptr = NULL; //(void *) malloc (type.size *count);
+            return FTI_NSCS;
+        }
+#else            
+        strcpy(memLocation,"CPU");
+        FTI_Data[i].isDevicePtr = false;
+        FTI_Data[i].devicePtr= NULL;
+        FTI_Data[i].ptr = ptr;
+#endif  
+        FTI_Data[i].count = count;
+        FTI_Data[i].type = FTI_Exec.FTI_Type[type.id];
+        FTI_Data[i].eleSize = type.size;
+        FTI_Data[i].size = type.size * count;
+        FTI_Data[i].dimLength[0] = count;
+        FTI_Exec.ckptSize = FTI_Exec.ckptSize + ((type.size * count) - prevSize);
+        sprintf(str, "Variable ID %d reseted. (Stored In %s).  Current ckpt. size per rank is %.2fMB.", id, memLocation, (float) FTI_Exec.ckptSize / (1024.0 * 1024.0));
+        FTI_Print(str, FTI_DBUG);
+        return FTI_SCES;
     }
     //Id could not be found in datasets
 
-    //If too many variables exit FTI.
-    if (FTI_Exec.nbVar >= FTI_BUFS) {
-        FTI_Print("Unable to register variable. Too many variables already registered.", FTI_WARN);
+    //If the dataset array is full, double its size.
+    if (FTI_Exec.nbVar >= FTI_DataMax) {
+        FTIT_dataset* data = realloc(FTI_Data, sizeof(FTIT_dataset) * 2 * FTI_DataMax);
+        if (data == NULL) {
+            FTI_Print("Unable to register variable. Cannot allocate memory for the datasets.", FTI_WARN);
+            return FTI_NSCS;
+        }
+        memset(&data[FTI_DataMax], 0x0, sizeof(FTIT_dataset) * FTI_DataMax);
+        for (i = FTI_DataMax; i < 2 * FTI_DataMax; i++) {
+            data[i].id = -1;
+        }
+        FTI_Data = data;
+        FTI_DataMax = 2 * FTI_DataMax;
+    }
+    if (FTI_ReallocMetaVars(&FTI_Exec, 1, FTI_Exec.nbVar + 1) != FTI_SCES) {
+        FTI_Print("Unable to register variable. Cannot allocate memory for the metadata.", FTI_WARN);
         return FTI_NSCS;
     }
 
@@ -773,6 +799,10 @@ int FTI_Protect(int id, void* ptr, long count, FTIT_type type)
     FTI_Data[FTI_Exec.nbVar].devicePtr= NULL;
     FTI_Data[FTI_Exec.nbVar].ptr = ptr;
 #endif  
+    if (FTI_RegisterDataset(id, FTI_Exec.nbVar) != FTI_SCES) {
+        FTI_Print("Unable to register variable.", FTI_WARN);
+        return FTI_NSCS;
+    }
     // Important assignment, we use realloc!
     FTI_Data[FTI_Exec.nbVar].sharedData.dataset = NULL;
     FTI_Data[FTI_Exec.nbVar].count = count;
@@ -881,15 +911,9 @@ int FTI_AddSubset( int id, int rank, hsize_t* offset, hsize_t* count, int did )
 #ifdef ENABLE_HDF5
     int i, found=0, pvar_idx;
     
-    for(i=0; i<FTI_Exec.nbVar; i++) {
-        if( FTI_Data[i].id == id ) {
-            found = 1;
-            pvar_idx = i;
-            break;
-        }
-    }
+    pvar_idx = FTI_GetDatasetIdx(id);
     
-    if( !found ) {
+    if( pvar_idx == -1 ) {
         FTI_Print( "variable id could not be found!", FTI_EROR );
         return FTI_NSCS;
     }
@@ -977,38 +1001,36 @@ int FTI_DefineDataset(int id, int rank, int* dimLength, char* name, FTIT_H5Group
 
     char str[FTI_BUFS]; //For console output
 
-    int i;
-    for (i = 0; i < FTI_BUFS; i++) {
-        if (id == FTI_Data[i].id) { //Search for dataset with given id
-            //check if size is correct
-            int expectedSize = 1;
-            int j;
-            for (j = 0; j < rank; j++) {
-                expectedSize *= dimLength[j]; //compute the number of elements
-            }
+    int i = FTI_GetDatasetIdx(id);
+    if (i != -1) { //Search for dataset with given id
+        //check if size is correct
+        int expectedSize = 1;
+        int j;
+        for (j = 0; j < rank; j++) {
+            expectedSize *= dimLength[j]; //compute the number of elements
+        }
 
-            if (rank > 0) {
-                if (expectedSize != FTI_Data[i].count) {
-                    sprintf(str, "Trying to define datasize: number of elements %d, but the dataset count is %ld.", expectedSize, FTI_Data[i].count);
-                    FTI_Print(str, FTI_WARN);
-                    return FTI_NSCS;
-                }
-                FTI_Data[i].rank = rank;
-                for (j = 0; j < rank; j++) {
-                    FTI_Data[i].dimLength[j] = dimLength[j];
-                }
+        if (rank > 0) {
+            if (expectedSize != FTI_Data[i].count) {
+                sprintf(str, "Trying to define datasize: number of elements %d, but the dataset count is %ld.", expectedSize, FTI_Data[i].count);
+                FTI_Print(str, FTI_WARN);
+                return FTI_NSCS;
             }
-
-            if (h5group != NULL) {
-                FTI_Data[i].h5group = FTI_Exec.H5groups[h5group->id];
+            FTI_Data[i].rank = rank;
+            for (j = 0; j < rank; j++) {
+                FTI_Data[i].dimLength[j] = dimLength[j];
             }
+        }
 
-            if (name != NULL) {
-                strncpy(FTI_Data[i].name, name, FTI_BUFS);
-            }
-            
-            return FTI_SCES;
+        if (h5group != NULL) {
+            FTI_Data[i].h5group = FTI_Exec.H5groups[h5group->id];
+        }
+
+        if (name != NULL) {
+            strncpy(FTI_Data[i].name, name, FTI_BUFS);
         }
+        
+        return FTI_SCES;
     }
 
     sprintf(str, "The dataset #%d not initialized. Use FTI_Protect first.", id);
@@ -1037,22 +1059,16 @@ long FTI_GetStoredSize(int id)
         return 0;
     }
 
-    int i;
     //Search first in temporary metadata (always the newest)
-    for (i = 0; i < FTI_BUFS; i++) {
-        if (FTI_Exec.meta[0].varID[i] == id) {
-            if (FTI_Exec.meta[0].varSize[i] != 0) {
-                return FTI_Exec.meta[0].varSize[i];
-            }
-            break;
-        }
+    int i = FTI_GetMetaVarIdx(&FTI_Exec, 0, id);
+    if (i != -1 && FTI_Exec.meta[0].varSize[i] != 0) {
+        return FTI_Exec.meta[0].varSize[i];
     }
     //If couldn't find in temporary metadata, search in last level checkpoint
     //(this means no checkpoint was taken in current execution)
-    for (i = 0; i < FTI_BUFS; i++) {
-        if (FTI_Exec.meta[FTI_Exec.ckptLvel].varID[i] == id) {
-            return FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i];
-        }
+    i = FTI_GetMetaVarIdx(&FTI_Exec, FTI_Exec.ckptLvel, id);
+    if (i != -1) {
+        return FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i];
     }
     return 0;
 }
@@ -1077,26 +1093,23 @@ void* FTI_Realloc(int id, void* ptr)
     FTI_Print("Trying to reallocate dataset.", FTI_DBUG);
     if (FTI_Exec.reco) {
         char str[FTI_BUFS];
-        int i;
-        for (i = 0; i < FTI_BUFS; i++) {
-            if (id == FTI_Data[i].id) {
-                long oldSize = FTI_Data[i].size;
-                FTI_Data[i].size = FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i];
-                sprintf(str, "Reallocated size: %ld", FTI_Data[i].size);
+        int i = FTI_GetDatasetIdx(id);
+        if (i != -1) {
+            long oldSize = FTI_Data[i].size;
+            FTI_Data[i].size = FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i];
+            sprintf(str, "Reallocated size: %ld", FTI_Data[i].size);
+            FTI_Print(str, FTI_DBUG);
+            if (FTI_Data[i].size == 0) {
+                sprintf(str, "Cannot allocate 0 size.");
                 FTI_Print(str, FTI_DBUG);
-                if (FTI_Data[i].size == 0) {
-                    sprintf(str, "Cannot allocate 0 size.");
-                    FTI_Print(str, FTI_DBUG);
-                    return ptr;
-                }
-                ptr = realloc (ptr, FTI_Data[i].size);
-                FTI_Data[i].ptr = ptr;
-                FTI_Data[i].count = FTI_Data[i].size / FTI_Data[i].eleSize;
-                FTI_Exec.ckptSize += FTI_Data[i].size - oldSize;
-                sprintf(str, "Dataset #%d reallocated.", FTI_Data[i].id);
-                FTI_Print(str, FTI_INFO);
-                break;
+                return ptr;
             }
+            ptr = realloc (ptr, FTI_Data[i].size);
+            FTI_Data[i].ptr = ptr;
+            FTI_Data[i].count = FTI_Data[i].size / FTI_Data[i].eleSize;
+            FTI_Exec.ckptSize += FTI_Data[i].size - oldSize;
+            sprintf(str, "Dataset #%d reallocated.", FTI_Data[i].id);
+            FTI_Print(str, FTI_INFO);
         }
     }
     else {
@@ -1246,6 +1259,9 @@ int FTI_Checkpoint(int id, int level)
 
     double t1, t2;
 
+    // a checkpoint ends the recovery phase of FTI_RecoverVar
+    FTI_FinalizeRecoverVar();
+
     FTI_Exec.ckptID = id;
     
     // reset hdf5 single file requests.
@@ -1302,14 +1318,18 @@ int FTI_Checkpoint(int id, int level)
     // reset dcp requests.
     FTI_Ckpt[4].isDcp = false;
     if ( level == FTI_L4_DCP ) {
-        if ( FTI_Conf.ioMode == FTI_IO_FTIFF ) {
+        // POSIX and MPI-IO update the dCP file in the PFS directly
+        bool inlineIO = (FTI_Conf.ioMode == FTI_IO_POSIX) || (FTI_Conf.ioMode == FTI_IO_MPI);
+        if ( FTI_Conf.ioMode == FTI_IO_FTIFF || (inlineIO && FTI_Ckpt[4].isInline) ) {
             if ( FTI_Conf.dcpEnabled ) {
                 FTI_Ckpt[4].isDcp = true;
             } else {
                 FTI_Print("L4 dCP requested, but dCP is disabled!", FTI_WARN);
             }
+        } else if ( inlineIO ) {
+            FTI_Print("L4 dCP requested, but dCP needs inline L4 for POSIX and MPI-IO!", FTI_WARN);
         } else {
-            FTI_Print("L4 dCP requested, but dCP needs FTI-FF!", FTI_WARN);
+            FTI_Print("L4 dCP requested, but dCP needs FTI-FF, POSIX or MPI-IO!", FTI_WARN);
         }
         level = 4;
     }
@@ -1317,19 +1337,11 @@ int FTI_Checkpoint(int id, int level)
     bool ckptFirst = !FTI_Exec.hasCkpt; //ckptID = 0 if first checkpoint
 
     double t0 = MPI_Wtime(); //Start time
-    if (FTI_Exec.wasLastOffline == 1) { // Block until previous checkpoint is done (Async. work)
-        int lastLevel;
-        MPI_Recv(&lastLevel, 1, MPI_INT, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm, MPI_STATUS_IGNORE);
-        if (lastLevel != FTI_NSCS) { //Head sends level of checkpoint if post-processing succeed, FTI_NSCS Otherwise
-            FTI_Exec.lastCkptLvel = lastLevel; //Store last successful post-processing checkpoint level
-            sprintf(str, "LastCkptLvel received from head: %d", lastLevel);
-            FTI_Print(str, FTI_DBUG);
-        } else {
-            FTI_Print("Head failed to do post-processing after previous checkpoint.", FTI_WARN);
-        }
-    }
+    // Block only if too many checkpoints are in flight (Async. work)
+    FTI_PrepareCkptGen(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, level);
     
     t1 = MPI_Wtime(); //Time after waiting for head to done previous post-processing
+    FTI_StatsStop(FTI_STAT_WAIT, level, t0, 0);
     int lastCkptLvel = FTI_Exec.ckptLvel; //Store last successful writing checkpoint level in case of failure
     FTI_Exec.ckptLvel = level; //For FTI_WriteCkpt
     int res = FTI_Try(FTI_WriteCkpt(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, FTI_Data), "write the checkpoint.");
@@ -1337,57 +1349,34 @@ int FTI_Checkpoint(int id, int level)
     
     // set hasCkpt flags true
     if ( FTI_Conf.dcpEnabled && FTI_Ckpt[4].isDcp ) {
-        FTIFF_db* currentDB = FTI_Exec.firstdb;
-        currentDB->update = false;
-        do {    
-            int varIdx;
-            for(varIdx=0; varIdx<currentDB->numvars; ++varIdx) {
-                FTIFF_dbvar* currentdbVar = &(currentDB->dbvars[varIdx]);
-                currentdbVar->hasCkpt = true;
-                currentdbVar->update = false;
+        if ( FTI_Conf.ioMode == FTI_IO_FTIFF ) {
+            FTIFF_db* currentDB = FTI_Exec.firstdb;
+            currentDB->update = false;
+            do {    
+                int varIdx;
+                for(varIdx=0; varIdx<currentDB->numvars; ++varIdx) {
+                    FTIFF_dbvar* currentdbVar = &(currentDB->dbvars[varIdx]);
+                    currentdbVar->hasCkpt = true;
+                    currentdbVar->update = false;
+                }
             }
+            while ( (currentDB = currentDB->next) != NULL );    
         }
-        while ( (currentDB = currentDB->next) != NULL );    
-        
     
         FTI_UpdateDcpChanges(FTI_Data, &FTI_Exec);
         FTI_Ckpt[4].hasDcp = true;
     }
 
-    // FTIFF: send meta info to the heads
-    FTIFF_headInfo *headInfo;
-    if (!FTI_Ckpt[FTI_Exec.ckptLvel].isInline) { // If postCkpt. work is Async. then send message
-        FTI_Exec.wasLastOffline = 1;
+    if (FTI_Exec.postAsync) { // If postCkpt. work is Async. then send message
         // Head needs ckpt. ID to determine ckpt file name.
         int value = FTI_BASE + FTI_Exec.ckptLvel; //Token to send to head
         if (res != FTI_SCES) { //If Writing checkpoint failed
             FTI_Exec.ckptLvel = lastCkptLvel; //Set previous ckptLvel
             value = FTI_REJW; //Send reject checkpoint token to head
         }
-        MPI_Send(&value, 1, MPI_INT, FTI_Topo.headRank, FTI_Conf.ckptTag, FTI_Exec.globalComm);
-        // FTIFF: send meta info to the heads
-        if( FTI_Conf.ioMode == FTI_IO_FTIFF && value != FTI_REJW ) {
-            headInfo = malloc(sizeof(FTIFF_headInfo));
-            headInfo->exists = FTI_Exec.meta[0].exists[0];
-            headInfo->nbVar = FTI_Exec.meta[0].nbVar[0];
-            headInfo->maxFs = FTI_Exec.meta[0].maxFs[0];
-            headInfo->fs = FTI_Exec.meta[0].fs[0];
-            headInfo->pfs = FTI_Exec.meta[0].pfs[0];
-            headInfo->isDcp = (FTI_Ckpt[4].isDcp) ? 1 : 0;
-            if( FTI_Conf.dcpEnabled && FTI_Ckpt[4].isDcp ) {
-                strncpy(headInfo->ckptFile, FTI_Ckpt[4].dcpName, FTI_BUFS);
-            } else {
-                strncpy(headInfo->ckptFile, FTI_Exec.meta[0].ckptFile, FTI_BUFS);
-            }            
-	    MPI_Send(headInfo, 1, FTIFF_MpiTypes[FTIFF_HEAD_INFO], FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            MPI_Send(FTI_Exec.meta[0].varID, headInfo->nbVar, MPI_INT, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            MPI_Send(FTI_Exec.meta[0].varSize, headInfo->nbVar, MPI_LONG, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            free(headInfo);
-        }
-
+        FTI_SendCkptRequest(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, value);
     }
     else { //If post-processing is inline
-        FTI_Exec.wasLastOffline = 0;
         if (res != FTI_SCES) { //If Writing checkpoint failed
             FTI_Exec.ckptLvel = FTI_REJW - FTI_BASE; //The same as head call FTI_PostCkpt with reject ckptLvel if not success
         }
@@ -1500,14 +1489,25 @@ int FTI_InitICP(int id, int level, bool activate)
     if ( !activate ) {
         return FTI_SCES;
     }
+
+    // a checkpoint ends the recovery phase of FTI_RecoverVar
+    FTI_FinalizeRecoverVar();
    
     // reset iCP meta info (i.e. set counter to zero etc.)
+    free( FTI_Exec.iCPInfo.isWritten );
     memset( &(FTI_Exec.iCPInfo), 0x0, sizeof(FTIT_iCPInfo) );
 
     // init iCP status with failure
     FTI_Exec.iCPInfo.status = FTI_ICP_FAIL;
     FTI_Exec.iCPInfo.result = FTI_NSCS;
 
+    FTI_Exec.iCPInfo.nbVar = FTI_Exec.nbVar;
+    FTI_Exec.iCPInfo.isWritten = (bool*) calloc( FTI_Exec.nbVar + 1, sizeof(bool) );
+    if ( FTI_Exec.iCPInfo.isWritten == NULL ) {
+        FTI_Print("FTI_InitICP: unable to allocate memory for the iCP meta info.", FTI_EROR);
+        return FTI_NSCS;
+    }
+
     int res = FTI_NSCS;
     
     char str[FTI_BUFS]; //For console output
@@ -1541,25 +1541,17 @@ int FTI_InitICP(int id, int level, bool activate)
                 FTI_Print("L4 dCP requested, but dCP is disabled!", FTI_WARN);
             }
         } else {
-            FTI_Print("L4 dCP requested, but dCP needs FTI-FF!", FTI_WARN);
+            FTI_Print("L4 dCP requested, but dCP with iCP needs FTI-FF!", FTI_WARN);
         }
         level = 4;
     }
 
     FTI_Exec.iCPInfo.t0 = MPI_Wtime(); //Start time
-    if (FTI_Exec.wasLastOffline == 1) { // Block until previous checkpoint is done (Async. work)
-        int lastLevel;
-        MPI_Recv(&lastLevel, 1, MPI_INT, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm, MPI_STATUS_IGNORE);
-        if (lastLevel != FTI_NSCS) { //Head sends level of checkpoint if post-processing succeed, FTI_NSCS Otherwise
-            FTI_Exec.lastCkptLvel = lastLevel; //Store last successful post-processing checkpoint level
-            sprintf(str, "LastCkptLvel received from head: %d", lastLevel);
-            FTI_Print(str, FTI_DBUG);
-        } else {
-            FTI_Print("Head failed to do post-processing after previous checkpoint.", FTI_WARN);
-        }
-    }
+    // Block only if too many checkpoints are in flight (Async. work)
+    FTI_PrepareCkptGen(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, level);
 
     FTI_Exec.iCPInfo.t1 = MPI_Wtime(); //Time after waiting for head to done previous post-processing
+    FTI_StatsStop(FTI_STAT_WAIT, level, FTI_Exec.iCPInfo.t0, 0);
     FTI_Exec.iCPInfo.lastCkptLvel = FTI_Exec.ckptLvel; //Store last successful writing checkpoint level in case of failure
     FTI_Exec.ckptLvel = level; //For FTI_WriteCkpt
 
@@ -1683,30 +1675,23 @@ int FTI_AddVarICP( int varID )
 
     char str[FTI_BUFS];
 
-    bool validID = false;
-    
-    int i;
     // check if dataset with 'varID' exists.
-    for(i=0; i<FTI_Exec.nbVar; ++i) {
-        validID |= (FTI_Data[i].id == varID);
-    }
-    if( !validID ) {
+    int idx = FTI_GetDatasetIdx(varID);
+    if( idx == -1 || idx >= FTI_Exec.iCPInfo.nbVar ) {
         snprintf( str, FTI_BUFS, "FTI_AddVarICP: dataset ID: %d is invalid!", varID );
         FTI_Print(str, FTI_WARN);
         return FTI_NSCS;
     }
     
     // check if dataset was not already written.
-    for(i=0; i<FTI_Exec.iCPInfo.countVar; ++i) {
-        validID &= !(FTI_Exec.iCPInfo.isWritten[i] == varID);
-    }
-    if( !validID ) {
+    if( FTI_Exec.iCPInfo.isWritten[idx] ) {
         snprintf( str, FTI_BUFS, "Dataset with ID: %d was already successfully written!", varID );
         FTI_Print(str, FTI_WARN);
         return FTI_NSCS;
     }
     
     int res;
+    double ts = FTI_StatsStart();
 
     switch (FTI_Conf.ioMode) {
 #ifdef ENABLE_SIONLIB //If SIONlib is installed
@@ -1739,8 +1724,11 @@ int FTI_AddVarICP( int varID )
 #endif
     }
 
+    FTI_StatsStop(FTI_STAT_WRITE, FTI_Exec.ckptLvel, ts, FTI_Data[idx].size);
+
     if ( res == FTI_SCES ) {
-        FTI_Exec.iCPInfo.isWritten[FTI_Exec.iCPInfo.countVar++] = varID;
+        FTI_Exec.iCPInfo.isWritten[idx] = true;
+        FTI_Exec.iCPInfo.countVar++;
     }
 
     return res;
@@ -1772,7 +1760,9 @@ int FTI_FinalizeICP()
     int allRes[2];
     int locRes[2] = { (int)(FTI_Exec.iCPInfo.result==FTI_SCES), (int)(FTI_Exec.iCPInfo.countVar==FTI_Exec.nbVar) };
     //Check if all processes have written all the datasets failure free.
+    double ts = FTI_StatsStart();
     MPI_Allreduce(locRes, allRes, 2, MPI_INT, MPI_SUM, FTI_COMM_WORLD);
+    FTI_StatsStop(FTI_STAT_SYNC, FTI_Exec.ckptLvel, ts, 0);
     if (allRes[0] != FTI_Topo.nbNodes*FTI_Topo.nbApprocs) {
         FTI_Exec.iCPInfo.status = FTI_ICP_FAIL;
         FTI_Print("Not all variables were successfully written!.", FTI_EROR);
@@ -1787,6 +1777,7 @@ int FTI_FinalizeICP()
     int resPP;
     
     // Close files for each I/O
+    ts = FTI_StatsStart();
     switch (FTI_Conf.ioMode) {
 #ifdef ENABLE_SIONLIB //If SIONlib is installed
         case FTI_IO_SIONLIB:
@@ -1818,8 +1809,12 @@ int FTI_FinalizeICP()
 #endif
     }
     
+    FTI_StatsStop(FTI_STAT_WRITE, FTI_Exec.ckptLvel, ts, 0);
+
     if( resCP == FTI_SCES ) {
+        ts = FTI_StatsStart();
         resCP = FTI_Try(FTI_CreateMetadata(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, FTI_Data), "create metadata.");
+        FTI_StatsStop(FTI_STAT_META, FTI_Exec.ckptLvel, ts, 0);
     }
 
     if ( resCP != FTI_SCES ) {
@@ -1866,40 +1861,16 @@ int FTI_FinalizeICP()
         FTI_Ckpt[4].hasDcp = true;
     }
 
-    // FTIFF: send meta info to the heads
-    FTIFF_headInfo *headInfo;
-    if (!FTI_Ckpt[FTI_Exec.ckptLvel].isInline) { // If postCkpt. work is Async. then send message
-        FTI_Exec.wasLastOffline = 1;
+    if (FTI_Exec.postAsync) { // If postCkpt. work is Async. then send message
         // Head needs ckpt. ID to determine ckpt file name.
         int value = FTI_BASE + FTI_Exec.ckptLvel; //Token to send to head
         if (FTI_Exec.iCPInfo.status == FTI_ICP_FAIL) { //If Writing checkpoint failed
             FTI_Exec.ckptLvel = FTI_Exec.iCPInfo.lastCkptLvel; //Set previous ckptLvel
             value = FTI_REJW; //Send reject checkpoint token to head
         }
-        MPI_Send(&value, 1, MPI_INT, FTI_Topo.headRank, FTI_Conf.ckptTag, FTI_Exec.globalComm);
-        // FTIFF: send meta info to the heads
-        if( FTI_Conf.ioMode == FTI_IO_FTIFF && value != FTI_REJW ) {
-            headInfo = malloc(sizeof(FTIFF_headInfo));
-            headInfo->exists = FTI_Exec.meta[0].exists[0];
-            headInfo->nbVar = FTI_Exec.meta[0].nbVar[0];
-            headInfo->maxFs = FTI_Exec.meta[0].maxFs[0];
-            headInfo->fs = FTI_Exec.meta[0].fs[0];
-            headInfo->pfs = FTI_Exec.meta[0].pfs[0];
-            headInfo->isDcp = (FTI_Ckpt[4].isDcp) ? 1 : 0;
-            if( FTI_Conf.dcpEnabled && FTI_Ckpt[4].isDcp ) {
-                strncpy(headInfo->ckptFile, FTI_Ckpt[4].dcpName, FTI_BUFS);
-            } else {
-                strncpy(headInfo->ckptFile, FTI_Exec.meta[0].ckptFile, FTI_BUFS);
-            }            
-            MPI_Send(headInfo, 1, FTIFF_MpiTypes[FTIFF_HEAD_INFO], FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            MPI_Send(FTI_Exec.meta[0].varID, headInfo->nbVar, MPI_INT, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            MPI_Send(FTI_Exec.meta[0].varSize, headInfo->nbVar, MPI_LONG, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm);
-            free(headInfo);
-        }
-
+        FTI_SendCkptRequest(&FTI_Conf, &FTI_Exec, &FTI_Topo, FTI_Ckpt, value);
     }
     else { //If post-processing is inline
-        FTI_Exec.wasLastOffline = 0;
         if (FTI_Exec.iCPInfo.status == FTI_ICP_FAIL) { //If Writing checkpoint failed
             FTI_Exec.ckptLvel = FTI_REJW - FTI_BASE; //The same as head call FTI_PostCkpt with reject ckptLvel if not success
         }
@@ -1973,10 +1944,34 @@ int FTI_FinalizeICP()
     }
 
     FTI_Exec.iCPInfo.status = FTI_ICP_NINI;
+    free( FTI_Exec.iCPInfo.isWritten );
+    FTI_Exec.iCPInfo.isWritten = NULL;
 
     return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It returns the checkpoint statistics of the process.
+  @param      stats           Stats to fill.
+  @return     integer         FTI_SCES if successful.
+
+  This function copies the time and data volume of each checkpoint phase
+  (FTI_STAT_*), per level, accumulated by this process since FTI_Init.
+  The stats are only collected if Advanced:stats is set, otherwise
+  FTI_NSCS is returned.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_GetStats(FTIT_stats* stats)
+{
+    if (FTI_Exec.initSCES == 0) {
+        FTI_Print("FTI is not initialized.", FTI_WARN);
+        return FTI_NSCS;
+    }
+    return FTI_CopyStats(stats);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It loads the checkpoint data.
@@ -1989,8 +1984,15 @@ int FTI_FinalizeICP()
 /*-------------------------------------------------------------------------*/
 int FTI_Recover()
 {
+    // the whole checkpoint is read, no need to keep the file mapped
+    FTI_FinalizeRecoverVar();
+
+    double ts = FTI_StatsStart();
     if ( FTI_Conf.ioMode == FTI_IO_FTIFF ) {
         int ret = FTI_Try(FTIFF_Recover( &FTI_Exec, FTI_Data, FTI_Ckpt ), "Recovering from Checkpoint");
+        if (ret == FTI_SCES) {
+            FTI_StatsStop(FTI_STAT_RECOVER, FTI_Exec.ckptLvel, ts, FTI_Exec.ckptSize);
+        }
         return ret;
     }
 
@@ -2040,6 +2042,9 @@ int FTI_Recover()
 #ifdef ENABLE_HDF5 //If HDF5 is installed
     if (FTI_Conf.ioMode == FTI_IO_HDF5) {
         int ret = FTI_RecoverHDF5(&FTI_Conf, &FTI_Exec, FTI_Ckpt, FTI_Data);
+        if (ret == FTI_SCES) {
+            FTI_StatsStop(FTI_STAT_RECOVER, FTI_Exec.ckptLvel, ts, FTI_Exec.ckptSize);
+        }
         return ret; 
     }
 #endif
@@ -2095,6 +2100,7 @@ int FTI_Recover()
     return FTI_NREC;
   }
 
+  FTI_StatsStop(FTI_STAT_RECOVER, FTI_Exec.ckptLvel, ts, FTI_Exec.ckptSize);
   FTI_Exec.reco = 0;
 
   return FTI_SCES;
@@ -2187,7 +2193,17 @@ int FTI_Finalize()
     }
 
     if (FTI_Topo.amIaHead) {
+        FTI_FinalizeStats(&FTI_Conf, &FTI_Topo);
         FTI_FreeMeta(&FTI_Exec);
+        FTI_FreeThreadPool();
+        FTI_FreePtnerDelta();
+        if (FTI_Conf.mpiioInfo != MPI_INFO_NULL) {
+            MPI_Info_free(&FTI_Conf.mpiioInfo);
+        }
+        FTI_FreeChunkTypes();
+        FTI_FreeDatasetRegistry();
+        free(FTI_Data);
+        FTI_Data = NULL;
         if ( FTI_Conf.stagingEnabled ) {
             FTI_FinalizeStage( &FTI_Exec, &FTI_Topo, &FTI_Conf );
         }
@@ -2202,16 +2218,11 @@ int FTI_Finalize()
 
     // Notice: The following code is only executed by the application procs
 
+    FTI_FinalizeRecoverVar();
     FTI_Try(FTI_DestroyDevices(), "Destroying accelerator allocated memory");
 
-    // If there is remaining work to do for last checkpoint
-    if (FTI_Exec.wasLastOffline == 1) {
-        int lastLevel;
-        MPI_Recv(&lastLevel, 1, MPI_INT, FTI_Topo.headRank, FTI_Conf.generalTag, FTI_Exec.globalComm, MPI_STATUS_IGNORE);
-        if (lastLevel != FTI_NSCS) { //Head sends level of checkpoint if post-processing succeed, FTI_NSCS Otherwise
-            FTI_Exec.lastCkptLvel = lastLevel;
-        }
-    }
+    // If there is remaining work to do for the last checkpoints
+    FTI_FinalizeCkptRequests(&FTI_Conf, &FTI_Exec, &FTI_Topo);
 
     // Send notice to the head to stop listening
     if (FTI_Topo.nbHeads == 1) {
@@ -2275,11 +2286,18 @@ int FTI_Finalize()
     }
     
     if (FTI_Conf.dcpEnabled) {
-        FTI_FinalizeDcp( &FTI_Conf, &FTI_Exec );
+        FTI_FinalizeDcp( &FTI_Conf, &FTI_Exec, FTI_Data );
     }
 
+    FTI_FinalizeStats(&FTI_Conf, &FTI_Topo);
     FTI_FreeMeta(&FTI_Exec);
     FTI_FreeTypesAndGroups(&FTI_Exec);
+    FTI_FreeThreadPool();
+    FTI_FreePtnerDelta();
+    if (FTI_Conf.mpiioInfo != MPI_INFO_NULL) {
+        MPI_Info_free(&FTI_Conf.mpiioInfo);
+    }
+    FTI_FreeChunkTypes();
     if( FTI_Conf.ioMode == FTI_IO_FTIFF ) {
         FTIFF_FreeDbFTIFF(FTI_Exec.lastdb);
     }
@@ -2288,6 +2306,9 @@ int FTI_Finalize()
        FTI_FreeVPRMem( &FTI_Exec, FTI_Data ); 
     }
 #endif
+    FTI_FreeDatasetRegistry();
+    free(FTI_Data);
+    FTI_Data = NULL;
     MPI_Barrier(FTI_Exec.globalComm);
     FTI_Print("FTI has been finalized.", FTI_INFO);
     return FTI_SCES;
@@ -2302,11 +2323,9 @@ int FTI_Finalize()
   During a restart process, this function recovers the variable specified
   by the given id. No effect during a regular execution.
   The variable must have already been protected, otherwise, FTI_NSCS is returned.
-  Improvements to be done:
-  - Open checkpoint file at FTI_Init, close it at FTI_Snapshot
-  - Maintain a variable accumulating the offset as variable are protected during
-  the restart to avoid doing the loop to calculate the offset in the
-  checkpoint file.
+  The checkpoint file is mapped at the first call and stays mapped, with
+  the offsets of all variables, until the recovery phase ends (see
+  FTI_InitRecoverVar).
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_RecoverVar(int id)
@@ -2333,19 +2352,20 @@ int FTI_RecoverVar(int id)
         return FTI_NSCS;
     }
 
+    int idx = FTI_GetDatasetIdx(id);
+    if (idx < 0) {
+        FTI_Print("Variables must be protected before they can be recovered.", FTI_EROR);
+        return FTI_NREC;
+    }
+
     //Check if sizes of protected variables matches
-    int i;
-    for (i = 0; i < FTI_Exec.nbVar; i++) {
-        if (id == FTI_Exec.meta[FTI_Exec.ckptLvel].varID[i]) {
-            if (FTI_Data[i].size != FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i]) {
-                char str[FTI_BUFS];
-                sprintf(str, "Cannot recover %ld bytes to protected variable (ID %d) size: %ld",
-                        FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i], FTI_Exec.meta[FTI_Exec.ckptLvel].varID[i],
-                        FTI_Data[i].size);
-                FTI_Print(str, FTI_WARN);
-                return FTI_NREC;
-            }
-        }
+    int i = FTI_GetMetaVarIdx(&FTI_Exec, FTI_Exec.ckptLvel, id);
+    if (i >= 0 && FTI_Data[idx].size != FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i]) {
+        char str[FTI_BUFS];
+        sprintf(str, "Cannot recover %ld bytes to protected variable (ID %d) size: %ld",
+                FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i], id, FTI_Data[idx].size);
+        FTI_Print(str, FTI_WARN);
+        return FTI_NREC;
     }
 
 #ifdef ENABLE_HDF5 //If HDF5 is installed
@@ -2354,55 +2374,13 @@ int FTI_RecoverVar(int id)
     }
 #endif
 
-    char fn[FTI_BUFS]; //Path to the checkpoint file
-
-    //Recovering from local for L4 case in FTI_Recover
-    if (FTI_Exec.ckptLvel == 4) {
-        snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[1].dir, FTI_Exec.meta[1].ckptFile);
-    }
-    else {
-        snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[FTI_Exec.ckptLvel].dir, FTI_Exec.meta[FTI_Exec.ckptLvel].ckptFile);
-    }
-
-    char str[FTI_BUFS];
-
-    sprintf(str, "Trying to load FTI checkpoint file (%s)...", fn);
-    FTI_Print(str, FTI_DBUG);
-
-    FILE* fd = fopen(fn, "rb");
-    if (fd == NULL) {
-        FTI_Print("Could not open FTI checkpoint file.", FTI_EROR);
-        return FTI_NREC;
-    }
-
-    long offset = 0;
-    for (i = 0; i < FTI_Exec.nbVar; i++) {
-        if (id == FTI_Exec.meta[FTI_Exec.ckptLvel].varID[i]) {
-            sprintf(str, "Recovering var %d ", id);
-            FTI_Print(str, FTI_DBUG);
-            fseek(fd, offset, SEEK_SET);
-            fread(FTI_Data[i].ptr, 1, FTI_Data[i].size, fd);
-            if (ferror(fd)) {
-                FTI_Print("Could not read FTI checkpoint file.", FTI_EROR);
-                fclose(fd);
-                return FTI_NREC;
-            }
-            break;
-        }
-        offset += FTI_Exec.meta[FTI_Exec.ckptLvel].varSize[i];
-    }
-
-    if (i == FTI_Exec.nbVar) {
-        FTI_Print("Variables must be protected before they can be recovered.", FTI_EROR);
-        fclose(fd);
-        return FTI_NREC;
-    }
-    if (fclose(fd) != 0) {
-        FTI_Print("Could not close FTI checkpoint file.", FTI_EROR);
-        return FTI_NREC;
+    // the checkpoint file is mapped once for all variables
+    int res = FTI_InitRecoverVar(&FTI_Conf, &FTI_Exec, FTI_Ckpt);
+    if (res != FTI_SCES) {
+        return res;
     }
 
-    return FTI_SCES;
+    return FTI_RecoverVarMapped(&FTI_Exec, &FTI_Data[idx]);
 }
 
 /*-------------------------------------------------------------------------*/
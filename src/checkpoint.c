@@ -41,6 +41,7 @@
 #endif
 
 #include <string.h>
+#include <sys/statvfs.h>
 
 #include "interface.h"
 #include "ftiff.h"
@@ -135,6 +136,9 @@ int FTI_WriteCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     snprintf(FTI_Exec->meta[0].ckptFile, FTI_BUFS,
             "Ckpt%d-Rank%d.fti", FTI_Exec->ckptID, FTI_Topo->myRank);
 
+    //set by the I/O functions that compute the checksum while writing
+    FTI_Exec->integrity[0] = '\0';
+
 #ifdef ENABLE_HDF5 //If HDF5 is installed overwrite the name
     if (FTI_Conf->ioMode == FTI_IO_HDF5) {
         snprintf(FTI_Exec->meta[0].ckptFile, FTI_BUFS,
@@ -144,6 +148,7 @@ int FTI_WriteCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     
     //If checkpoint is inlin and level 4 save directly to PFS
     int res; //response from writing funcitons
+    double ts = FTI_StatsStart();
     if (FTI_Ckpt[4].isInline && FTI_Exec->ckptLvel == 4) {
         
         if ( !(FTI_Conf->dcpEnabled && FTI_Ckpt[4].isDcp) ) {
@@ -169,9 +174,17 @@ int FTI_WriteCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
         switch (FTI_Conf->ioMode) {
             case FTI_IO_POSIX:
+                if ( FTI_Conf->dcpEnabled && FTI_Ckpt[4].isDcp ) {
+                    res = FTI_Try(FTI_WritePosixDcp(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt, FTI_Data), "update dCP file in PFS (POSIX I/O).");
+                    break;
+                }
                 res = FTI_Try(FTI_WritePosix(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt, FTI_Data), "write checkpoint to PFS (POSIX I/O).");
                 break;
             case FTI_IO_MPI:
+                if ( FTI_Conf->dcpEnabled && FTI_Ckpt[4].isDcp ) {
+                    res = FTI_Try(FTI_WriteMPIDcp(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt, FTI_Data), "update dCP file in PFS (MPI-IO).");
+                    break;
+                }
                 res = FTI_Try(FTI_WriteMPI(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Data), "write checkpoint to PFS (MPI-IO).");
                 break;
 #ifdef ENABLE_SIONLIB //If SIONlib is installed
@@ -225,9 +238,14 @@ int FTI_WriteCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     }
 
+    long written = (FTI_Conf->dcpEnabled && FTI_Ckpt[4].isDcp) ? FTI_Exec->FTIFFMeta.dcpSize : FTI_Exec->ckptSize;
+    FTI_StatsStop(FTI_STAT_WRITE, FTI_Exec->ckptLvel, ts, written);
+
     //Check if all processes have written correctly (every process must succeed)
     int allRes;
+    ts = FTI_StatsStart();
     MPI_Allreduce(&res, &allRes, 1, MPI_INT, MPI_SUM, FTI_COMM_WORLD);
+    FTI_StatsStop(FTI_STAT_SYNC, FTI_Exec->ckptLvel, ts, 0);
     if (allRes != FTI_SCES) {
         return FTI_NSCS;
     }
@@ -242,7 +260,9 @@ int FTI_WriteCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
 
+    ts = FTI_StatsStart();
     res = FTI_Try(FTI_CreateMetadata(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt, FTI_Data), "create metadata.");
+    FTI_StatsStop(FTI_STAT_META, FTI_Exec->ckptLvel, ts, 0);
     
     if ( (FTI_Conf->dcpEnabled || FTI_Conf->keepL4Ckpt) && (FTI_Topo->splitRank == 0) ) {
         FTI_WriteCkptMetaData( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt );
@@ -302,6 +322,14 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     double t2 = MPI_Wtime(); //Post-processing time
 
+    unsigned long long bytes = 0; //ckpt. data handled by this process
+    int i;
+    for (i = (FTI_Topo->amIaHead) ? 1 : 0; i < ((FTI_Topo->amIaHead) ? FTI_Topo->nodeSize : 1); i++) {
+        bytes += FTI_Exec->meta[0].fs[i];
+    }
+    bool moved = (FTI_Exec->ckptLvel > 1) && !(FTI_Exec->ckptLvel == 4 && FTI_Ckpt[4].isInline);
+    FTI_StatsStop(FTI_STAT_POST, FTI_Exec->ckptLvel, t1, (moved) ? bytes : 0);
+
     // rename l4 checkpoint file before deleting l4 folder if keepL4Ckpt enabled
     if ( FTI_Conf->keepL4Ckpt && FTI_Exec->ckptLvel == 4 ) {
         if ( FTI_Ckpt[4].hasCkpt ) {
@@ -319,8 +347,10 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     }
 
     FTI_Clean(FTI_Conf, FTI_Topo, FTI_Ckpt, FTI_Exec->ckptLvel); //delete previous files on this checkpoint level
+    // the metadata of a FTI-FF dCP file is stored in the file, the other I/O modes keep the meta directory
+    bool dcpFTIFF = FTI_Ckpt[4].isDcp && (FTI_Conf->ioMode == FTI_IO_FTIFF);
     int nodeFlag = (((!FTI_Topo->amIaHead) && ((FTI_Topo->nodeRank - FTI_Topo->nbHeads) == 0)) || (FTI_Topo->amIaHead)) ? 1 : 0;
-    nodeFlag = (!FTI_Ckpt[4].isDcp && (nodeFlag != 0));
+    nodeFlag = (!dcpFTIFF && (nodeFlag != 0));
     if (nodeFlag) { //True only for one process in the node.
         //Debug message needed to test nodeFlag (./tests/nodeFlag/nodeFlag.c)
         snprintf(str, FTI_BUFS, "Has nodeFlag = 1 and nodeID = %d. CkptLvel = %d.", FTI_Topo->nodeID, FTI_Exec->ckptLvel);
@@ -339,9 +369,9 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
     int globalFlag = !FTI_Topo->splitRank;
-    globalFlag = (!FTI_Ckpt[4].isDcp && (globalFlag != 0));
+    globalFlag = (!dcpFTIFF && (globalFlag != 0));
     if (globalFlag) { //True only for one process in the FTI_COMM_WORLD.
-        if (FTI_Exec->ckptLvel == 4) {
+        if (FTI_Exec->ckptLvel == 4 && !FTI_Ckpt[4].isDcp) { //dCP files are updated in place
             if (rename(FTI_Conf->gTmpDir, FTI_Ckpt[4].dir) == -1) {
                 FTI_Print("Cannot rename global directory", FTI_EROR);
             }
@@ -356,6 +386,7 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     MPI_Barrier(FTI_COMM_WORLD); //barrier needed to wait for process to rename directories (new temporary could be needed in next checkpoint)
 
     double t3 = MPI_Wtime(); //Renaming directories time
+    FTI_StatsStop(FTI_STAT_CLEAN, FTI_Exec->ckptLvel, t2, 0);
 
     snprintf(str, FTI_BUFS, "Post-checkpoint took %.2f sec. (Pt:%.2fs, Cl:%.2fs)",
             t3 - t1, t2 - t1, t3 - t2);
@@ -367,6 +398,75 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It returns the CPU time consumed by the process.
+  @return     double          CPU time in seconds.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static double FTI_CpuTime()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It lets the head sleep between two polls.
+  @param      FTI_Conf        Configuration metadata.
+  @param      pollUs          Current sleep time in microseconds.
+
+  The sleep time doubles at each unsuccessful poll, from FTI_HEAD_POLL_MIN
+  to Advanced:head_poll_max microseconds. It is reset by the caller once
+  a request arrives. With head_poll_max = 0, the head polls without
+  sleeping.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_HeadBackoff(FTIT_configuration* FTI_Conf, long* pollUs)
+{
+    if (FTI_Conf->headPollMax <= 0) {
+        return;
+    }
+    *pollUs = (*pollUs == 0) ? FTI_HEAD_POLL_MIN : *pollUs * 2;
+    if (*pollUs > FTI_Conf->headPollMax) {
+        *pollUs = FTI_Conf->headPollMax;
+    }
+    struct timespec ts = { *pollUs / 1000000, (*pollUs % 1000000) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It serves a pending checkpoint request (if head).
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @return     integer         1 if a request was served, 0 otherwise.
+
+  Called by the head between the chunks of long running work (e.g.
+  staging) so that checkpoint requests do not wait until the work is
+  completed.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_HeadPreempt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt)
+{
+    int ckpt_flag = 0;
+    MPI_Iprobe( MPI_ANY_SOURCE, FTI_Conf->ckptTag, FTI_Exec->globalComm, &ckpt_flag, MPI_STATUS_IGNORE );
+    if ( ckpt_flag ) {
+        FTI_Print("Head interrupts its work for a checkpoint request.", FTI_DBUG);
+        FTI_HandleCkptRequest( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt );
+    }
+    return ckpt_flag;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It listens for checkpoint notifications.
@@ -378,7 +478,9 @@ int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   This function listens for notifications from the application processes
   and takes the required actions after notification. This function is only
   executed by the head of the nodes and its complementary with the
-  FTI_Checkpoint function in terms of communications.
+  FTI_Checkpoint function in terms of communications. While no request is
+  pending the head backs off (see FTI_HeadBackoff) instead of spinning, the
+  time and CPU time spent waiting are reported at finalization.
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_Listen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
@@ -389,33 +491,57 @@ int FTI_Listen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     MPI_Status stage_status;        int stage_flag = 0;
     MPI_Status finalize_status;     int finalize_flag = 0;
 
+    long pollUs = 0;                // current backoff
+    bool idle = false;              // TRUE while no request is pending
+    double idleStart = 0, idleCpuStart = 0;
+    double idleTime = 0, idleCpu = 0;
+    unsigned long nbRequests = 0;
+
     FTI_Print("Head starts listening...", FTI_DBUG);
     while (1) { //heads can stop only by receiving FTI_ENDW
 
-        FTI_Print("Head waits for message...", FTI_DBUG);
-
         MPI_Iprobe( MPI_ANY_SOURCE, FTI_Conf->finalTag, FTI_Exec->globalComm, &finalize_flag, &finalize_status );
         if ( FTI_Conf->stagingEnabled ) {
             MPI_Iprobe( MPI_ANY_SOURCE, FTI_Conf->stageTag, FTI_Exec->nodeComm, &stage_flag, &stage_status );
         }
         MPI_Iprobe( MPI_ANY_SOURCE, FTI_Conf->ckptTag, FTI_Exec->globalComm, &ckpt_flag, &ckpt_status );
+
+        if ( !ckpt_flag && !stage_flag && !finalize_flag ) {
+            if ( !idle ) {
+                FTI_Print("Head waits for message...", FTI_DBUG);
+                idle = true;
+                idleStart = MPI_Wtime();
+                idleCpuStart = FTI_CpuTime();
+            }
+            FTI_HeadBackoff( FTI_Conf, &pollUs );
+            continue;
+        }
+        if ( idle ) {
+            idleTime += MPI_Wtime() - idleStart;
+            idleCpu += FTI_CpuTime() - idleCpuStart;
+            idle = false;
+        }
+        pollUs = 0;
+
         if( ckpt_flag ) {
 
             // head will process the whole checkpoint
             // (treated second due to priority)
             FTI_HandleCkptRequest( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt ); 
             ckpt_flag = 0;
+            nbRequests++;
             continue;
 
         } 
 
         if ( stage_flag ) {
             
-            // head will process each unstage request on its own
-            // [A MAYBE: we could interrupt the unstageing process if 
-            // we receive a checkpoint request.]
+            // head will process each unstage request on its own,
+            // checkpoint requests are served in between the chunks
+            // (see FTI_HeadPreempt).
             FTI_HandleStageRequest( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt, stage_status.MPI_SOURCE );
             stage_flag = 0;
+            nbRequests++;
             continue;
 
         } 
@@ -442,6 +568,10 @@ int FTI_Listen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                 FTI_Print( "Inconsistency in Finalize request.", FTI_WARN );
             }
             
+            snprintf(str, FTI_BUFS, "Head served %lu requests, idle for %.2f sec. using %.2f sec. of CPU (%.1f%%).",
+                    nbRequests, idleTime, idleCpu, (idleTime > 0) ? 100 * idleCpu / idleTime : 0);
+            FTI_Print(str, (FTI_Topo->splitRank == 0) ? FTI_INFO : FTI_DBUG);
+
             FTI_Print("Head stopped listening.", FTI_DBUG);
             FTI_Finalize();
 
@@ -478,6 +608,8 @@ int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
     for (i = 0; i < 7; i++) { // Initialize flags
         flags[i] = 0;
     }
+    // the requests are served in order, the application processes count them the same way
+    FTI_SetTmpDirs(FTI_Conf, FTI_Exec->asyncSent++ % FTI_Conf->asyncDepth);
     FTI_Print("Head waits for message...", FTI_DBUG);
     for (i = 0; i < FTI_Topo->nbApprocs; i++) { // Iterate on the application processes in the node
         int buf;
@@ -504,6 +636,7 @@ int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
         headInfo = malloc(FTI_Topo->nbApprocs * sizeof(FTIFF_headInfo));
 
         int k;
+        bool metaFail = false;
         for (i = 0; i < FTI_Topo->nbApprocs; i++) { // Iterate on the application processes in the node
             k = i+1;
             MPI_Recv(&(headInfo[i]), 1, FTIFF_MpiTypes[FTIFF_HEAD_INFO], FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
@@ -513,8 +646,18 @@ int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
             FTI_Exec->meta[0].fs[k] = headInfo[i].fs;
             FTI_Exec->meta[0].pfs[k] = headInfo[i].pfs;
             isDcpCnt += headInfo[i].isDcp;
-            MPI_Recv(&(FTI_Exec->meta[0].varID[k * FTI_BUFS]), headInfo[i].nbVar, MPI_INT, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
-            MPI_Recv(&(FTI_Exec->meta[0].varSize[k * FTI_BUFS]), headInfo[i].nbVar, MPI_LONG, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
+            if (FTI_ReallocMetaVars(FTI_Exec, FTI_Topo->nodeSize, headInfo[i].nbVar) != FTI_SCES) {
+                // the messages are received anyway, the checkpoint is rejected
+                FTI_Print("Unable to store the variables metadata, discarding checkpoint.", FTI_EROR);
+                metaFail = true;
+                void* discard = malloc(headInfo[i].nbVar * sizeof(long));
+                MPI_Recv(discard, headInfo[i].nbVar, MPI_INT, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
+                MPI_Recv(discard, headInfo[i].nbVar, MPI_LONG, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
+                free(discard);
+                continue;
+            }
+            MPI_Recv(&(FTI_Exec->meta[0].varID[k * FTI_Exec->nbVarMax]), headInfo[i].nbVar, MPI_INT, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
+            MPI_Recv(&(FTI_Exec->meta[0].varSize[k * FTI_Exec->nbVarMax]), headInfo[i].nbVar, MPI_LONG, FTI_Topo->body[i], FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
             strncpy(&(FTI_Exec->meta[0].ckptFile[k * FTI_BUFS]), headInfo[i].ckptFile , FTI_BUFS);
             sscanf(&(FTI_Exec->meta[0].ckptFile[k * FTI_BUFS]), "Ckpt%d", &FTI_Exec->ckptID);
         }
@@ -530,6 +673,10 @@ int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
 
         free(headInfo);
 
+        if ( metaFail ) {
+            FTI_Exec->ckptLvel = 6;
+        }
+
     }
 
     //Check if checkpoint was written correctly by all processes
@@ -559,6 +706,248 @@ int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
     return FTI_SCES;
 }
 
+/** @typedef    FTIT_ckptRequest
+ *  @brief      Checkpoint request sent to the head.
+ *
+ *  The messages of a request are sent non-blocking, so that the application
+ *  does not wait for the head to finish the previous requests. The buffers
+ *  are kept until the head answers the request.
+ */
+typedef struct FTIT_ckptRequest {
+    int             value;              /**< Level token or FTI_REJW.       */
+    FTIFF_headInfo  headInfo;           /**< FTI-FF meta info.              */
+    int*            varID;              /**< FTI-FF variable IDs.           */
+    long*           varSize;            /**< FTI-FF variable sizes.         */
+    int             nbVar;              /**< Capacity of varID/varSize.     */
+    int             nbReq;              /**< Number of pending sends.       */
+    MPI_Request     req[4];             /**< Pending sends.                 */
+} FTIT_ckptRequest;
+
+/** Requests in flight, used as a ring of Advanced:async_depth slots. */
+static FTIT_ckptRequest* FTI_CkptRequests = NULL;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It waits for the head to complete the oldest checkpoints.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      maxPending      Number of requests that may stay in flight.
+  @return     integer         FTI_SCES if successful.
+
+  The head serves the requests in the order they were sent. This function
+  receives the results of the oldest requests until at most maxPending
+  requests are left and updates the level of the last completed
+  checkpoint.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_WaitCkptRequests(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, int maxPending)
+{
+    char str[FTI_BUFS];
+    while (FTI_Exec->asyncSent - FTI_Exec->asyncDone > maxPending) {
+        FTIT_ckptRequest* rq = &FTI_CkptRequests[FTI_Exec->asyncDone % FTI_Conf->asyncDepth];
+        int lastLevel;
+        MPI_Recv(&lastLevel, 1, MPI_INT, FTI_Topo->headRank, FTI_Conf->generalTag, FTI_Exec->globalComm, MPI_STATUS_IGNORE);
+        MPI_Waitall(rq->nbReq, rq->req, MPI_STATUSES_IGNORE);
+        rq->nbReq = 0;
+        FTI_Exec->asyncDone++;
+        if (lastLevel != FTI_NSCS) { //Head sends level of checkpoint if post-processing succeed, FTI_NSCS Otherwise
+            FTI_Exec->lastCkptLvel = lastLevel; //Store last successful post-processing checkpoint level
+            snprintf(str, FTI_BUFS, "LastCkptLvel received from head: %d", lastLevel);
+            FTI_Print(str, FTI_DBUG);
+        } else if (rq->value != FTI_REJW) {
+            FTI_Print("Head failed to do post-processing after previous checkpoint.", FTI_WARN);
+        }
+    }
+    FTI_Exec->wasLastOffline = (FTI_Exec->asyncSent > FTI_Exec->asyncDone);
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It selects who post-processes the next checkpoint.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @param      level           Level of the next checkpoint.
+  @return     integer         FTI_SCES if successful.
+
+  Called before a checkpoint is written. It blocks only while
+  Advanced:async_depth checkpoints are in flight, or while the free space
+  of the local directory is too small for the next checkpoint and an older
+  one can still be completed. As long as checkpoints are in flight, all
+  the post-processing is left to the head (also of inline levels), so
+  that the checkpoints are completed, and the level directories replaced,
+  in the order they were taken. The checkpoint is written to the
+  temporary directories of its generation and FTI_Exec->postAsync is set
+  if the head post-processes it.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_PrepareCkptGen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int level)
+{
+    FTI_WaitCkptRequests(FTI_Conf, FTI_Exec, FTI_Topo, FTI_Conf->asyncDepth - 1);
+    int pending = FTI_Exec->asyncSent - FTI_Exec->asyncDone;
+    // the decision only depends on the requests sent, it is the same on all processes
+    FTI_Exec->postAsync = !FTI_Ckpt[level].isInline || (pending > 0);
+
+    if (pending > 0 && !(level == 4 && FTI_Ckpt[4].isInline)) {
+        // partner copies and encoded files take about the size of the checkpoint
+        unsigned long long need = (unsigned long long)FTI_Exec->ckptSize * FTI_Topo->nbApprocs;
+        if (level == 2 || level == 3) {
+            need *= 2;
+        }
+        struct statvfs st;
+        while (pending > 0 && statvfs(FTI_Conf->localDir, &st) == 0 &&
+                (unsigned long long)st.f_bavail * st.f_frsize < need) {
+            FTI_Print("Not enough local space, waiting for the previous checkpoint.", FTI_DBUG);
+            FTI_WaitCkptRequests(FTI_Conf, FTI_Exec, FTI_Topo, pending - 1);
+            pending--;
+        }
+    }
+
+    FTI_SetTmpDirs(FTI_Conf, (FTI_Exec->postAsync) ? FTI_Exec->asyncSent % FTI_Conf->asyncDepth : 0);
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It sends a checkpoint request to the head.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @param      value           Level token (FTI_BASE + level) or FTI_REJW.
+  @return     integer         FTI_SCES if successful.
+
+  The request (and the FTI-FF meta info) is sent without waiting for the
+  head, the result is received by FTI_WaitCkptRequests.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_SendCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int value)
+{
+    if (FTI_CkptRequests == NULL) {
+        FTI_CkptRequests = (FTIT_ckptRequest*) calloc(FTI_Conf->asyncDepth, sizeof(FTIT_ckptRequest));
+        if (FTI_CkptRequests == NULL) {
+            FTI_Print("Cannot allocate the checkpoint requests.", FTI_EROR);
+            return FTI_NSCS;
+        }
+    }
+    FTIT_ckptRequest* rq = &FTI_CkptRequests[FTI_Exec->asyncSent % FTI_Conf->asyncDepth];
+    int nbVar = FTI_Exec->meta[0].nbVar[0];
+    bool sendMeta = (FTI_Conf->ioMode == FTI_IO_FTIFF && value != FTI_REJW);
+    if (sendMeta && nbVar > rq->nbVar) {
+        int* varID = (int*) realloc(rq->varID, nbVar * sizeof(int));
+        if (varID != NULL) {
+            rq->varID = varID;
+        }
+        long* varSize = (varID != NULL) ? (long*) realloc(rq->varSize, nbVar * sizeof(long)) : NULL;
+        if (varSize != NULL) {
+            rq->varSize = varSize;
+            rq->nbVar = nbVar;
+        } else {
+            FTI_Print("Cannot allocate the checkpoint request, rejecting checkpoint.", FTI_EROR);
+            value = FTI_REJW;
+            sendMeta = false;
+        }
+    }
+    rq->value = value;
+    rq->nbReq = 0;
+    MPI_Isend(&rq->value, 1, MPI_INT, FTI_Topo->headRank, FTI_Conf->ckptTag, FTI_Exec->globalComm, &rq->req[rq->nbReq++]);
+
+    // FTIFF: send meta info to the heads
+    if (sendMeta) {
+        FTIFF_headInfo* headInfo = &rq->headInfo;
+        headInfo->exists = FTI_Exec->meta[0].exists[0];
+        headInfo->nbVar = nbVar;
+        headInfo->maxFs = FTI_Exec->meta[0].maxFs[0];
+        headInfo->fs = FTI_Exec->meta[0].fs[0];
+        headInfo->pfs = FTI_Exec->meta[0].pfs[0];
+        headInfo->isDcp = (FTI_Ckpt[4].isDcp) ? 1 : 0;
+        if (FTI_Conf->dcpEnabled && FTI_Ckpt[4].isDcp) {
+            strncpy(headInfo->ckptFile, FTI_Ckpt[4].dcpName, FTI_BUFS);
+        } else {
+            strncpy(headInfo->ckptFile, FTI_Exec->meta[0].ckptFile, FTI_BUFS);
+        }
+        memcpy(rq->varID, FTI_Exec->meta[0].varID, nbVar * sizeof(int));
+        memcpy(rq->varSize, FTI_Exec->meta[0].varSize, nbVar * sizeof(long));
+        MPI_Isend(headInfo, 1, FTIFF_MpiTypes[FTIFF_HEAD_INFO], FTI_Topo->headRank, FTI_Conf->generalTag, FTI_Exec->globalComm, &rq->req[rq->nbReq++]);
+        MPI_Isend(rq->varID, nbVar, MPI_INT, FTI_Topo->headRank, FTI_Conf->generalTag, FTI_Exec->globalComm, &rq->req[rq->nbReq++]);
+        MPI_Isend(rq->varSize, nbVar, MPI_LONG, FTI_Topo->headRank, FTI_Conf->generalTag, FTI_Exec->globalComm, &rq->req[rq->nbReq++]);
+    }
+    FTI_Exec->asyncSent++;
+    FTI_Exec->wasLastOffline = 1;
+    return (value == FTI_REJW) ? FTI_NSCS : FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It waits for all checkpoints in flight and frees the requests.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FinalizeCkptRequests(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo)
+{
+    FTI_WaitCkptRequests(FTI_Conf, FTI_Exec, FTI_Topo, 0);
+    if (FTI_CkptRequests != NULL) {
+        int i;
+        for (i = 0; i < FTI_Conf->asyncDepth; i++) {
+            free(FTI_CkptRequests[i].varID);
+            free(FTI_CkptRequests[i].varSize);
+        }
+        free(FTI_CkptRequests);
+        FTI_CkptRequests = NULL;
+    }
+    FTI_SetTmpDirs(FTI_Conf, 0);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Writes the protected variables with direct I/O.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Data        Dataset metadata.
+  @param      write_info      File opened by FTI_OpenDirect.
+  @return     integer         FTI_SCES if successful.
+
+  The file is closed on return.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_WritePosixDirect(FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data,
+        WriteDirectInfo_t* write_info)
+{
+    char str[FTI_BUFS];
+    int i, res = FTI_SCES;
+    for (i = 0; i < FTI_Exec->nbVar && res == FTI_SCES; i++) {
+        if ( !(FTI_Data[i].isDevicePtr) ){
+            res = write_direct(FTI_Data[i].ptr, FTI_Data[i].size, write_info);
+        }
+#ifdef GPUSUPPORT
+        else {
+            res = FTI_TransferDeviceMemToFileAsync(&FTI_Data[i], write_direct, write_info);
+        }
+#endif
+        if (res != FTI_SCES) {
+            snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
+            FTI_Print(str, FTI_EROR);
+        }
+    }
+    if (FTI_CloseDirect(write_info) != FTI_SCES) {
+        res = FTI_NSCS;
+    }
+    return res;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Writes ckpt to PFS using POSIX.
@@ -586,6 +975,24 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         snprintf(fn, FTI_BUFS, "%s/%s", FTI_Conf->lTmpDir, FTI_Exec->meta[0].ckptFile);
     }
 
+    // hash the data while it is streamed into the ckpt file
+    MD5_CTX integrity;
+    MD5_Init(&integrity);
+
+    // local ckpt. files bypass the page cache if direct I/O is enabled
+    bool local = !(level == 4 && FTI_Ckpt[4].isInline);
+    if (local && FTI_Conf->directIO) {
+        WriteDirectInfo_t direct_info;
+        if (FTI_OpenDirect(&direct_info, fn, &integrity) == FTI_SCES) {
+            res = FTI_WritePosixDirect(FTI_Exec, FTI_Data, &direct_info);
+            if (res == FTI_SCES) {
+                FTI_FinalizeIntegrity(&integrity, FTI_Exec->integrity);
+            }
+            return res;
+        }
+        FTI_Print("Cannot open the ckpt. file with O_DIRECT, using buffered I/O.", FTI_DBUG);
+    }
+
     // open task local ckpt file
     FILE* fd = fopen(fn, "wb");
     if (fd == NULL) {
@@ -595,6 +1002,10 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         return FTI_NSCS;
     }
 
+    WritePosixInfo_t write_info;
+    write_info.f = fd;
+    write_info.integrity = &integrity;
+
     // write data into ckpt file
     int i;
 
@@ -606,7 +1017,7 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             if ( !(FTI_Data[i].isDevicePtr) ){
                 snprintf(str, FTI_BUFS, "ID:  %d Data are . %d %p %p", FTI_Data[i].id,FTI_Data[i].isDevicePtr,FTI_Data[i].ptr,FTI_Data[i].devicePtr);
                 FTI_Print(str,FTI_DBUG);
-                if (( res = FTI_Try( write_posix(FTI_Data[i].ptr, FTI_Data[i].size, fd), "Storing Data to Checkpoint File"))!=FTI_SCES){
+                if (( res = FTI_Try( write_posix(FTI_Data[i].ptr, FTI_Data[i].size, &write_info), "Storing Data to Checkpoint File"))!=FTI_SCES){
                     snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
                     FTI_Print(str, FTI_EROR);
                     fclose(fd);
@@ -618,7 +1029,7 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             // memory to cpu memory and store them.
             else {
                 if ((res = FTI_Try(
-                                FTI_TransferDeviceMemToFileAsync(&FTI_Data[i],   write_posix, fd),
+                                FTI_TransferDeviceMemToFileAsync(&FTI_Data[i],   write_posix, &write_info),
                                 "moving data from GPU to storage")) != FTI_SCES) {
                     snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
                     FTI_Print(str, FTI_EROR);
@@ -640,6 +1051,11 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
 
+    // start the write-back and drop the ckpt. from the page cache
+    if (local && FTI_Conf->directIO && fflush(fd) == 0) {
+        posix_fadvise(fileno(fd), 0, 0, POSIX_FADV_DONTNEED);
+    }
+
     // close file
     if (fclose(fd) != 0) {
         FTI_Print("FTI checkpoint file could not be closed.", FTI_EROR);
@@ -647,10 +1063,103 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         return FTI_NSCS;
     }
 
+    FTI_FinalizeIntegrity(&integrity, FTI_Exec->integrity);
+
     return res;
 
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Writes the protected variables with collective MPI-IO.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Data        Dataset metadata.
+  @param      write_info      MPI-IO file, offset of this rank and checksum.
+  @return     integer         FTI_SCES if successful.
+
+  The file view of every rank starts at its offset. The variables are
+  written in rounds of 'transferSize' bytes with 'MPI_File_write_at_all',
+  hence, the collective buffering of the MPI-IO layer is used. Each round
+  is described by an hindexed datatype on the variables, thus, no data is
+  copied. All ranks take part in the same number of rounds, ranks with
+  less data write zero bytes in the remaining rounds. If a write fails,
+  the rank keeps on taking part in the collective calls.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_WriteMPICollective(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_dataset* FTI_Data, WriteMPIInfo_t* write_info)
+{
+    long ts = FTI_Conf->transferSize;
+    long size = 0;
+    int i;
+    for (i = 0; i < FTI_Exec->nbVar; i++) {
+        size += FTI_Data[i].size;
+    }
+    long nbRounds = (size + ts - 1) / ts;
+    MPI_Allreduce(MPI_IN_PLACE, &nbRounds, 1, MPI_LONG, MPI_MAX, FTI_COMM_WORLD);
+
+    write_info->err = MPI_File_set_view(write_info->pfh, write_info->offset, MPI_BYTE, MPI_BYTE,
+            "native", FTI_Conf->mpiioInfo);
+
+    int* lens = talloc(int, FTI_Exec->nbVar + 1);
+    MPI_Aint* displs = talloc(MPI_Aint, FTI_Exec->nbVar + 1);
+    int var = 0;
+    long varPos = 0;
+    long round;
+    for (round = 0; round < nbRounds; round++) {
+        // collect the pieces of the variables written in this round
+        long roundSize = 0;
+        int n = 0;
+        while (roundSize < ts && var < FTI_Exec->nbVar) {
+            long len = FTI_Data[var].size - varPos;
+            if (len > ts - roundSize) {
+                len = ts - roundSize;
+            }
+            if (len > 0) {
+                MPI_Get_address((char*)FTI_Data[var].ptr + varPos, &displs[n]);
+                lens[n] = len;
+                n++;
+                roundSize += len;
+                varPos += len;
+            }
+            if (varPos == FTI_Data[var].size) {
+                var++;
+                varPos = 0;
+            }
+        }
+        if (write_info->err != 0) {
+            n = 0;
+        }
+
+        int res;
+        if (n > 0) {
+            MPI_Datatype dType;
+            MPI_Type_create_hindexed(n, lens, displs, MPI_BYTE, &dType);
+            MPI_Type_commit(&dType);
+            res = MPI_File_write_at_all(write_info->pfh, round * ts, MPI_BOTTOM, 1, dType, MPI_STATUS_IGNORE);
+            MPI_Type_free(&dType);
+        }
+        else {
+            res = MPI_File_write_at_all(write_info->pfh, 0, NULL, 0, MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+        if (res != 0 && write_info->err == 0) {
+            write_info->err = res;
+        }
+
+        if (write_info->err == 0 && write_info->integrity != NULL) {
+            for (i = 0; i < n; i++) {
+                MD5_Update(write_info->integrity, (void*)displs[i], lens[i]);
+            }
+        }
+    }
+    free(lens);
+    free(displs);
+
+    return (write_info->err == 0) ? FTI_SCES : FTI_NSCS;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Writes ckpt to PFS using MPI I/O.
@@ -666,6 +1175,9 @@ int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   elements to form contiguous data types. It was experienced, that
   if the size is greater then that, it may lead to problems.
 
+  The data is written collectively (see 'FTI_WriteMPICollective'),
+  unless some rank protects device data.
+
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_WriteMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
@@ -678,14 +1190,10 @@ int FTI_WriteMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     write_info.FTI_Conf = FTI_Conf;
 
-    // enable collective buffer optimization
-    MPI_Info info;
-    MPI_Info_create(&info);
-    MPI_Info_set(info, "romio_cb_write", "enable");
-
-    // TODO enable to set stripping unit in the config file (Maybe also other hints)
-    // set stripping unit to 4MB
-    MPI_Info_set(info, "stripping_unit", "4194304");
+    // hash the data while it is streamed into the ckpt file
+    MD5_CTX integrity;
+    MD5_Init(&integrity);
+    write_info.integrity = &integrity;
 
     MPI_Offset chunkSize = FTI_Exec->ckptSize;
 
@@ -715,7 +1223,8 @@ int FTI_WriteMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
 #endif
-    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, info, &(write_info.pfh));
+    // hints from the configuration (collective buffering, striping)
+    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, FTI_Conf->mpiioInfo, &(write_info.pfh));
 
     // check if successful
     if (res != 0) {
@@ -736,7 +1245,30 @@ int FTI_WriteMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     }
     free(chunkSizes);
 
+    // device data is staged through the host buffer and written
+    // independently, all ranks have to agree on the write mode
+    int independent = 0;
     for (i = 0; i < FTI_Exec->nbVar; i++) {
+        if (FTI_Data[i].isDevicePtr) {
+            independent = 1;
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &independent, 1, MPI_INT, MPI_MAX, FTI_COMM_WORLD);
+
+    if (!independent) {
+        res = FTI_WriteMPICollective(FTI_Conf, FTI_Exec, FTI_Data, &write_info);
+        if (res != FTI_SCES) {
+            errno = 0;
+            int reslen;
+            MPI_Error_string(write_info.err, mpi_err, &reslen);
+            snprintf(str, FTI_BUFS, "Failed to write ckpt. data to PFS [MPI ERROR - %i] %s", write_info.err, mpi_err);
+            FTI_Print(str, FTI_EROR);
+            MPI_File_close(&write_info.pfh);
+            return FTI_NSCS;
+        }
+    }
+
+    for (i = 0; i < FTI_Exec->nbVar && independent; i++) {
         // determine the type of data pointer
         // Data are stored in the CPU side. 
         if ( !(FTI_Data[i].isDevicePtr) ){
@@ -770,7 +1302,232 @@ int FTI_WriteMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
     MPI_File_close(&write_info.pfh);
-    MPI_Info_free(&info);
+
+    FTI_FinalizeIntegrity(&integrity, FTI_Exec->integrity);
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Updates the dCP file of this rank using POSIX.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @param      FTI_Data        Dataset metadata.
+  @return     integer         FTI_SCES if successful.
+
+  The dCP file is kept in the global dCP directory across checkpoints and
+  has the layout of a POSIX ckpt. file. Only the blocks that changed since
+  the last dCP update are written in place. A variable is written
+  completely if it is new, if its size changed or if a preceding variable
+  changed its size. The checksum is computed from the protected data by
+  'FTI_CreateMetadata'. If the update fails, the hashes are discarded and
+  all data is written during the next update.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_WritePosixDcp(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
+        FTIT_dataset* FTI_Data)
+{
+    FTI_Print("I/O mode: Posix (dCP).", FTI_DBUG);
+    char str[FTI_BUFS], fn[FTI_BUFS];
+    snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dcpDir, FTI_Ckpt[4].dcpName);
+
+    // the clean blocks of the file are kept, no truncation on open
+    int fd = open(fn, O_WRONLY | O_CREAT, (mode_t) 0600);
+    FILE* f = (fd != -1) ? fdopen(fd, "wb") : NULL;
+    if (f == NULL) {
+        snprintf(str, FTI_BUFS, "FTI dCP file (%s) could not be opened.", fn);
+        FTI_Print(str, FTI_EROR);
+        if (fd != -1) {
+            close(fd);
+        }
+        FTI_FreeDataDcpHashes(FTI_Exec, FTI_Data);
+        return FTI_NSCS;
+    }
+
+    long dcpSize = 0, offset = 0;
+    bool reset = false;
+    int i, res = FTI_SCES;
+    for (i = 0; i < FTI_Exec->nbVar && res == FTI_SCES; i++) {
+        res = FTI_InitDataDcpHash(&FTI_Data[i], &reset);
+        if (res != FTI_SCES) {
+            break;
+        }
+        if (FTI_Data[i].isDevicePtr) {
+#ifdef GPUSUPPORT
+            // device data is not hashed, it is written completely
+            WritePosixInfo_t write_info;
+            write_info.f = f;
+            write_info.integrity = NULL;
+            if (fseeko(f, offset, SEEK_SET) != 0) {
+                res = FTI_NSCS;
+                break;
+            }
+            res = FTI_TransferDeviceMemToFileAsync(&FTI_Data[i], write_posix, &write_info);
+            if (res != FTI_SCES) {
+                // write_posix closed the file
+                f = NULL;
+            }
+            dcpSize += FTI_Data[i].size;
+#endif
+        }
+        else if (FTI_Data[i].dcpHash != NULL) {
+            unsigned char* ptr = (unsigned char*) FTI_Data[i].ptr;
+            long hashIdx = 0, regOffset, regSize;
+            FTI_ComputeDcpHashes(FTI_Data[i].dcpHash, ptr, 0, FTI_Data[i].size);
+            while (res == FTI_SCES && FTI_NextDirtyRegion(FTI_Data[i].dcpHash, ptr, &hashIdx, &regOffset, &regSize)) {
+                if (fseeko(f, offset + regOffset, SEEK_SET) != 0 ||
+                        fwrite(ptr + regOffset, 1, regSize, f) != (size_t) regSize) {
+                    res = FTI_NSCS;
+                }
+                dcpSize += regSize;
+            }
+            FTI_ClearDcpHashes();
+        }
+        if (res != FTI_SCES) {
+            snprintf(str, FTI_BUFS, "Dataset #%d could not be written to the dCP file.", FTI_Data[i].id);
+            FTI_Print(str, FTI_EROR);
+        }
+        offset += FTI_Data[i].size;
+    }
+
+    // the protected data may have shrunk
+    if (f != NULL) {
+        if (res == FTI_SCES && (fflush(f) != 0 || ftruncate(fileno(f), offset) != 0)) {
+            FTI_Print("FTI dCP file could not be truncated.", FTI_EROR);
+            res = FTI_NSCS;
+        }
+        if (fclose(f) != 0) {
+            FTI_Print("FTI dCP file could not be closed.", FTI_EROR);
+            res = FTI_NSCS;
+        }
+    }
+
+    if (res != FTI_SCES) {
+        FTI_FreeDataDcpHashes(FTI_Exec, FTI_Data);
+        return FTI_NSCS;
+    }
+
+    FTI_Exec->FTIFFMeta.dcpSize = dcpSize;
+    FTI_Exec->FTIFFMeta.pureDataSize = offset;
+
+    return FTI_SCES;
+}
+
+/** Offset of this rank in the shared dCP file at the last update (MPI-IO). */
+static MPI_Offset FTI_DcpMpiOffset = -1;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Updates the shared dCP file using MPI-IO.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @param      FTI_Data        Dataset metadata.
+  @return     integer         FTI_SCES if successful.
+
+  All ranks share one dCP file in the global dCP directory with the layout
+  of the MPI-IO ckpt. file. The changed blocks are written in place with
+  independent writes (see 'FTI_WritePosixDcp'). If the offset of the rank
+  in the file changed, all its data is written.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_WriteMPIDcp(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
+        FTIT_dataset* FTI_Data)
+{
+    FTI_Print("I/O mode: MPI-IO (dCP).", FTI_DBUG);
+    char str[FTI_BUFS], mpi_err[FTI_BUFS], gfn[FTI_BUFS];
+    snprintf(gfn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dcpDir, FTI_Ckpt[4].dcpName);
+
+    // collect chunksizes of other ranks
+    MPI_Offset chunkSize = FTI_Exec->ckptSize;
+    int nbProcs = FTI_Topo->nbApprocs * FTI_Topo->nbNodes;
+    MPI_Offset* chunkSizes = talloc(MPI_Offset, nbProcs);
+    MPI_Allgather(&chunkSize, 1, MPI_OFFSET, chunkSizes, 1, MPI_OFFSET, FTI_COMM_WORLD);
+    MPI_Offset offset = 0, fileSize = 0;
+    int i;
+    for (i = 0; i < nbProcs; i++) {
+        if (i < FTI_Topo->splitRank) {
+            offset += chunkSizes[i];
+        }
+        fileSize += chunkSizes[i];
+    }
+    free(chunkSizes);
+
+    WriteMPIInfo_t write_info;
+    write_info.FTI_Conf = FTI_Conf;
+    write_info.integrity = NULL;
+    write_info.err = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY | MPI_MODE_CREATE, FTI_Conf->mpiioInfo, &(write_info.pfh));
+    if (write_info.err != 0) {
+        int reslen;
+        MPI_Error_string(write_info.err, mpi_err, &reslen);
+        snprintf(str, FTI_BUFS, "unable to open dCP file [MPI ERROR - %i] %s", write_info.err, mpi_err);
+        FTI_Print(str, FTI_EROR);
+        FTI_FreeDataDcpHashes(FTI_Exec, FTI_Data);
+        FTI_DcpMpiOffset = -1;
+        return FTI_NSCS;
+    }
+
+    long dcpSize = 0, varOffset = 0;
+    bool reset = (offset != FTI_DcpMpiOffset);
+    int res = FTI_SCES;
+    for (i = 0; i < FTI_Exec->nbVar && res == FTI_SCES; i++) {
+        res = FTI_InitDataDcpHash(&FTI_Data[i], &reset);
+        if (res != FTI_SCES) {
+            break;
+        }
+        if (FTI_Data[i].isDevicePtr) {
+#ifdef GPUSUPPORT
+            // device data is not hashed, it is written completely
+            write_info.offset = offset + varOffset;
+            res = FTI_TransferDeviceMemToFileAsync(&FTI_Data[i], write_mpi, &write_info);
+            dcpSize += FTI_Data[i].size;
+#endif
+        }
+        else if (FTI_Data[i].dcpHash != NULL) {
+            unsigned char* ptr = (unsigned char*) FTI_Data[i].ptr;
+            long hashIdx = 0, regOffset, regSize;
+            FTI_ComputeDcpHashes(FTI_Data[i].dcpHash, ptr, 0, FTI_Data[i].size);
+            while (res == FTI_SCES && FTI_NextDirtyRegion(FTI_Data[i].dcpHash, ptr, &hashIdx, &regOffset, &regSize)) {
+                write_info.offset = offset + varOffset + regOffset;
+                res = write_mpi(ptr + regOffset, regSize, &write_info);
+                dcpSize += regSize;
+            }
+            FTI_ClearDcpHashes();
+        }
+        if (res != FTI_SCES) {
+            int reslen;
+            MPI_Error_string(write_info.err, mpi_err, &reslen);
+            snprintf(str, FTI_BUFS, "Failed to write protected_var[%i] to the dCP file [MPI ERROR - %i] %s", i, write_info.err, mpi_err);
+            FTI_Print(str, FTI_EROR);
+        }
+        varOffset += FTI_Data[i].size;
+    }
+
+    // the protected data may have shrunk (collective call)
+    if (MPI_File_set_size(write_info.pfh, fileSize) != 0) {
+        FTI_Print("FTI dCP file could not be truncated.", FTI_EROR);
+        res = FTI_NSCS;
+    }
+    MPI_File_close(&write_info.pfh);
+
+    if (res != FTI_SCES) {
+        FTI_FreeDataDcpHashes(FTI_Exec, FTI_Data);
+        FTI_DcpMpiOffset = -1;
+        return FTI_NSCS;
+    }
+    FTI_DcpMpiOffset = offset;
+
+    FTI_Exec->FTIFFMeta.dcpSize = dcpSize;
+    FTI_Exec->FTIFFMeta.pureDataSize = varOffset;
+
     return FTI_SCES;
 }
 
@@ -833,20 +1590,27 @@ int FTI_WriteSionlib(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         return FTI_NSCS;
     }
 
+    // hash the data while it is streamed into the ckpt file
+    MD5_CTX integrity;
+    MD5_Init(&integrity);
+    WriteSionInfo_t write_info;
+    write_info.sid = sid;
+    write_info.integrity = &integrity;
+
     // write datasets into file
     int i;
     for (i = 0; i < FTI_Exec->nbVar; i++) {
         // SIONlib write call
 
         if ( !(FTI_Data[i].isDevicePtr) ){
-            res = write_sion(FTI_Data[i].ptr, FTI_Data[i].size, &sid);
+            res = write_sion(FTI_Data[i].ptr, FTI_Data[i].size, &write_info);
         }
 #ifdef GPUSUPPORT            
         // if data are stored to the GPU move them from device
         // memory to cpu memory and store them.
         else {
             if ((res = FTI_Try(
-                            TransferDeviceMemToFileAsync(&FTI_Data[i], write_sion, &sid),
+                            FTI_TransferDeviceMemToFileAsync(&FTI_Data[i], write_sion, &write_info),
                             "moving data from GPU to storage")) != FTI_SCES) {
                 snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
                 FTI_Print(str, FTI_EROR);
@@ -877,6 +1641,8 @@ int FTI_WriteSionlib(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     free(ranks);
     free(chunkSizes);
 
+    FTI_FinalizeIntegrity(&integrity, FTI_Exec->integrity);
+
     return FTI_SCES;
 }
 #endif
@@ -0,0 +1,370 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   compress.c
+ *  @date   October, 2018
+ *  @brief  Compression of FTI-FF chunks.
+ *
+ *  A chunk is stored as a sequence of frames, each one holding up to
+ *  FTI_COMP_FRAME bytes of the chunk:
+ *
+ *  +-----------+--------------+---------------------------+
+ *  | raw size  | stored size  | payload (stored size)     |
+ *  | uint32_t  | uint32_t     |                           |
+ *  +-----------+--------------+---------------------------+
+ *
+ *  The payload is compressed with the codec of the chunk, or is a plain
+ *  copy of the data if the codec did not shrink it (stored == raw size).
+ */
+
+#include "interface.h"
+
+/** Hash table size of the LZ codec (log2).                                */
+#define FTI_LZ_HASH_LOG 14
+/** Min. length of a match of the LZ codec.                                */
+#define FTI_LZ_MIN_MATCH 4
+/** Max. distance of a match of the LZ codec.                              */
+#define FTI_LZ_MAX_OFFSET 65535
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Reads 4 unaligned bytes.
+ **/
+/*-------------------------------------------------------------------------*/
+static inline uint32_t FTI_LzRead32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Appends the extra bytes of a literal or match length.
+ **/
+/*-------------------------------------------------------------------------*/
+static inline unsigned char* FTI_LzLength(unsigned char* op, long len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Appends a sequence (literals followed by a match).
+  @param      op              Output position.
+  @param      oend            End of the output buffer.
+  @param      lit             First literal.
+  @param      litLen          Number of literals.
+  @param      offset          Distance of the match (0 -> no match).
+  @param      matchLen        Length of the match.
+  @return     unsigned char*  New output position, NULL if it does not fit.
+
+  The token holds the literal length in the high and the match length in
+  the low nibble. Lengths of 15 and more continue in extra bytes.
+ **/
+/*-------------------------------------------------------------------------*/
+static unsigned char* FTI_LzSequence(unsigned char* op, unsigned char* oend,
+        const unsigned char* lit, long litLen, long offset, long matchLen)
+{
+    long ml = (offset) ? matchLen - FTI_LZ_MIN_MATCH : 0;
+    long need = 1 + litLen + litLen / 255 + 1 + 2 + ml / 255 + 1;
+    if (op + need > oend) {
+        return NULL;
+    }
+    unsigned char* token = op++;
+    *token = (unsigned char)(((litLen < 15) ? litLen : 15) << 4);
+    if (litLen >= 15) {
+        op = FTI_LzLength(op, litLen - 15);
+    }
+    memcpy(op, lit, litLen);
+    op += litLen;
+    if (offset) {
+        *op++ = (unsigned char)(offset & 0xff);
+        *op++ = (unsigned char)(offset >> 8);
+        *token |= (unsigned char)((ml < 15) ? ml : 15);
+        if (ml >= 15) {
+            op = FTI_LzLength(op, ml - 15);
+        }
+    }
+    return op;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Compresses a buffer with the built-in LZ codec.
+  @param      src             Data to compress.
+  @param      size            Size of the data.
+  @param      dst             Output buffer.
+  @param      cap             Size of the output buffer.
+  @return     long            Compressed size, -1 if larger than cap.
+
+  Greedy LZ77 with a single-entry hash table of 4 byte sequences. After
+  64 positions without a match the search step grows, so that data which
+  does not compress is skipped quickly.
+ **/
+/*-------------------------------------------------------------------------*/
+static long FTI_LzCompress(const unsigned char* src, long size,
+        unsigned char* dst, long cap)
+{
+    uint32_t table[1 << FTI_LZ_HASH_LOG];
+    memset(table, 0, sizeof(table));
+
+    const unsigned char* ip = src;
+    const unsigned char* anchor = src;
+    const unsigned char* iend = src + size;
+    const unsigned char* mflimit = iend - FTI_LZ_MIN_MATCH;
+    unsigned char* op = dst;
+    unsigned char* oend = dst + cap;
+    long misses = 0;
+
+    while (ip < mflimit) {
+        uint32_t seq = FTI_LzRead32(ip);
+        uint32_t h = (seq * 2654435761U) >> (32 - FTI_LZ_HASH_LOG);
+        const unsigned char* ref = src + table[h];
+        table[h] = (uint32_t)(ip - src);
+        if (ref < ip && ip - ref <= FTI_LZ_MAX_OFFSET && FTI_LzRead32(ref) == seq) {
+            long len = FTI_LZ_MIN_MATCH;
+            while (ip + len + 8 <= iend && memcmp(ref + len, ip + len, 8) == 0) {
+                len += 8;
+            }
+            while (ip + len < iend && ref[len] == ip[len]) {
+                len++;
+            }
+            op = FTI_LzSequence(op, oend, anchor, ip - anchor, ip - ref, len);
+            if (op == NULL) {
+                return -1;
+            }
+            ip += len;
+            anchor = ip;
+            misses = 0;
+        } else {
+            ip += 1 + (misses++ >> 6);
+        }
+    }
+
+    op = FTI_LzSequence(op, oend, anchor, iend - anchor, 0, 0);
+    if (op == NULL) {
+        return -1;
+    }
+    return op - dst;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Decompresses a buffer of the built-in LZ codec.
+  @param      src             Compressed data.
+  @param      size            Size of the compressed data.
+  @param      dst             Output buffer.
+  @param      cap             Size of the output buffer.
+  @return     long            Decompressed size, -1 if the data is corrupt.
+ **/
+/*-------------------------------------------------------------------------*/
+static long FTI_LzDecompress(const unsigned char* src, long size,
+        unsigned char* dst, long cap)
+{
+    const unsigned char* ip = src;
+    const unsigned char* iend = src + size;
+    unsigned char* op = dst;
+    unsigned char* oend = dst + cap;
+
+    while (ip < iend) {
+        unsigned char token = *ip++;
+        long len = token >> 4;
+        if (len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > iend - ip || len > oend - op) {
+            return -1;
+        }
+        memcpy(op, ip, len);
+        ip += len;
+        op += len;
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        long offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        len = (token & 15);
+        if (len == 15) {
+            unsigned char b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += FTI_LZ_MIN_MATCH;
+        if (offset == 0 || offset > op - dst || len > oend - op) {
+            return -1;
+        }
+        // byte-wise, the match may overlap the output
+        const unsigned char* ref = op - offset;
+        while (len--) {
+            *op++ = *ref++;
+        }
+    }
+    return op - dst;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the max. size of a frame.
+  @param      size            Raw size of the frame.
+  @return     long            Max. size of the frame including the header.
+ **/
+/*-------------------------------------------------------------------------*/
+long FTI_CompressBound(long size)
+{
+    return FTI_COMP_HEADER + size;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Compresses a frame.
+  @param      codec           Codec (FTI_COMP_*).
+  @param      src             Data to compress (at most FTI_COMP_FRAME bytes).
+  @param      size            Size of the data.
+  @param      dst             Output buffer of FTI_CompressBound(size) bytes.
+  @return     long            Size of the frame including the header.
+
+  The data is copied as it is if the codec does not shrink it.
+ **/
+/*-------------------------------------------------------------------------*/
+long FTI_CompressFrame(int codec, const unsigned char* src, long size,
+        unsigned char* dst)
+{
+    unsigned char* payload = dst + FTI_COMP_HEADER;
+    long stored = -1;
+
+    switch (codec) {
+        case FTI_COMP_LZ:
+            if (size > FTI_LZ_MIN_MATCH) {
+                stored = FTI_LzCompress(src, size, payload, size - 1);
+            }
+            break;
+#ifndef FTI_NOZLIB
+        case FTI_COMP_ZLIB:
+            {
+                uLongf len = size - 1;
+                if (size > 1 && compress2(payload, &len, src, size, Z_BEST_SPEED) == Z_OK) {
+                    stored = len;
+                }
+            }
+            break;
+#endif
+    }
+
+    if (stored < 0) {
+        memcpy(payload, src, size);
+        stored = size;
+    }
+
+    uint32_t header[2] = { (uint32_t)size, (uint32_t)stored };
+    memcpy(dst, header, FTI_COMP_HEADER);
+    return FTI_COMP_HEADER + stored;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Decompresses a frame.
+  @param      codec           Codec (FTI_COMP_*).
+  @param      src             Start of the frame.
+  @param      avail           Bytes available at src.
+  @param      dst             Output buffer.
+  @param      dstSize         Size of the output buffer.
+  @param      used            On return, size of the frame.
+  @param      produced        On return, raw size of the frame.
+  @return     integer         FTI_SCES if successful.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_DecompressFrame(int codec, const unsigned char* src, long avail,
+        unsigned char* dst, long dstSize, long* used, long* produced)
+{
+    uint32_t header[2];
+    if (avail < (long)FTI_COMP_HEADER) {
+        return FTI_NSCS;
+    }
+    memcpy(header, src, FTI_COMP_HEADER);
+    long raw = header[0], stored = header[1];
+    const unsigned char* payload = src + FTI_COMP_HEADER;
+    if (stored > avail - (long)FTI_COMP_HEADER || raw > dstSize) {
+        return FTI_NSCS;
+    }
+
+    long len = -1;
+    if (stored == raw) {
+        memcpy(dst, payload, raw);
+        len = raw;
+    } else {
+        switch (codec) {
+            case FTI_COMP_LZ:
+                len = FTI_LzDecompress(payload, stored, dst, raw);
+                break;
+#ifndef FTI_NOZLIB
+            case FTI_COMP_ZLIB:
+                {
+                    uLongf zlen = raw;
+                    if (uncompress(dst, &zlen, payload, stored) == Z_OK) {
+                        len = zlen;
+                    }
+                }
+                break;
+#endif
+        }
+    }
+    if (len != raw) {
+        return FTI_NSCS;
+    }
+
+    *used = FTI_COMP_HEADER + stored;
+    *produced = raw;
+    return FTI_SCES;
+}
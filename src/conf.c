@@ -101,6 +101,50 @@ int FTI_UpdateConf(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, int r
     return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the MPI-IO hints given in the configuration file.
+  @param      FTI_Conf        Configuration metadata.
+  @param      ini             Dictionary of the configuration file.
+
+  Every key of the [Advanced] section named 'mpiio_hint_<hint>' is passed
+  as '<hint>' to the MPI-IO file operations (e.g., 'mpiio_hint_cb_nodes',
+  'mpiio_hint_striping_unit'). The defaults enable the collective buffering
+  and set a striping unit of 4MB, they may be overwritten.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_LoadMpiioHints(FTIT_configuration* FTI_Conf, dictionary* ini)
+{
+    char str[FTI_BUFS]; //For console output
+    const char* prefix = "advanced:mpiio_hint_";
+    int prefixLen = strlen(prefix);
+
+    MPI_Info_create(&FTI_Conf->mpiioInfo);
+    MPI_Info_set(FTI_Conf->mpiioInfo, "romio_cb_write", "enable");
+    MPI_Info_set(FTI_Conf->mpiioInfo, "striping_unit", "4194304");
+
+    int nkeys = iniparser_getsecnkeys(ini, "advanced");
+    char** keys = iniparser_getseckeys(ini, "advanced");
+    if (keys == NULL) {
+        return;
+    }
+    int i;
+    for (i = 0; i < nkeys; i++) {
+        if (strncmp(keys[i], prefix, prefixLen) != 0 || keys[i][prefixLen] == '\0') {
+            continue;
+        }
+        char* value = iniparser_getstring(ini, keys[i], NULL);
+        if (value == NULL || value[0] == '\0') {
+            continue;
+        }
+        MPI_Info_set(FTI_Conf->mpiioInfo, &keys[i][prefixLen], value);
+        snprintf(str, FTI_BUFS, "MPI-IO hint: %s = %s", &keys[i][prefixLen], value);
+        FTI_Print(str, FTI_DBUG);
+    }
+    free(keys);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It reads the configuration given in the configuration file.
@@ -175,13 +219,29 @@ int FTI_ReadConf(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     FTI_Conf->generalTag = (int)iniparser_getint(ini, "Advanced:general_tag", 2612);
     FTI_Conf->test = (int)iniparser_getint(ini, "Advanced:local_test", -1);
     FTI_Conf->l3WordSize = FTI_WORD;
+    FTI_Conf->rsThreads = (int)iniparser_getint(ini, "Advanced:rs_threads", 1);
+    FTI_Conf->dcpThreads = (int)iniparser_getint(ini, "Advanced:dcp_threads", 1);
+    FTI_Conf->flushBuffers = (int)iniparser_getint(ini, "Advanced:flush_buffers", 2);
+    FTI_Conf->metaIni = (bool)iniparser_getboolean(ini, "Advanced:meta_ini", 0);
+    FTI_Conf->headPollMax = iniparser_getlint(ini, "Advanced:head_poll_max", 1000);
+    FTI_Conf->asyncDepth = (int)iniparser_getint(ini, "Advanced:async_depth", 1);
+    FTI_Conf->directIO = (bool)iniparser_getboolean(ini, "Advanced:direct_io", 0);
+    FTI_Conf->l2Delta = (bool)iniparser_getboolean(ini, "Advanced:l2_delta", 0);
+    FTI_Conf->statsEnabled = (bool)iniparser_getboolean(ini, "Advanced:stats", 0);
+    char* traceFile = iniparser_getstring(ini, "Advanced:trace_file", NULL);
+    if ( traceFile && strncmp( traceFile, "", 1 ) != 0 ) {
+        snprintf(FTI_Conf->traceFile, FTI_BUFS, "%s", traceFile);
+        FTI_Conf->statsEnabled = true;
+    }
     FTI_Conf->ioMode = (int)iniparser_getint(ini, "Basic:ckpt_io", 0) + 1000;
+    FTI_Conf->compMode = (int)iniparser_getint(ini, "Basic:ckpt_compress", 0);
     FTI_Conf->cHostBufSize = (size_t)iniparser_getlint(ini, "Advanced:gpu_host_bufsize", FTI_DEFAULT_CHOSTBUF_SIZE_MB * ((size_t)1 << 20) );
 #ifdef LUSTRE
     FTI_Conf->stripeUnit = (int)iniparser_getint(ini, "Advanced:lustre_stiping_unit", 4194304);
     FTI_Conf->stripeFactor = (int)iniparser_getint(ini, "Advanced:lustre_stiping_factor", -1);
     FTI_Conf->stripeOffset = (int)iniparser_getint(ini, "Advanced:lustre_stiping_offset", -1);
 #endif
+    FTI_LoadMpiioHints(FTI_Conf, ini);
     char *h5SingleFileDir = iniparser_getstring(ini, "basic:h5_single_file_dir", NULL);
     if( h5SingleFileDir ) {
         if( strncmp( h5SingleFileDir, "", 1 ) != 0 ) {
@@ -217,6 +277,8 @@ int FTI_ReadConf(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     FTI_Exec->ckptLvel = 0;
     FTI_Exec->ckptIntv = 1;
     FTI_Exec->wasLastOffline = 0;
+    FTI_Exec->asyncSent = 0;
+    FTI_Exec->asyncDone = 0;
     FTI_Exec->ckptNext = 0;
     FTI_Exec->ckptLast = 0;
     FTI_Exec->syncIter = 1;
@@ -313,6 +375,15 @@ int FTI_TestConfig(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
         FTI_Print("Block size needs to be set between 1 and 2048.", FTI_WARN);
         return FTI_NSCS;
     }
+    if (FTI_Conf->rsThreads < 1) {
+        FTI_Print("Number of RS threads ('Advanced:rs_threads') must be at least 1. Set to 1.", FTI_WARN);
+        FTI_Conf->rsThreads = 1;
+    }
+
+    if (FTI_Conf->flushBuffers < 1) {
+        FTI_Print("Number of flush buffers ('Advanced:flush_buffers') must be at least 1. Set to 2.", FTI_WARN);
+        FTI_Conf->flushBuffers = 2;
+    }
 
     if ( FTI_Conf->keepHeadsAlive && ( FTI_Topo->nbHeads == 0 ) ) {
         FTI_Print("Head feature is disabled but 'keep_heads_alive' is activated. Incompatiple setting!.", FTI_WARN);
@@ -321,13 +392,15 @@ int FTI_TestConfig(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 
     // check dCP settings only if dCP is enabled
     if ( FTI_Conf->dcpEnabled ) {
-        if ( !(FTI_Conf->ioMode == FTI_IO_FTIFF) ) {
-            FTI_Print("dCP may only be used with FTI-FF enabled, dCP disabled.", FTI_WARN);
+        bool dcpIO = (FTI_Conf->ioMode == FTI_IO_FTIFF) || (FTI_Conf->ioMode == FTI_IO_POSIX) ||
+            (FTI_Conf->ioMode == FTI_IO_MPI);
+        if ( !dcpIO ) {
+            FTI_Print("dCP may only be used with FTI-FF, POSIX or MPI-IO, dCP disabled.", FTI_WARN);
             FTI_Conf->dcpEnabled = false;
             goto CHECK_DCP_SETTING_END;
         }
-        if ( (FTI_Conf->dcpMode < FTI_DCP_MODE_MD5) || (FTI_Conf->dcpMode > FTI_DCP_MODE_CRC32) ) {
-            FTI_Print("dCP mode ('Basic:dcp_mode') must be either 1 (MD5) or 2 (CRC32), dCP disabled.", FTI_WARN);
+        if ( (FTI_Conf->dcpMode < FTI_DCP_MODE_MD5) || (FTI_Conf->dcpMode > FTI_DCP_MODE_XXH64) ) {
+            FTI_Print("dCP mode ('Basic:dcp_mode') must be 1 (MD5), 2 (CRC32), 3 (CRC32C) or 4 (XXH64), dCP disabled.", FTI_WARN);
             FTI_Conf->dcpEnabled = false;
             goto CHECK_DCP_SETTING_END;
         }
@@ -338,6 +411,10 @@ int FTI_TestConfig(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
             FTI_Conf->dcpEnabled = false;
             goto CHECK_DCP_SETTING_END;
         }
+        if ( FTI_Conf->dcpThreads < 1 ) {
+            FTI_Print("Number of dCP threads ('Advanced:dcp_threads') must be at least 1. Set to 1.", FTI_WARN);
+            FTI_Conf->dcpThreads = 1;
+        }
         if (FTI_Ckpt[4].ckptDcpIntv > 0 && !(FTI_Conf->dcpEnabled)) {
             FTI_Print( "L4 dCP interval set, but, dCP is disabled! Setting will be ignored.", FTI_WARN );
             FTI_Ckpt[4].ckptDcpIntv = 0;
@@ -373,6 +450,19 @@ CHECK_DCP_SETTING_END:
             return FTI_NSCS;
         }
     }
+    if (FTI_Conf->asyncDepth < 1) {
+        FTI_Print("Async. depth ('Advanced:async_depth') must be at least 1. Set to 1.", FTI_WARN);
+        FTI_Conf->asyncDepth = 1;
+    }
+    if (FTI_Conf->asyncDepth > 1 && FTI_Topo->nbHeads != 1) {
+        FTI_Print("Async. depth > 1 needs a head, set to 1.", FTI_WARN);
+        FTI_Conf->asyncDepth = 1;
+    }
+    if (FTI_Conf->asyncDepth > 1 && FTI_Conf->dcpEnabled) {
+        // the dCP files are updated in place, a new dCP checkpoint cannot overlap the flush
+        FTI_Print("Async. depth > 1 cannot be combined with dCP, set to 1.", FTI_WARN);
+        FTI_Conf->asyncDepth = 1;
+    }
     if (FTI_Exec->syncIterMax < 0) {
         FTI_Exec->syncIterMax = 512;
         FTI_Print("Variable 'Basic:max_sync_intv' is not set. Set to default (512 iterations).", FTI_WARN);
@@ -424,6 +514,26 @@ CHECK_DCP_SETTING_END:
             break;
 
     }
+
+    // check compression settings only if compression is enabled
+    if ( FTI_Conf->compMode != FTI_COMP_NONE ) {
+        if ( (FTI_Conf->compMode < FTI_COMP_LZ) || (FTI_Conf->compMode > FTI_COMP_ZLIB) ) {
+            FTI_Print("Compression ('Basic:ckpt_compress') must be 0 (none), 1 (LZ) or 2 (zlib), compression disabled.", FTI_WARN);
+            FTI_Conf->compMode = FTI_COMP_NONE;
+        } else if ( FTI_Conf->ioMode != FTI_IO_FTIFF ) {
+            FTI_Print("Compression may only be used with FTI-FF enabled, compression disabled.", FTI_WARN);
+            FTI_Conf->compMode = FTI_COMP_NONE;
+        } else if ( FTI_Conf->dcpEnabled ) {
+            FTI_Print("Compression cannot be combined with dCP, compression disabled.", FTI_WARN);
+            FTI_Conf->compMode = FTI_COMP_NONE;
+        }
+#ifdef FTI_NOZLIB
+        if ( FTI_Conf->compMode == FTI_COMP_ZLIB ) {
+            FTI_Print("FTI was built without zlib, using the built-in LZ compression instead.", FTI_WARN);
+            FTI_Conf->compMode = FTI_COMP_LZ;
+        }
+#endif
+    }
     
     // check variate processor restart settings
     if( FTI_Exec->reco == 3 ) {
@@ -541,7 +651,6 @@ int FTI_CreateDirs(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
     snprintf(FTI_Conf->metadDir, FTI_BUFS, "%s", fn);
-    snprintf(FTI_Conf->mTmpDir, FTI_BUFS, "%s/tmp", fn);
     snprintf(FTI_Ckpt[1].metaDir, FTI_BUFS, "%s/l1", fn);
     snprintf(FTI_Ckpt[2].metaDir, FTI_BUFS, "%s/l2", fn);
     snprintf(FTI_Ckpt[3].metaDir, FTI_BUFS, "%s/l3", fn);
@@ -555,9 +664,11 @@ int FTI_CreateDirs(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             FTI_Print("Cannot create global checkpoint timestamp directory", FTI_EROR);
         }
     }
-    snprintf(FTI_Conf->gTmpDir, FTI_BUFS, "%s/tmp", FTI_Conf->glbalDir);
     snprintf(FTI_Ckpt[4].dcpDir, FTI_BUFS, "%s/dCP", FTI_Conf->glbalDir);
     snprintf(FTI_Ckpt[4].dcpName, FTI_BUFS, "dCPFile-Rank%d.fti", FTI_Topo->myRank);
+    if (FTI_Conf->ioMode == FTI_IO_MPI) { //MPI-IO shares one dCP file
+        snprintf(FTI_Ckpt[4].dcpName, FTI_BUFS, "dCPFile-mpiio.fti");
+    }
     snprintf(FTI_Ckpt[4].dir, FTI_BUFS, "%s/l4", FTI_Conf->glbalDir);
     snprintf(FTI_Ckpt[4].archDir, FTI_BUFS, "%s/l4_archive", FTI_Conf->glbalDir);
     if ( FTI_Conf->keepL4Ckpt ) {
@@ -588,14 +699,38 @@ int FTI_CreateDirs(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             FTI_Print("Cannot create local checkpoint timestamp directory", FTI_EROR);
         }
     }
-    snprintf(FTI_Conf->lTmpDir, FTI_BUFS, "%s/tmp", FTI_Conf->localDir);
     snprintf(FTI_Ckpt[1].dir, FTI_BUFS, "%s/l1", FTI_Conf->localDir);
     snprintf(FTI_Ckpt[1].dcpDir, FTI_BUFS, "%s/dCP", FTI_Conf->localDir);
     snprintf(FTI_Ckpt[2].dir, FTI_BUFS, "%s/l2", FTI_Conf->localDir);
     snprintf(FTI_Ckpt[3].dir, FTI_BUFS, "%s/l3", FTI_Conf->localDir);
+    FTI_SetTmpDirs(FTI_Conf, 0);
     return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It sets the temporary directories of a checkpoint generation.
+  @param      FTI_Conf        Configuration metadata.
+  @param      gen             Generation (0 to Advanced:async_depth - 1).
+
+  Each checkpoint that is post-processed while older checkpoints are still
+  processed by the head is written to its own set of temporary directories
+  ('tmp' for generation 0, 'tmp<gen>' otherwise). They are renamed to the
+  level directories only once the post-processing is completed.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_SetTmpDirs(FTIT_configuration* FTI_Conf, int gen)
+{
+    char sfx[16] = "";
+    if (gen > 0) {
+        snprintf(sfx, sizeof(sfx), "%d", gen);
+    }
+    snprintf(FTI_Conf->mTmpDir, FTI_BUFS, "%s/tmp%s", FTI_Conf->metadDir, sfx);
+    snprintf(FTI_Conf->gTmpDir, FTI_BUFS, "%s/tmp%s", FTI_Conf->glbalDir, sfx);
+    snprintf(FTI_Conf->lTmpDir, FTI_BUFS, "%s/tmp%s", FTI_Conf->localDir, sfx);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It reads and tests the configuration given.
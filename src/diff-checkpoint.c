@@ -96,6 +96,29 @@ const uint32_t crc32_tab[] = {
 static bool* dcpEnabled = NULL;
 static int                  DCP_MODE = 0;
 static dcpBLK_t             DCP_BLOCK_SIZE = 1;
+static int                  DCP_THREADS = 1;
+
+/** Blocks hashed in advance by 'FTI_ComputeDcpHashes'                                 */
+
+static FTIT_DataDiffHash*   dcpHashedVar = NULL;
+static long                 dcpHashedFirst = 0;
+static long                 dcpHashedCount = 0;
+static bool*                dcpHashedDirty = NULL;
+static long                 dcpHashedAlloc = 0;
+
+/** Minimal number of blocks per thread for the parallel hashing                       */
+
+#define DCP_MIN_BLOCKS_THREAD 64
+
+/** 
+ * @brief job description of the parallel hashing. 
+ **/
+typedef struct FTIT_dcpHashJob {
+    FTIT_DataDiffHash* hashes;          /**< Hash meta data of the region   */
+    unsigned char*  ptr;                /**< Address of block 'first'       */
+    long            first;              /**< First block index              */
+    long            count;              /**< Number of blocks               */
+} FTIT_dcpHashJob;
 
 const char* hashType[] = {
     "NEW HASH",
@@ -123,8 +146,10 @@ const char* hashType[] = {
   @param      FTIT_DataDiffHash hashes data which need to be initialized.
   @return     integer         FTI_SCES if successful.
 
-  This function allocates the structures for the next hash which will be created
-  during this checkpoint round
+  This function provides the structures for the next hash which will be created
+  during this checkpoint round. The hash tables are kept across checkpoints, 
+  the next table is the one that was current before the last checkpoint. It is
+  only reallocated if the number of hashes of the data chunk changed.
  **/
 /*-------------------------------------------------------------------------*/
 
@@ -133,40 +158,52 @@ int FTI_InitNextHashData(FTIT_DataDiffHash *hashes){
     if ( !dcpEnabled )
         return FTI_SCES;
 
-    if ( !dcpEnabled )
-        return FTI_SCES;
-
     if (hashes->nbHashes == 0){
         FTI_Print("THIS SHOULD NEVER HAPPEN",FTI_EROR);
     }
 
+    int next = NEXT(hashes);
+    void *check = NULL;
 
     if (FTI_GetDcpMode() == FTI_DCP_MODE_MD5 ){
-        if ( hashes->md5hash[NEXT(hashes)] != NULL){
-            FTI_Print("The next hash table should be always NULL before initializing it",FTI_EROR);
+        if ( hashes->md5hash[next] != NULL && hashes->nbAlloc[next] == hashes->nbHashes ){
+            return FTI_SCES;
         }
 
-        hashes->md5hash[NEXT(hashes)] = (unsigned char *) malloc (sizeof(unsigned char) * MD5_DIGEST_LENGTH * hashes->nbHashes);
+        check = realloc (hashes->md5hash[next], sizeof(unsigned char) * MD5_DIGEST_LENGTH * hashes->nbHashes);
+        if (!check){
+            FTI_Print("Could Not Allocate memory for hashes",FTI_EROR);
+            return FTI_NSCS;
+        }
+        hashes->md5hash[next] = (unsigned char *) check;
+    }
+    else if (FTI_GetDcpMode() == FTI_DCP_MODE_XXH64 ){
+        if ( hashes->bit64hash[next] != NULL && hashes->nbAlloc[next] == hashes->nbHashes ){
+            return FTI_SCES;
+        }
 
-        if (!hashes->md5hash[NEXT(hashes)]){
+        check = realloc (hashes->bit64hash[next], sizeof(uint64_t)* hashes->nbHashes);
+        if (!check){
             FTI_Print("Could Not Allocate memory for hashes",FTI_EROR);
             return FTI_NSCS;
         }
-        return FTI_SCES;
+        hashes->bit64hash[next] = (uint64_t*) check;
     }
     else{
-        if ( hashes->bit32hash[NEXT(hashes)] != NULL){
-            FTI_Print("The next hash table should be always NULL before initializing it",FTI_EROR);
+        if ( hashes->bit32hash[next] != NULL && hashes->nbAlloc[next] == hashes->nbHashes ){
+            return FTI_SCES;
         }
 
-        hashes->bit32hash[NEXT(hashes)] = (uint32_t*) malloc (sizeof(uint32_t)* hashes->nbHashes);
-        if (!hashes->bit32hash[NEXT(hashes)]){
+        check = realloc (hashes->bit32hash[next], sizeof(uint32_t)* hashes->nbHashes);
+        if (!check){
             FTI_Print("Could Not Allocate memory for hashes",FTI_EROR);
             return FTI_NSCS;
         }
-
-        return FTI_SCES;
+        hashes->bit32hash[next] = (uint32_t*) check;
     }
+    hashes->nbAlloc[next] = hashes->nbHashes;
+
+    return FTI_SCES;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -194,6 +231,16 @@ int FTI_FreeDataDiff( FTIT_DataDiffHash *dhash){
             dhash->md5hash[1] = NULL;
         }
     }
+    else if (FTI_GetDcpMode() == FTI_DCP_MODE_XXH64 ){
+        if ( dhash->bit64hash[0] ){
+            free ( dhash->bit64hash[0] );
+            dhash->bit64hash[0]= NULL;
+        }
+        if ( dhash->bit64hash[1] ){
+            free ( dhash->bit64hash[1] );
+            dhash->bit64hash[1]= NULL;
+        }
+    }
     else{
         if ( dhash->bit32hash[0] ){
             free ( dhash->bit32hash[0] );
@@ -204,6 +251,8 @@ int FTI_FreeDataDiff( FTIT_DataDiffHash *dhash){
             dhash->bit32hash[1]= NULL;
         }
     }
+    dhash->nbAlloc[0] = 0;
+    dhash->nbAlloc[1] = 0;
 
     free(dhash->blockSize);
     dhash->blockSize= NULL;
@@ -218,6 +267,7 @@ int FTI_FreeDataDiff( FTIT_DataDiffHash *dhash){
   @brief      Finalizes dCP
   @param      FTI_Conf        Configuration metadata.
   @param      FTI_Exec        Execution metadata.
+  @param      FTI_Data        Dataset metadata.
   @return     integer         FTI_SCES if successful.
 
   This function deallocates structures used for dCP and exposes the 
@@ -225,8 +275,10 @@ int FTI_FreeDataDiff( FTIT_DataDiffHash *dhash){
   dCP creation.
  **/
 /*-------------------------------------------------------------------------*/
-int FTI_FinalizeDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec ) 
+int FTI_FinalizeDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data ) 
 {
+    FTI_FreeDataDcpHashes( FTI_Exec, FTI_Data );
+
     // nothing to do, no ckpt was taken.
     if ( FTI_Exec->firstdb == NULL ) {
         FTI_Conf->dcpEnabled = false;
@@ -248,6 +300,11 @@ int FTI_FinalizeDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec )
     }
     while ( (currentDB = currentDB->next) != NULL );
 
+    FTI_ClearDcpHashes();
+    free( dcpHashedDirty );
+    dcpHashedDirty = NULL;
+    dcpHashedAlloc = 0;
+
     // disable dCP
     FTI_Conf->dcpEnabled = false;
 
@@ -275,8 +332,8 @@ int FTI_InitDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_da
 
     if( getenv("FTI_DCP_HASH_MODE") != 0 ) {
         DCP_MODE = atoi(getenv("FTI_DCP_HASH_MODE")) + FTI_DCP_MODE_OFFSET;
-        if ( (DCP_MODE < FTI_DCP_MODE_MD5) || (DCP_MODE > FTI_DCP_MODE_CRC32) ) {
-            FTI_Print("dCP mode ('Basic:dcp_mode') must be either 1 (MD5) or 2 (CRC32), dCP disabled.", FTI_WARN);
+        if ( (DCP_MODE < FTI_DCP_MODE_MD5) || (DCP_MODE > FTI_DCP_MODE_XXH64) ) {
+            FTI_Print("dCP mode ('Basic:dcp_mode') must be 1 (MD5), 2 (CRC32), 3 (CRC32C) or 4 (XXH64), dCP disabled.", FTI_WARN);
             FTI_Conf->dcpEnabled = false;
             return FTI_NSCS;
         }
@@ -299,6 +356,9 @@ int FTI_InitDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_da
         DCP_BLOCK_SIZE = (dcpBLK_t) FTI_Conf->dcpBlockSize;
     }
 
+    // the CRC32C tables must be ready before the hashing threads start
+    FTI_HashInit();
+
     switch (DCP_MODE) {
         case FTI_DCP_MODE_MD5:
             FTI_Print( "Hash algorithm in use is MD5.", FTI_IDCP );
@@ -306,6 +366,13 @@ int FTI_InitDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_da
         case FTI_DCP_MODE_CRC32:
             FTI_Print( "Hash algorithm in use is CRC32.", FTI_IDCP );
             break;
+        case FTI_DCP_MODE_CRC32C:
+            snprintf( str, FTI_BUFS, "Hash algorithm in use is CRC32C (%s).", FTI_Crc32cKernelName() );
+            FTI_Print( str, FTI_IDCP );
+            break;
+        case FTI_DCP_MODE_XXH64:
+            FTI_Print( "Hash algorithm in use is XXH64.", FTI_IDCP );
+            break;
         default:
             FTI_Print("Hash mode not recognized, dCP disabled!", FTI_WARN);
             FTI_Conf->dcpEnabled = false;
@@ -314,6 +381,12 @@ int FTI_InitDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_da
     snprintf( str, FTI_BUFS, "dCP hash block size is %d bytes.", DCP_BLOCK_SIZE);
     FTI_Print( str, FTI_IDCP ); 
 
+    DCP_THREADS = FTI_Conf->dcpThreads;
+    if ( DCP_THREADS > 1 ) {
+        snprintf( str, FTI_BUFS, "dCP blocks are hashed by %d threads.", DCP_THREADS);
+        FTI_Print( str, FTI_IDCP ); 
+    }
+
     dcpEnabled = &(FTI_Conf->dcpEnabled);
 
     return FTI_SCES;
@@ -432,6 +505,10 @@ int FTI_InitBlockHashArray( FTIFF_dbvar* dbvar )
     hashes->md5hash[1] = NULL;
     hashes->bit32hash[0] = NULL;
     hashes->bit32hash[1] = NULL;
+    hashes->bit64hash[0] = NULL;
+    hashes->bit64hash[1] = NULL;
+    hashes->nbAlloc[0] = 0;
+    hashes->nbAlloc[1] = 0;
 
     // This will be done when start calculate the hash codes themselfes.
     // I only allocate memory for the data regarding the status of the dataset. 
@@ -482,8 +559,9 @@ int FTI_InitBlockHashArray( FTIFF_dbvar* dbvar )
   This function re-allocates memory for the 'dataDiffHash' inValid and blockSize member
   of the  data hash structure and if dCP 
 CAUTION: This function does not reallocate the actual hashes of the data struct.
-When the checkpoint will terminate the current hash will be freed, whereas the next 
-will be used as current. Keep in mind that the next has the correct size
+The next hash table is resized by 'FTI_InitNextHashData' during the following
+checkpoint and becomes the current one afterwards. Keep in mind that only the next 
+has the correct size
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_CollapseBlockHashArray( FTIT_DataDiffHash* hashes, long chunkSize) 
@@ -546,8 +624,9 @@ int FTI_CollapseBlockHashArray( FTIT_DataDiffHash* hashes, long chunkSize)
   of the  data hash structure and if dCP 
 
 CAUTION: This function does not reallocate the actual hashes of the data struct.
-When the checkpoint will terminate the current hash will be freed, whereas the next 
-will be used as current. Keep in mind that the next has the correct size
+The next hash table is resized by 'FTI_InitNextHashData' during the following
+checkpoint and becomes the current one afterwards. Keep in mind that only the next 
+has the correct size
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_ExpandBlockHashArray( FTIT_DataDiffHash* dataHash, long chunkSize ) 
@@ -658,7 +737,8 @@ void PrintDataHashInfo( FTIT_DataDiffHash* dataHash, long chunkSize, int id){
   @brief      Checks if data block is dirty, clean or invalid.
   @param      hashIdx         index for hash meta data in data chunk 
   meta data.
-  @param      dbvar           Data chunk meta data.
+  @param      hashes          Hash meta data of the data chunk.
+  @param      ptr             Address of the data block.
   @return     integer         0 if data block is clean.
   @return     integer         1 if data block is dirty or invalid.
   @return     integer         -1 if hashIdx not in range.
@@ -669,16 +749,15 @@ void PrintDataHashInfo( FTIT_DataDiffHash* dataHash, long chunkSize, int id){
   It returns -1 if hashIdx is out of range.
  **/
 /*-------------------------------------------------------------------------*/
-int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr )
+int FTI_HashCmp( long hashIdx, FTIT_DataDiffHash* hashes, unsigned char *ptr )
 {
 
     bool clean = true;
-    uint32_t bit32hashNow;
+    uint32_t bit32hashNow = 0;
+    uint64_t bit64hashNow = 0;
     unsigned char *prevHash;
     unsigned char *nextHash;
 
-    FTIT_DataDiffHash* hashes = dbvar->dataDiffHash; 
-    //  unsigned char* ptr = (unsigned char*) dbvar->cptr + hashIdx * DCP_BLOCK_SIZE;
 
     assert( !(hashIdx > hashes->nbHashes) );
 
@@ -687,18 +766,33 @@ int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr )
         return -1;
     }
 
-    // I Compute the hash code for the upcoming checkpoint On the Next status
-    if ( FTI_GetDcpMode() == FTI_DCP_MODE_MD5 ){
-        MD5( ptr, hashes->blockSize[hashIdx] , &(hashes->md5hash[NEXT(hashes)][MD5_DIGEST_LENGTH * hashIdx]));
+    // block already hashed by the thread pool
+    if ( hashes == dcpHashedVar && hashIdx >= dcpHashedFirst && hashIdx < dcpHashedFirst + dcpHashedCount ) {
+        return dcpHashedDirty[hashIdx - dcpHashedFirst];
     }
-    else{
+
+    // I Compute the hash code for the upcoming checkpoint On the Next status
+    switch ( DCP_MODE ) {
+        case FTI_DCP_MODE_MD5:
+            MD5( ptr, hashes->blockSize[hashIdx] , &(hashes->md5hash[NEXT(hashes)][MD5_DIGEST_LENGTH * hashIdx]));
+            break;
+        case FTI_DCP_MODE_CRC32:
 #ifdef FTI_NOZLIB
-        bit32hashNow = crc32( ptr, hashes->blockSize[hashIdx] );
+            bit32hashNow = crc32( ptr, hashes->blockSize[hashIdx] );
 #else
-        bit32hashNow = crc32( 0L, Z_NULL, 0 );
-        bit32hashNow = crc32( bit32hashNow, ptr, hashes->blockSize[hashIdx] );
+            bit32hashNow = crc32( 0L, Z_NULL, 0 );
+            bit32hashNow = crc32( bit32hashNow, ptr, hashes->blockSize[hashIdx] );
 #endif
-        hashes->bit32hash[NEXT(hashes)][hashIdx] = bit32hashNow;
+            hashes->bit32hash[NEXT(hashes)][hashIdx] = bit32hashNow;
+            break;
+        case FTI_DCP_MODE_CRC32C:
+            bit32hashNow = FTI_Crc32c( ptr, hashes->blockSize[hashIdx] );
+            hashes->bit32hash[NEXT(hashes)][hashIdx] = bit32hashNow;
+            break;
+        case FTI_DCP_MODE_XXH64:
+            bit64hashNow = FTI_Xxh64( ptr, hashes->blockSize[hashIdx], 0 );
+            hashes->bit64hash[NEXT(hashes)][hashIdx] = bit64hashNow;
+            break;
     }
 
     clean = 0;
@@ -712,8 +806,12 @@ int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr )
                 clean = memcmp(nextHash , prevHash , MD5_DIGEST_LENGTH) == 0;
                 break;
             case FTI_DCP_MODE_CRC32:
+            case FTI_DCP_MODE_CRC32C:
                 clean = (bit32hashNow == hashes->bit32hash[CURRENT(hashes)][hashIdx]);
                 break;
+            case FTI_DCP_MODE_XXH64:
+                clean = (bit64hashNow == hashes->bit64hash[CURRENT(hashes)][hashIdx]);
+                break;
         }
         //isValid is false, in the case in which I dont manage to update 
         //the checkpoint, this memory region will be marked as invalid and therefore
@@ -728,6 +826,113 @@ int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr )
 
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Thread pool function hashing a part of the blocks.
+  @param      arg             Pointer to the job.
+  @param      tid             Thread id.
+  @param      nbThreads       Number of threads.
+
+  Each thread hashes a contiguous range of blocks and stores the result
+  of 'FTI_HashCmp' for each block. A range has at least
+  DCP_MIN_BLOCKS_THREAD blocks, the remaining threads return without work.
+  The hash tables and the flags are written at distinct indices, thus, no
+  locking is required.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_DcpHashWorker( void* arg, int tid, int nbThreads )
+{
+    FTIT_dcpHashJob* job = (FTIT_dcpHashJob*) arg;
+    // every thread hashes at least DCP_MIN_BLOCKS_THREAD blocks
+    long nbSlices = job->count / DCP_MIN_BLOCKS_THREAD;
+    if ( nbSlices < nbThreads ) {
+        nbThreads = nbSlices;
+    }
+    if ( tid >= nbThreads ) 
+        return;
+    long perThread = (job->count + nbThreads - 1) / nbThreads;
+    long start = perThread * tid;
+    long end = ( start + perThread > job->count ) ? job->count : start + perThread;
+    long i;
+    for ( i = start; i < end; i++ ) {
+        unsigned char* ptr = job->ptr + i * DCP_BLOCK_SIZE;
+        dcpHashedDirty[i] = FTI_HashCmp( job->first + i, job->hashes, ptr ) != 0;
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Hashes the blocks of a memory region in parallel.
+  @param      hashes          Hash meta data of the data chunk.
+  @param      ptr             Address of the region.
+  @param      offset          Offset of the region in the data chunk.
+  @param      nbytes          Size of the region.
+  @return     integer         FTI_SCES if successful.
+
+  If more than one dCP thread is configured, the hashes of all blocks of
+  the region are computed on the thread pool before the region is written.
+  'FTI_HashCmp' then returns the stored results and 'FTI_ReceiveDataChunk'
+  only has to merge the dirty blocks. The offset must be a multiple of
+  the dCP block size. The results are discarded with
+  'FTI_ClearDcpHashes' after the region has been processed.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_ComputeDcpHashes( FTIT_DataDiffHash* hashes, unsigned char* ptr, size_t offset, size_t nbytes )
+{
+    FTI_ClearDcpHashes();
+
+    if ( !dcpEnabled || !(*dcpEnabled) || DCP_THREADS < 2 ) 
+        return FTI_SCES;
+
+    if ( hashes == NULL || nbytes == 0 )
+        return FTI_SCES;
+
+    long first = offset / DCP_BLOCK_SIZE;
+    long count = FTI_CalcNumHashes( nbytes );
+    if ( first + count > hashes->nbHashes ) {
+        FTI_Print( "FTI_ComputeDcpHashes :: region exceeds the data chunk, blocks are hashed serially.", FTI_WARN );
+        return FTI_NSCS;
+    }
+    if ( count < 2 * DCP_MIN_BLOCKS_THREAD ) 
+        return FTI_SCES;
+
+    if ( count > dcpHashedAlloc ) {
+        bool* check = (bool*) realloc( dcpHashedDirty, sizeof(bool) * count );
+        if ( check == NULL ) {
+            FTI_Print( "FTI_ComputeDcpHashes :: unable to allocate memory, blocks are hashed serially.", FTI_WARN );
+            return FTI_NSCS;
+        }
+        dcpHashedDirty = check;
+        dcpHashedAlloc = count;
+    }
+
+    FTIT_dcpHashJob job;
+    job.hashes = hashes;
+    job.ptr = ptr;
+    job.first = first;
+    job.count = count;
+
+    FTI_RunThreadPool( FTI_GetThreadPool( DCP_THREADS ), FTI_DcpHashWorker, &job );
+    dcpHashedFirst = first;
+    dcpHashedCount = count;
+    dcpHashedVar = hashes;
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Discards the hashes computed by 'FTI_ComputeDcpHashes'.
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_ClearDcpHashes() 
+{
+    dcpHashedVar = NULL;
+    dcpHashedFirst = 0;
+    dcpHashedCount = 0;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Updates data chunk hash meta data.
@@ -736,15 +941,29 @@ int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr )
   @return     integer         FTI_SCES if successful.
 
   This function updates the hashes of data blocks that were identified as
-  dirty and initializes the hashes for data blocks that are invalid.
+  dirty and initializes the hashes for data blocks that are invalid. The
+  hashes of the protected variables (POSIX and MPI-IO) are updated as well.
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_UpdateDcpChanges(FTIT_dataset* FTI_Data, FTIT_execution* FTI_Exec) 
 {
+    int i;
+    for(i=0; i<FTI_Exec->nbVar; i++) {
+        FTIT_DataDiffHash* hashInfo = FTI_Data[i].dcpHash;
+        if( hashInfo != NULL ) {
+            memset(hashInfo->isValid, true, hashInfo->nbHashes); 
+            hashInfo->currentId = (hashInfo->currentId +1)%2;
+            hashInfo->lifetime++;
+        }
+    }
+
     FTIFF_db *db = FTI_Exec->firstdb;
     FTIFF_dbvar *dbvar;
     int dbvar_idx, dbcounter=0;
     int isnextdb;
+    if ( db == NULL ) {
+        return FTI_SCES;
+    }
     do {
         isnextdb = 0;
         for(dbvar_idx=0;dbvar_idx<db->numvars;dbvar_idx++) {
@@ -752,19 +971,8 @@ int FTI_UpdateDcpChanges(FTIT_dataset* FTI_Data, FTIT_execution* FTI_Exec)
             FTIT_DataDiffHash* hashInfo = dbvar->dataDiffHash;
             if(dbvar->hascontent) {
                 memset(hashInfo->isValid, true, hashInfo->nbHashes); 
-                // I need to free current hash table
-                if (FTI_GetDcpMode() == FTI_DCP_MODE_MD5){
-                    if ( hashInfo->md5hash[CURRENT(hashInfo)] != NULL ){
-                        free (hashInfo->md5hash[CURRENT(hashInfo)]);
-                        hashInfo->md5hash[CURRENT(hashInfo)] = NULL;
-                    }
-                }
-                else{
-                    if ( hashInfo->bit32hash[CURRENT(hashInfo)] != NULL ){
-                        free (hashInfo->bit32hash[CURRENT(hashInfo)]);
-                        hashInfo->bit32hash[CURRENT(hashInfo)] = NULL;
-                    }
-                }
+                // the current hash table is kept and reused as next table 
+                // during the following checkpoint.
                 hashInfo->currentId = (hashInfo->currentId +1)%2;
                 hashInfo->lifetime++;
             }
@@ -836,7 +1044,7 @@ int FTI_ReceiveDataChunk(unsigned char** buffer_addr, size_t* buffer_size, FTIFF
     unsigned char clean = 1;
     int cleanIdx = hashIdx;
     while( hashIdx < maxNumHashes && clean ){
-        clean = FTI_HashCmp( hashIdx, dbvar, ptr ) == 0;
+        clean = FTI_HashCmp( hashIdx, dbvar->dataDiffHash, ptr ) == 0;
         ptr += (clean) * (dbvar->dataDiffHash->blockSize[hashIdx]);
         (*totalBytes) -= (clean) * (dbvar->dataDiffHash->blockSize[hashIdx]);
         hashIdx += (clean) *1;
@@ -859,7 +1067,7 @@ int FTI_ReceiveDataChunk(unsigned char** buffer_addr, size_t* buffer_size, FTIFF
     int dirtyIdx = hashIdx;
 
     while ( hashIdx < maxNumHashes && dirty){
-        dirty = FTI_HashCmp(hashIdx, dbvar, ptr);
+        dirty = FTI_HashCmp(hashIdx, dbvar->dataDiffHash, ptr);
         ptr += (dirty) * (dbvar->dataDiffHash->blockSize[hashIdx]);
         *buffer_size += (dirty) * (dbvar->dataDiffHash->blockSize[hashIdx]);
         (*totalBytes) -= (dirty) * (dbvar->dataDiffHash->blockSize[hashIdx]);
@@ -880,3 +1088,126 @@ int FTI_ReceiveDataChunk(unsigned char** buffer_addr, size_t* buffer_size, FTIFF
     }
     return 1;
 }
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Prepares the hash meta data of a protected variable.
+  @param      data            Dataset metadata.
+  @param      reset           TRUE if the variable moved in the dCP file.
+  @return     integer         FTI_SCES if successful.
+
+  This function is used for the dCP of the POSIX and MPI-IO modes, the
+  hash meta data is kept in the member 'dcpHash' of the dataset. It is
+  created with all blocks invalid if the variable is new, if its size
+  changed or if 'reset' is set. In these cases 'reset' is set on return,
+  since the following variables moved in the dCP file as well. The next
+  hash table is allocated in any case.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_InitDataDcpHash( FTIT_dataset* data, bool* reset )
+{
+    FTIT_DataDiffHash* hashes = data->dcpHash;
+    long nbHashes = FTI_CalcNumHashes( data->size );
+    long lastSize = data->size - (nbHashes - 1) * DCP_BLOCK_SIZE;
+
+    if ( hashes == NULL ) {
+        *reset |= (nbHashes > 0);
+    } else if ( *reset || (hashes->nbHashes != nbHashes) || (hashes->blockSize[nbHashes-1] != lastSize) ) {
+        FTI_FreeDataDiff( hashes );
+        free( hashes );
+        hashes = NULL;
+        data->dcpHash = NULL;
+        *reset = true;
+    }
+
+    // nothing to hash
+    if ( nbHashes == 0 ) {
+        return FTI_SCES;
+    }
+
+    if ( hashes == NULL ) {
+        hashes = (FTIT_DataDiffHash*) calloc( 1, sizeof(FTIT_DataDiffHash) );
+        if ( hashes == NULL ) {
+            FTI_Print( "FTI_InitDataDcpHash - Unable to allocate memory for dcp meta info.", FTI_EROR );
+            return FTI_NSCS;
+        }
+        hashes->creationType = NEWHASH;
+        hashes->nbHashes = nbHashes;
+        hashes->isValid = (bool*) calloc( nbHashes, sizeof(bool) );
+        hashes->blockSize = (unsigned short*) malloc( nbHashes * sizeof(unsigned short) );
+        if ( (hashes->isValid == NULL) || (hashes->blockSize == NULL) ) {
+            FTI_Print( "FTI_InitDataDcpHash - Unable to allocate memory for dcp meta info.", FTI_EROR );
+            FTI_FreeDataDiff( hashes );
+            free( hashes );
+            return FTI_NSCS;
+        }
+        long hashIdx;
+        for ( hashIdx = 0; hashIdx < nbHashes - 1; hashIdx++ ) {
+            hashes->blockSize[hashIdx] = DCP_BLOCK_SIZE;
+        }
+        hashes->blockSize[hashIdx] = lastSize;
+        data->dcpHash = hashes;
+    }
+
+    return FTI_InitNextHashData( hashes );
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Deallocates the hash meta data of the protected variables.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Data        Dataset metadata.
+  @return     integer         FTI_SCES if successful.
+
+  All blocks are written during the next dCP update.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_FreeDataDcpHashes( FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data )
+{
+    int i;
+    for ( i = 0; i < FTI_Exec->nbVar; i++ ) {
+        if ( FTI_Data[i].dcpHash != NULL ) {
+            FTI_FreeDataDiff( FTI_Data[i].dcpHash );
+            free( FTI_Data[i].dcpHash );
+            FTI_Data[i].dcpHash = NULL;
+        }
+    }
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the next dirty region of a protected variable.
+  @param      hashes          Hash meta data of the variable.
+  @param      ptr             Address of the variable.
+  @param      hashIdx         First block to check, updated on return.
+  @param      offset          Offset of the region in the variable.
+  @param      size            Size of the region.
+  @return     integer         1 if a dirty region was found.
+  @return     integer         0 if the remaining blocks are clean.
+
+  Clean blocks are skipped, consecutive dirty or invalid blocks are merged
+  into one region. The hashes of the checked blocks are stored in the next
+  hash table and become the current ones with 'FTI_UpdateDcpChanges'.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_NextDirtyRegion( FTIT_DataDiffHash* hashes, unsigned char* ptr, long* hashIdx,
+        long* offset, long* size )
+{
+    long idx = *hashIdx;
+    *size = 0;
+    for ( ; idx < hashes->nbHashes; idx++ ) {
+        if ( FTI_HashCmp( idx, hashes, ptr + idx * DCP_BLOCK_SIZE ) != 0 ) {
+            if ( *size == 0 ) {
+                *offset = idx * DCP_BLOCK_SIZE;
+            }
+            *size += hashes->blockSize[idx];
+        } else if ( *size > 0 ) {
+            // the clean block is checked already
+            idx++;
+            break;
+        }
+    }
+    *hashIdx = idx;
+    return ( *size > 0 );
+}
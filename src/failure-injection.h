@@ -40,7 +40,8 @@
  *  
  *  - FTI_WritePosix
  *  - FTIFF_WriteFTIFF
- *  - FTI_RecvPtner
+ *  - FTIFF_FlushWrites
+ *  - FTI_ExchangeCkpt
  *  - FTI_RSenc
  *  - FTI_FlushPosix
  *
@@ -70,6 +71,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #include <stdint.h>
 #include <limits.h>
 
@@ -97,6 +99,17 @@ unsigned int FUNCTION( const char *testFunction );
         ERR = write( FD, BUF, COUNT ); \
         (void)(ERR); \
     } while(0)
+#define FTI_FI_PWRITEV( ERR, FD, IOV, IOVCNT, OFFSET, FN ) \
+    do { \
+        if( FUNCTION(__FUNCTION__) ) { \
+            if( get_ruint() < ((uint64_t)((double)PROBABILITY()*INT_MAX)) ) { \
+                close(FD); \
+                FD = open(FN, O_RDONLY); \
+            }  \
+        } \
+        ERR = pwritev( FD, IOV, IOVCNT, OFFSET ); \
+        (void)(ERR); \
+    } while(0)
 #define FTI_FI_FWRITE( ERR, BUF, SIZE, COUNT, FSTREAM, FN ) \
     do { \
         if( FUNCTION(__FUNCTION__) ) { \
@@ -110,6 +123,7 @@ unsigned int FUNCTION( const char *testFunction );
     } while(0)
 #else
 #define FTI_FI_WRITE( ERR, FD, BUF, COUNT, FN ) ( ERR = write( FD, BUF, COUNT ) )
+#define FTI_FI_PWRITEV( ERR, FD, IOV, IOVCNT, OFFSET, FN ) ( ERR = pwritev( FD, IOV, IOVCNT, OFFSET ) )
 #define FTI_FI_FWRITE( ERR, BUF, SIZE, COUNT, FSTREAM, FN ) ( ERR = fwrite( BUF, SIZE, COUNT, FSTREAM ) )
 #endif
 
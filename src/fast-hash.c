@@ -0,0 +1,496 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   fast-hash.c
+ *  @date   October, 2018
+ *  @brief  Non-cryptographic block hashes for the change detection of dCP.
+ *
+ *  CRC32C (Castagnoli polynomial) uses the SSE4.2 or ARMv8 CRC instructions
+ *  if the CPU provides them and a table driven kernel otherwise. All kernels
+ *  compute the standard CRC32C, thus, the hashes do not depend on the
+ *  machine. On x86-64, three independent streams are interleaved and
+ *  combined afterwards, which hides the latency of the 'crc32' instruction.
+ *
+ *  XXH64 is the 64-bit xxHash of Yann Collet, written in portable C. It
+ *  hashes about one word per cycle and needs no CPU specific code.
+ */
+
+#include "interface.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#   define FTI_HASH_X86
+#   include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__) && defined(__linux__)
+#   define FTI_HASH_ARM
+#   include <sys/auxv.h>
+#   ifndef HWCAP_CRC32
+#       define HWCAP_CRC32 (1 << 7)
+#   endif
+#endif
+
+/** CRC32C polynomial (reflected).                                          */
+#define FTI_CRC32C_POLY 0x82f63b78
+/** Stream lengths of the interleaved CRC32C kernel (powers of two).        */
+#define FTI_CRC32C_LONG 8192
+#define FTI_CRC32C_SHORT 256
+
+#define FTI_XXH_PRIME1 11400714785074694791ULL
+#define FTI_XXH_PRIME2 14029467366897019727ULL
+#define FTI_XXH_PRIME3 1609587929392839161ULL
+#define FTI_XXH_PRIME4 9650029242287828579ULL
+#define FTI_XXH_PRIME5 2870177450012600261ULL
+
+typedef uint32_t (*FTIT_crc32cfunc)(const uint8_t* buf, size_t len);
+
+/** 
+ * @brief tables of the CRC32C kernels, computed by 'FTI_HashInit'. 
+ **/
+static uint32_t crc32cTable[8][256];    /**< Slicing-by-8 tables            */
+#ifdef FTI_HASH_X86
+static uint32_t crc32cLong[4][256];     /**< Shift by FTI_CRC32C_LONG bytes */
+static uint32_t crc32cShort[4][256];    /**< Shift by FTI_CRC32C_SHORT bytes*/
+#endif
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Table driven CRC32C (slicing-by-8).
+  @param      buf             Data.
+  @param      len             Data size.
+  @return     uint32_t        CRC32C of the data.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static uint32_t FTI_Crc32cTable(const uint8_t* buf, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+    while (len >= 8) {
+        crc ^= (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+            ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+        crc = crc32cTable[7][crc & 0xff] ^ crc32cTable[6][(crc >> 8) & 0xff] ^
+            crc32cTable[5][(crc >> 16) & 0xff] ^ crc32cTable[4][crc >> 24] ^
+            crc32cTable[3][buf[4]] ^ crc32cTable[2][buf[5]] ^
+            crc32cTable[1][buf[6]] ^ crc32cTable[0][buf[7]];
+        buf += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = crc32cTable[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#ifdef FTI_HASH_X86
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Multiplies a vector with a matrix over GF(2).
+  @param      mat             32x32 matrix (one column per word).
+  @param      vec             Vector.
+  @return     uint32_t        Product.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static uint32_t FTI_Gf2MatrixTimes(const uint32_t* mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Squares a matrix over GF(2).
+  @param      square          Result.
+  @param      mat             Matrix.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_Gf2MatrixSquare(uint32_t* square, const uint32_t* mat)
+{
+    int n;
+    for (n = 0; n < 32; n++) {
+        square[n] = FTI_Gf2MatrixTimes(mat, mat[n]);
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the tables shifting a CRC32C over zero bytes.
+  @param      zeros           Tables to compute.
+  @param      len             Number of zero bytes (power of two).
+
+  Appending 'len' zero bytes to the data is a linear operation on the CRC.
+  Its matrix is obtained by repeated squaring of the operator for one zero
+  bit and split into four tables, one per byte of the CRC.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_Crc32cZeros(uint32_t zeros[4][256], size_t len)
+{
+    uint32_t even[32], odd[32];
+    uint32_t row = 1;
+    int n;
+
+    // operator for one zero bit
+    odd[0] = FTI_CRC32C_POLY;
+    for (n = 1; n < 32; n++) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    FTI_Gf2MatrixSquare(even, odd); //two zero bits
+    FTI_Gf2MatrixSquare(odd, even); //four zero bits
+
+    // the first square gives one zero byte, each further one doubles it
+    uint32_t* op = even;
+    do {
+        FTI_Gf2MatrixSquare(even, odd);
+        op = even;
+        len >>= 1;
+        if (len == 0) {
+            break;
+        }
+        FTI_Gf2MatrixSquare(odd, even);
+        op = odd;
+        len >>= 1;
+    } while (len);
+
+    for (n = 0; n < 256; n++) {
+        zeros[0][n] = FTI_Gf2MatrixTimes(op, n);
+        zeros[1][n] = FTI_Gf2MatrixTimes(op, n << 8);
+        zeros[2][n] = FTI_Gf2MatrixTimes(op, n << 16);
+        zeros[3][n] = FTI_Gf2MatrixTimes(op, (uint32_t)n << 24);
+    }
+}
+
+static inline uint32_t FTI_Crc32cShift(uint32_t zeros[4][256], uint32_t crc)
+{
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+        zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Interleaves three CRC32C streams of 'len' bytes each.
+  @param      crc0            CRC of the data before the first stream.
+  @param      next            Start of the first stream.
+  @param      len             Stream length.
+  @param      zeros           Shift tables for 'len' bytes.
+  @return     uint64_t        CRC of the data up to the end of the streams.
+
+ **/
+/*-------------------------------------------------------------------------*/
+__attribute__((target("sse4.2")))
+static inline uint64_t FTI_Crc32cSse42Streams(uint64_t crc0, const uint8_t* next,
+        size_t len, uint32_t zeros[4][256])
+{
+    uint64_t crc1 = 0, crc2 = 0, w0, w1, w2;
+    const uint8_t* end = next + len;
+    do {
+        memcpy(&w0, next, 8);
+        memcpy(&w1, next + len, 8);
+        memcpy(&w2, next + 2 * len, 8);
+        crc0 = _mm_crc32_u64(crc0, w0);
+        crc1 = _mm_crc32_u64(crc1, w1);
+        crc2 = _mm_crc32_u64(crc2, w2);
+        next += 8;
+    } while (next < end);
+    crc0 = FTI_Crc32cShift(zeros, crc0) ^ crc1;
+    crc0 = FTI_Crc32cShift(zeros, crc0) ^ crc2;
+    return crc0;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      CRC32C with the SSE4.2 'crc32' instruction.
+  @param      buf             Data.
+  @param      len             Data size.
+  @return     uint32_t        CRC32C of the data.
+
+ **/
+/*-------------------------------------------------------------------------*/
+__attribute__((target("sse4.2")))
+static uint32_t FTI_Crc32cSse42(const uint8_t* buf, size_t len)
+{
+    uint64_t crc = 0xffffffff, w;
+
+    while (len >= 3 * FTI_CRC32C_LONG) {
+        crc = FTI_Crc32cSse42Streams(crc, buf, FTI_CRC32C_LONG, crc32cLong);
+        buf += 3 * FTI_CRC32C_LONG;
+        len -= 3 * FTI_CRC32C_LONG;
+    }
+    while (len >= 3 * FTI_CRC32C_SHORT) {
+        crc = FTI_Crc32cSse42Streams(crc, buf, FTI_CRC32C_SHORT, crc32cShort);
+        buf += 3 * FTI_CRC32C_SHORT;
+        len -= 3 * FTI_CRC32C_SHORT;
+    }
+    while (len >= 8) {
+        memcpy(&w, buf, 8);
+        crc = _mm_crc32_u64(crc, w);
+        buf += 8;
+        len -= 8;
+    }
+    while (len--) {
+        crc = _mm_crc32_u8((uint32_t)crc, *buf++);
+    }
+    return ~(uint32_t)crc;
+}
+
+#endif // FTI_HASH_X86
+
+#ifdef FTI_HASH_ARM
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      CRC32C with the ARMv8 CRC instructions.
+  @param      buf             Data.
+  @param      len             Data size.
+  @return     uint32_t        CRC32C of the data.
+
+  The instructions are emitted with an assembler directive, so that the
+  library does not need to be compiled for a CPU with the CRC extension.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static uint32_t FTI_Crc32cArmv8(const uint8_t* buf, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+    uint64_t w;
+    while (len >= 8) {
+        memcpy(&w, buf, 8);
+        __asm__(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(w));
+        buf += 8;
+        len -= 8;
+    }
+    while (len--) {
+        uint32_t b = *buf++;
+        __asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(b));
+    }
+    return ~crc;
+}
+
+#endif // FTI_HASH_ARM
+
+/** 
+ * @brief kernel selected by 'FTI_HashInit'. 
+ **/
+static FTIT_crc32cfunc crc32cKernel = FTI_Crc32cTable;
+static const char* crc32cKernelName = "table";
+static bool hashInitialized = false;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the tables and selects the CRC32C kernel.
+
+  Must be called before the hashes are computed from several threads. The
+  CRC instructions may be disabled with the environment variable
+  'FTI_HASH_DISABLE_HW'.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_HashInit()
+{
+    if (hashInitialized) {
+        return;
+    }
+    hashInitialized = true;
+
+    int n, k;
+    for (n = 0; n < 256; n++) {
+        uint32_t crc = n;
+        for (k = 0; k < 8; k++) {
+            crc = (crc & 1) ? (crc >> 1) ^ FTI_CRC32C_POLY : crc >> 1;
+        }
+        crc32cTable[0][n] = crc;
+    }
+    for (n = 0; n < 256; n++) {
+        for (k = 1; k < 8; k++) {
+            uint32_t crc = crc32cTable[k - 1][n];
+            crc32cTable[k][n] = crc32cTable[0][crc & 0xff] ^ (crc >> 8);
+        }
+    }
+
+    if (getenv("FTI_HASH_DISABLE_HW") != NULL) {
+        return;
+    }
+#ifdef FTI_HASH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        FTI_Crc32cZeros(crc32cLong, FTI_CRC32C_LONG);
+        FTI_Crc32cZeros(crc32cShort, FTI_CRC32C_SHORT);
+        crc32cKernel = FTI_Crc32cSse42;
+        crc32cKernelName = "sse4.2";
+    }
+#endif
+#ifdef FTI_HASH_ARM
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        crc32cKernel = FTI_Crc32cArmv8;
+        crc32cKernelName = "armv8";
+    }
+#endif
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the name of the CRC32C kernel selected by 'FTI_HashInit'.
+  @return     const char*     Kernel name.
+
+ **/
+/*-------------------------------------------------------------------------*/
+const char* FTI_Crc32cKernelName()
+{
+    return crc32cKernelName;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the CRC32C of a buffer.
+  @param      buf             Data.
+  @param      len             Data size.
+  @return     uint32_t        CRC32C of the data.
+
+ **/
+/*-------------------------------------------------------------------------*/
+uint32_t FTI_Crc32c(const void* buf, size_t len)
+{
+    return crc32cKernel((const uint8_t*)buf, len);
+}
+
+static inline uint64_t FTI_XxhRotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t FTI_XxhRead64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+static inline uint32_t FTI_XxhRead32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    v = __builtin_bswap32(v);
+#endif
+    return v;
+}
+
+static inline uint64_t FTI_XxhRound(uint64_t acc, uint64_t input)
+{
+    acc += input * FTI_XXH_PRIME2;
+    acc = FTI_XxhRotl(acc, 31);
+    return acc * FTI_XXH_PRIME1;
+}
+
+static inline uint64_t FTI_XxhMerge(uint64_t acc, uint64_t val)
+{
+    acc ^= FTI_XxhRound(0, val);
+    return acc * FTI_XXH_PRIME1 + FTI_XXH_PRIME4;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the XXH64 hash of a buffer.
+  @param      buf             Data.
+  @param      len             Data size.
+  @param      seed            Seed.
+  @return     uint64_t        XXH64 of the data.
+
+ **/
+/*-------------------------------------------------------------------------*/
+uint64_t FTI_Xxh64(const void* buf, size_t len, uint64_t seed)
+{
+    const uint8_t* p = (const uint8_t*)buf;
+    const uint8_t* end = p + len;
+    uint64_t h64;
+
+    if (len >= 32) {
+        const uint8_t* limit = end - 32;
+        uint64_t v1 = seed + FTI_XXH_PRIME1 + FTI_XXH_PRIME2;
+        uint64_t v2 = seed + FTI_XXH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - FTI_XXH_PRIME1;
+        do {
+            v1 = FTI_XxhRound(v1, FTI_XxhRead64(p));
+            v2 = FTI_XxhRound(v2, FTI_XxhRead64(p + 8));
+            v3 = FTI_XxhRound(v3, FTI_XxhRead64(p + 16));
+            v4 = FTI_XxhRound(v4, FTI_XxhRead64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h64 = FTI_XxhRotl(v1, 1) + FTI_XxhRotl(v2, 7) + FTI_XxhRotl(v3, 12) + FTI_XxhRotl(v4, 18);
+        h64 = FTI_XxhMerge(h64, v1);
+        h64 = FTI_XxhMerge(h64, v2);
+        h64 = FTI_XxhMerge(h64, v3);
+        h64 = FTI_XxhMerge(h64, v4);
+    }
+    else {
+        h64 = seed + FTI_XXH_PRIME5;
+    }
+    h64 += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h64 ^= FTI_XxhRound(0, FTI_XxhRead64(p));
+        h64 = FTI_XxhRotl(h64, 27) * FTI_XXH_PRIME1 + FTI_XXH_PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h64 ^= (uint64_t)FTI_XxhRead32(p) * FTI_XXH_PRIME1;
+        h64 = FTI_XxhRotl(h64, 23) * FTI_XXH_PRIME2 + FTI_XXH_PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h64 ^= (*p) * FTI_XXH_PRIME5;
+        h64 = FTI_XxhRotl(h64, 11) * FTI_XXH_PRIME1;
+        p++;
+    }
+
+    h64 ^= h64 >> 33;
+    h64 *= FTI_XXH_PRIME2;
+    h64 ^= h64 >> 29;
+    h64 *= FTI_XXH_PRIME3;
+    h64 ^= h64 >> 32;
+    return h64;
+}
@@ -217,6 +217,11 @@ int FTIFF_ReadDbFTIFF( FTIT_configuration *FTI_Conf, FTIT_execution *FTI_Exec,
 
       currentdbvar->hasCkpt = true;
 
+      if( FTI_ReallocMetaVars( FTI_Exec, 1, currentdbvar->idx + 1 ) != FTI_SCES ) {
+        munmap( fmmap, fs );
+        errno = 0;
+        return FTI_NSCS;
+      }
       FTI_Exec->meta[FTI_Exec->ckptLvel].varID[currentdbvar->idx] = currentdbvar->id;
       FTI_Exec->meta[FTI_Exec->ckptLvel].varSize[currentdbvar->idx] += currentdbvar->chunksize;            //// init FTI meta data structure
 
@@ -284,6 +289,73 @@ int FTIFF_ReadDbFTIFF( FTIT_configuration *FTI_Conf, FTIT_execution *FTI_Exec,
 
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Decompresses a data chunk from the mapped checkpoint file
+  @param      dbvar           Data chunk meta data.
+  @param      fmmap           Mapped checkpoint file.
+  @param      fs              Size of the mapped file.
+  @param      dest            Destination of the data (NULL -> data is only hashed).
+  @param      isDevice        TRUE if 'dest' is a device pointer.
+  @param      hash            On return, MD5 digest of the decompressed data.
+  @return     integer         FTI_SCES if successful.
+
+  The frames of the chunk are decompressed directly into 'dest' for host
+  memory, else into a frame buffer.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTIFF_ReadCompressedChunk( FTIFF_dbvar *dbvar, unsigned char *fmmap, long fs, 
+    unsigned char *dest, bool isDevice, unsigned char *hash )
+{
+  if ( (long) dbvar->cfptr + dbvar->csize > fs ) {
+    FTI_Print("FTI-FF: ReadCompressedChunk - chunk exceeds the file size.", FTI_WARN);
+    return FTI_NSCS;
+  }
+
+  unsigned char *fbuf = NULL;
+  if ( (dest == NULL) || isDevice ) {
+    fbuf = (unsigned char*) malloc( FTI_COMP_FRAME );
+    if ( fbuf == NULL ) {
+      FTI_Print("FTI-FF: ReadCompressedChunk - failed to allocate the frame buffer.", FTI_EROR);
+      return FTI_NSCS;
+    }
+  }
+
+  MD5_CTX mdContext;
+  MD5_Init( &mdContext );
+
+  unsigned char *src = fmmap + dbvar->cfptr;
+  long avail = dbvar->csize;
+  long done = 0, used, produced;
+  while ( done < dbvar->chunksize ) {
+    unsigned char *out = ( fbuf ) ? fbuf : dest + done;
+    long size = dbvar->chunksize - done;
+    if ( fbuf && ( size > FTI_COMP_FRAME ) ) {
+      size = FTI_COMP_FRAME;
+    }
+    if ( ( FTI_DecompressFrame( dbvar->codec, src, avail, out, size, &used, &produced ) != FTI_SCES ) 
+        || ( produced == 0 ) ) {
+      FTI_Print("FTI-FF: ReadCompressedChunk - corrupted frame in compressed chunk.", FTI_WARN);
+      free( fbuf );
+      return FTI_NSCS;
+    }
+    MD5_Update( &mdContext, out, produced );
+#ifdef GPUSUPPORT
+    if ( dest && isDevice ) {
+      FTI_copy_to_device_async( dest + done, fbuf, produced );
+      FTI_device_sync();
+    }
+#endif
+    src += used;
+    avail -= used;
+    done += produced;
+  }
+  MD5_Final( hash, &mdContext );
+
+  free( fbuf );
+  return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Determines checksum of checkpoint data.
@@ -369,7 +441,14 @@ int FTIFF_GetFileChecksum( FTIFF_metaInfo *FTIFFMeta, FTIT_checkpoint* FTI_Ckpt,
       // (Note: we create the file hash from the chunk hashes due to ICP)
       if( dbvar->hascontent ) {
         unsigned char chash[MD5_DIGEST_LENGTH]; 
-        MD5( fmmap + dbvar->fptr, dbvar->chunksize, chash );
+        if ( dbvar->codec != FTI_COMP_NONE ) {
+          if ( FTIFF_ReadCompressedChunk( dbvar, fmmap, FTIFFMeta->ckptSize, NULL, false, chash ) != FTI_SCES ) {
+            // leads to a checksum mismatch
+            memset( chash, 0x0, MD5_DIGEST_LENGTH );
+          }
+        } else {
+          MD5( fmmap + dbvar->fptr, dbvar->chunksize, chash );
+        }
         MD5_Update( &ctx, chash, MD5_DIGEST_LENGTH );
       }
 
@@ -462,6 +541,9 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
     dbvars->hasCkpt = false;
     dbvars->containerid = 0;
     dbvars->containersize = FTI_Data[pvar_idx].size;
+    dbvars->cfptr = 0;
+    dbvars->csize = 0;
+    dbvars->codec = FTI_COMP_NONE;
     dbvars->cptr = FTI_Data[pvar_idx].ptr;
     // FOR DCP 
     if  ( FTI_Conf->dcpEnabled ) {
@@ -543,7 +625,7 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
               // [FOR DCP] init hash array for block
               if ( FTI_Conf->dcpEnabled ) {
                 if( FTI_InitBlockHashArray( dbvar ) != FTI_SCES ) {
-                  FTI_FinalizeDcp( FTI_Conf, FTI_Exec );
+                  FTI_FinalizeDcp( FTI_Conf, FTI_Exec, FTI_Data );
                 }
               }
             } else {
@@ -569,7 +651,7 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
               // [FOR DCP] init hash array for block
               if ( FTI_Conf->dcpEnabled ) {
                 if( FTI_InitBlockHashArray( dbvar )  != FTI_SCES ) {
-                  FTI_FinalizeDcp( FTI_Conf, FTI_Exec );
+                  FTI_FinalizeDcp( FTI_Conf, FTI_Exec, FTI_Data );
                 }
 
               }
@@ -646,11 +728,14 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
           dbvars[evar_idx].hasCkpt = false;
           dbvars[evar_idx].containerid = 0;
           dbvars[evar_idx].containersize = FTI_Data[pvar_idx].size;
+          dbvars[evar_idx].cfptr = offset;
+          dbvars[evar_idx].csize = 0;
+          dbvars[evar_idx].codec = FTI_COMP_NONE;
           dbsize += dbvars[evar_idx].containersize; 
           dbvars[evar_idx].cptr = FTI_Data[pvar_idx].ptr + dbvars[evar_idx].dptr;
           if ( FTI_Conf->dcpEnabled ) {
             if( FTI_InitBlockHashArray( &(dbvars[evar_idx]) ) != FTI_SCES ) {
-              FTI_FinalizeDcp( FTI_Conf, FTI_Exec );
+              FTI_FinalizeDcp( FTI_Conf, FTI_Exec, FTI_Data );
             }
           }
           dbvars[evar_idx].update = true;
@@ -671,11 +756,14 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
           dbvars[evar_idx].hasCkpt = false;
           dbvars[evar_idx].containerid = nbContainers;
           dbvars[evar_idx].containersize = overflow; 
+          dbvars[evar_idx].cfptr = offset;
+          dbvars[evar_idx].csize = 0;
+          dbvars[evar_idx].codec = FTI_COMP_NONE;
           dbsize += dbvars[evar_idx].containersize; 
           dbvars[evar_idx].cptr = FTI_Data[pvar_idx].ptr + dbvars[evar_idx].dptr;
           if ( FTI_Conf->dcpEnabled ) {
             if( FTI_InitBlockHashArray( &(dbvars[evar_idx]) ) != FTI_SCES ) {
-              FTI_FinalizeDcp( FTI_Conf, FTI_Exec );
+              FTI_FinalizeDcp( FTI_Conf, FTI_Exec, FTI_Data );
             }
           }
           dbvars[evar_idx].update = true;
@@ -702,6 +790,116 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
 
 
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Initializes an empty write batch.
+  @param      batch           Batch to initialize.
+  @param      fd              File descriptor of the checkpoint file.
+  @param      fn              Name of the checkpoint file.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTIFF_InitWriteBatch( FTIFF_writeBatch* batch, int fd, char* fn )
+{
+  batch->fd = fd;
+  batch->fn = fn;
+  batch->offset = 0;
+  batch->size = 0;
+  batch->nbIov = 0;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Writes the queued chunks to the checkpoint file.
+  @param      batch           Batch to write.
+  @return     integer         FTI_SCES if successful.
+
+  The chunks are written with pwritev at the offset of the first chunk.
+  Short writes are resumed where they stopped. The batch is empty on
+  return, also if the write failed.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTIFF_FlushWrites( FTIFF_writeBatch* batch )
+{
+  struct iovec *iov = batch->iov;
+  int nbIov = batch->nbIov;
+  off_t offset = batch->offset;
+  int res = FTI_SCES;
+
+  while ( nbIov > 0 ) {
+    ssize_t written;
+    FTI_FI_PWRITEV( written, batch->fd, iov, nbIov, offset, batch->fn );
+    if ( written == -1 && errno == EINTR ) {
+      continue;
+    }
+    if ( written <= 0 ) {
+      char str[FTI_BUFS];
+      snprintf(str, FTI_BUFS, "FTI-FF: WriteFTIFF - could not write %lu bytes at offset %ld to file: %s",
+          (unsigned long)batch->size, (long)batch->offset, batch->fn);
+      FTI_Print(str, FTI_EROR);
+      errno = 0;
+      res = FTI_NSCS;
+      break;
+    }
+    offset += written;
+    while ( nbIov > 0 && (size_t)written >= iov->iov_len ) {
+      written -= iov->iov_len;
+      iov++;
+      nbIov--;
+    }
+    if ( nbIov > 0 ) {
+      iov->iov_base = (char*)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  batch->size = 0;
+  batch->nbIov = 0;
+  return res;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Queues a chunk to be written to the checkpoint file.
+  @param      batch           Batch the chunk is added to.
+  @param      buf             Data of the chunk.
+  @param      size            Size of the chunk.
+  @param      offset          File offset of the chunk.
+  @return     integer         FTI_SCES if successful.
+
+  A chunk that follows the last queued chunk in the file is added to the
+  batch. Otherwise, or if the batch is full, the batch is written first.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTIFF_QueueWrite( FTIFF_writeBatch* batch, void* buf, size_t size, off_t offset )
+{
+  if ( size == 0 ) {
+    return FTI_SCES;
+  }
+
+  if ( batch->nbIov > 0 ) {
+    if ( offset == batch->offset + (off_t)batch->size && batch->nbIov < FTIFF_IO_DEPTH ) {
+      batch->iov[batch->nbIov].iov_base = buf;
+      batch->iov[batch->nbIov].iov_len = size;
+      batch->nbIov++;
+      batch->size += size;
+      return FTI_SCES;
+    }
+    if ( FTIFF_FlushWrites( batch ) != FTI_SCES ) {
+      return FTI_NSCS;
+    }
+  }
+
+  batch->offset = offset;
+  batch->size = size;
+  batch->iov[0].iov_base = buf;
+  batch->iov[0].iov_len = size;
+  batch->nbIov = 1;
+  return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Writes the data of memory chunk to the appropriate file location. 
@@ -712,79 +910,122 @@ int FTIFF_UpdateDatastructVarFTIFF( FTIT_execution* FTI_Exec,
   @param      currentOffset   offset from the file point where we should write the data 
   @param      fetchedBytes    number of the bytes fetched 
   @param      dcpSize         number of changed bytes 
-  @param      fd              file descriptor
-  @param      fn              file name
+  @param      batch           batch the chunks are queued in
+  @return     integer         FTI_SCES if successful.
   
   This function writes a subset of the data of a dbvar on the checkpointed file. If the 
   data are in the CPU memory the subset is equal to the size of the dbvar otherwise
-  we process smaller chunks of memory (usually equal to 32Mb).
+  we process smaller chunks of memory (usually equal to 32Mb). The (dirty) chunks are
+  queued in the batch, which is flushed here if the data is in the prefetch buffer
+  of the device, as the buffer is reused for the next subset. Dirty chunks that
+  are at most FTIFF_IO_GAP bytes apart are merged into one. The clean blocks in
+  between are identical to the file content, writing them again is cheaper than
+  a separate write.
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_WriteMemFTIFFChunk(FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data, FTIFF_dbvar *currentdbvar, 
-    unsigned char *dptr, size_t currentOffset, size_t fetchedBytes, long *dcpSize, int fd, char *fn){
+    unsigned char *dptr, size_t currentOffset, size_t fetchedBytes, long *dcpSize, FTIFF_writeBatch *batch){
 
-  char str[FTI_BUFS], strerr[FTI_BUFS];
   unsigned char *chunk_addr = NULL;
   size_t chunk_size,chunk_offset;
   size_t remainingBytes = fetchedBytes;
   chunk_size = 0;
   chunk_offset = 0;
 
-  long membs = 1024*1024*16; // 16 MB
-  long cpybuf, cpynow, cpycnt;//, fptr;
-
   uintptr_t fptr = currentdbvar-> fptr + currentOffset;
   uintptr_t fptrTemp = fptr;
   size_t prevRemBytes = remainingBytes;
+  int res = FTI_SCES;
+
+  // pending run of (merged) dirty chunks
+  unsigned char *run_addr = NULL;
+  size_t run_size = 0;
+  uintptr_t run_fptr = 0;
+
+  FTI_ComputeDcpHashes(currentdbvar->dataDiffHash, dptr, currentOffset, fetchedBytes);
 
   while( FTI_ReceiveDataChunk(&chunk_addr, &chunk_size, currentdbvar, FTI_Data, dptr, &remainingBytes) ) {
 
     chunk_offset = chunk_addr - dptr;
     fptr = fptrTemp + chunk_offset;
-    unsigned long DBG_fpos; 
 
-    if ( ( DBG_fpos = lseek( fd, fptr, SEEK_SET ) ) == -1 ) {
-      snprintf(strerr, FTI_BUFS, "FTI-FF: WriteFTIFF - could not seek in file: %s", fn);
-      FTI_Print(strerr, FTI_EROR);
-      errno=0;
-      close(fd);
-      return FTI_NSCS;
-    }  
-
-    cpycnt = 0;
-    while ( cpycnt < chunk_size ) {
-      cpybuf = chunk_size - cpycnt;
-      cpynow = ( cpybuf > membs ) ? membs : cpybuf;
-      long WRITTEN = 0;
-      int try = 0; 
-      do {
-        int returnVal;
-        FTI_FI_WRITE( returnVal, fd,  &chunk_addr[cpycnt], cpynow, fn );
-        if ( returnVal == -1 ) {
-          snprintf(str, FTI_BUFS, "%d FTI-FF: WriteFTIFF - Dataset #%d could not be written to file: %s ",__LINE__, currentdbvar->id, fn);
-          FTI_Print(str, FTI_WARN);
-          close(fd);
-          errno = 0;
-          exit(-1);
-          return FTI_NSCS;
-        }
-        WRITTEN += returnVal;
-        try++;
-      } while ((WRITTEN < cpynow) && (try < 10));
-      assert( WRITTEN == cpynow );
-      cpycnt += WRITTEN;
+    if ( run_size > 0 && fptr - (run_fptr + run_size) <= FTIFF_IO_GAP ) {
+      run_size = fptr + chunk_size - run_fptr;
+    } else {
+      if ( res == FTI_SCES ) {
+        res = FTIFF_QueueWrite( batch, run_addr, run_size, run_fptr );
+      }
+      run_addr = chunk_addr;
+      run_size = chunk_size;
+      run_fptr = fptr;
     }
     (*dcpSize) += chunk_size;
-    assert(cpycnt == chunk_size);
     dptr += (prevRemBytes-remainingBytes);
     prevRemBytes = remainingBytes;
     fptrTemp += chunk_offset + chunk_size;
   }
-  assert(remainingBytes == 0); 
+  FTI_ClearDcpHashes();
+
+  if ( res == FTI_SCES ) {
+    res = FTIFF_QueueWrite( batch, run_addr, run_size, run_fptr );
+  }
+  if ( res == FTI_SCES && FTI_Data[currentdbvar->idx].isDevicePtr ) {
+    res = FTIFF_FlushWrites( batch );
+  }
+  if ( res != FTI_SCES ) {
+    char str[FTI_BUFS];
+    snprintf(str, FTI_BUFS, "FTI-FF: WriteFTIFF - Dataset #%d could not be written to file: %s", currentdbvar->id, batch->fn);
+    FTI_Print(str, FTI_EROR);
+    return FTI_NSCS;
+  }
   return FTI_SCES;
 
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Compresses data of a dbVar and appends it to the checkpoint file. 
+  @param      currentdbvar    dbVar the data belongs to
+  @param      codec           Codec used for the data (FTI_COMP_*)
+  @param      dptr            pointer to the data to be stored      
+  @param      size            number of bytes to be stored
+  @param      cbuf            buffer of FTI_CompressBound(FTI_COMP_FRAME) bytes
+  @param      fd              file descriptor (positioned at the end of the chunk)
+  @param      fn              file name
+  @return     integer         FTI_SCES if successful.
+
+  The data is compressed in frames of at most FTI_COMP_FRAME bytes, the 
+  stored size of the chunk 'csize' is increased by the size of the frames.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTIFF_WriteCompressedChunk( FTIFF_dbvar *currentdbvar, int codec, unsigned char *dptr, 
+    size_t size, unsigned char *cbuf, int fd, char *fn )
+{
+  char str[FTI_BUFS];
+  size_t done = 0;
+
+  while ( done < size ) {
+    long raw = ( size - done > FTI_COMP_FRAME ) ? FTI_COMP_FRAME : size - done;
+    long len = FTI_CompressFrame( codec, dptr + done, raw, cbuf );
+    long written = 0;
+    while ( written < len ) {
+      long returnVal;
+      FTI_FI_WRITE( returnVal, fd, cbuf + written, len - written, fn );
+      if ( returnVal == -1 ) {
+        snprintf(str, FTI_BUFS, "FTI-FF: WriteFTIFF - Dataset #%d could not be written to file: %s", currentdbvar->id, fn);
+        FTI_Print(str, FTI_EROR);
+        errno = 0;
+        return FTI_NSCS;
+      }
+      written += returnVal;
+    }
+    currentdbvar->csize += len;
+    done += raw;
+  }
+
+  return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      Writes the data of a single dbVar to the checkpoint file.
@@ -793,22 +1034,55 @@ int FTI_WriteMemFTIFFChunk(FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data, FTI
   @param      FTIFF_dbvar     dbVar to be written to the checkpoint file
   @param      FTI_Data        Dataset metadata.
   @param      hashchk         On return it contains the checksum of this dataset
-  @param      fd              File descriptor of the checkpoint file 
-  @param      fn              Name of the checkpoint file
+  @param      batch           Write batch of the checkpoint file
   @param      dcpSize         On return it will store the number of bytes actually written.
   @param      dptr            Memory location of the processed data (for debugging prints)
+  @param      cpos            File offset for the compressed chunk, advanced by its
+                              stored size (NULL -> the chunk is stored uncompressed)
   @return     integer         FTI_SCES if successful.
 
   This function writes the FTIFF datachunk to the checkpoint file. In the case of dcp
-  it only stores the data that have changed up to now. 
+  it only stores the data that have changed up to now. If the chunk is compressed,
+  it is appended at 'cpos' instead of being stored at its offset 'fptr'. Uncompressed
+  data is queued in the batch, the caller flushes it before the data may change.
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_ProcessDBVar(FTIT_execution *FTI_Exec, FTIT_configuration *FTI_Conf, FTIFF_dbvar *currentdbvar, 
-    FTIT_dataset *FTI_Data, unsigned char *hashchk, int fd, char *fn, long *dcpSize, unsigned char **dptr){
+    FTIT_dataset *FTI_Data, unsigned char *hashchk, FTIFF_writeBatch *batch, long *dcpSize, unsigned char **dptr,
+    uintptr_t *cpos){
+  int fd = batch->fd;
+  char *fn = batch->fn;
   bool hascontent = currentdbvar->hascontent;
   unsigned char *cbasePtr = NULL; 
+  unsigned char *cbuf = NULL;
+  char strerr[FTI_BUFS];
   errno = 0;
 
+  if ( cpos ) {
+    currentdbvar->cfptr = *cpos;
+    currentdbvar->csize = 0;
+    currentdbvar->codec = ( hascontent ) ? FTI_Conf->compMode : FTI_COMP_NONE;
+  } else {
+    currentdbvar->cfptr = currentdbvar->fptr;
+    currentdbvar->csize = currentdbvar->chunksize;
+    currentdbvar->codec = FTI_COMP_NONE;
+  }
+
+  if ( hascontent && cpos ) {
+    cbuf = (unsigned char*) malloc( FTI_CompressBound( FTI_COMP_FRAME ) );
+    if ( cbuf == NULL ) {
+      FTI_Print("FTI-FF: WriteFTIFF - failed to allocate the compression buffer.", FTI_EROR);
+      return FTI_NSCS;
+    }
+    if ( lseek( fd, *cpos, SEEK_SET ) == -1 ) {
+      snprintf(strerr, FTI_BUFS, "FTI-FF: WriteFTIFF - could not seek in file: %s", fn);
+      FTI_Print(strerr, FTI_EROR);
+      errno = 0;
+      free( cbuf );
+      return FTI_NSCS;
+    }
+  }
+
 
   size_t totalBytes;
   MD5_CTX dbContext;
@@ -846,20 +1120,39 @@ int FTI_ProcessDBVar(FTIT_execution *FTI_Exec, FTIT_configuration *FTI_Conf, FTI
     FTI_InitPrefetcher(&prefetcher);
 
     if ( FTI_Try(FTI_getPrefetchedData ( &prefetcher, &totalBytes, &cbasePtr), " Fetching Next Memory block from memory") != FTI_SCES ){
+      free( cbuf );
       return FTI_NSCS;
     }
 
     while (cbasePtr){
       MD5_Update( &dbContext, cbasePtr, totalBytes );  
-      FTI_WriteMemFTIFFChunk(FTI_Exec, FTI_Data, currentdbvar, cbasePtr, offset, totalBytes,  dcpSize, fd, fn);
+      if ( cbuf ) {
+        // count the stored (compressed) bytes, not the raw ones
+        long stored = currentdbvar->csize;
+        if ( FTIFF_WriteCompressedChunk( currentdbvar, FTI_Conf->compMode, cbasePtr, totalBytes, cbuf, fd, fn ) != FTI_SCES ) {
+          free( cbuf );
+          return FTI_NSCS;
+        }
+        (*dcpSize) += currentdbvar->csize - stored;
+      } else {
+        if ( FTI_WriteMemFTIFFChunk(FTI_Exec, FTI_Data, currentdbvar, cbasePtr, offset, totalBytes, dcpSize, batch) != FTI_SCES ) {
+          return FTI_NSCS;
+        }
+      }
       offset+=totalBytes;
       if ( FTI_Try(FTI_getPrefetchedData ( &prefetcher, &totalBytes, &cbasePtr), " Fetching Next Memory block from memory") != FTI_SCES ){
+        free( cbuf );
         return FTI_NSCS;
       }
     }
     MD5_Final( hashchk, &dbContext );
   }
 
+  if ( cpos ) {
+    *cpos += currentdbvar->csize;
+    free( cbuf );
+  }
+
 
 
   return FTI_SCES;
@@ -920,6 +1213,10 @@ MI_i  - Meta data for block (number variables blocksize)
 MV_ij - Variable chunk meta data (id, location in file, ptr offset, etc...)
 MF    - File meta data
 
+If compression is enabled ('ckpt_compress'), the data chunks are stored
+compressed one after the other instead of at their offsets 'fptr'. Their
+location and size in the file are kept in MV_ij ('cfptr', 'csize').
+
  **/
 /*-------------------------------------------------------------------------*/
 int FTIFF_WriteFTIFF(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
@@ -991,6 +1288,12 @@ int FTIFF_WriteFTIFF(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
   long dcpSize = 0, dataSize = 0, pureDataSize = 0;
 
+  FTIFF_writeBatch batch;
+  FTIFF_InitWriteBatch( &batch, fd, fn );
+
+  // compressed chunks are stored one after the other
+  uintptr_t cpos = 0;
+  uintptr_t *cposPtr = ( FTI_Conf->compMode != FTI_COMP_NONE ) ? &cpos : NULL;
 
   currentdb = FTI_Exec->firstdb;
 
@@ -1011,7 +1314,10 @@ int FTIFF_WriteFTIFF(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         pureDataSize += currentdbvar->chunksize;
       }
 
-      FTI_ProcessDBVar(FTI_Exec, FTI_Conf, currentdbvar, FTI_Data, hashchk, fd, fn, &dcpSize, &dptr);
+      if ( FTI_ProcessDBVar(FTI_Exec, FTI_Conf, currentdbvar, FTI_Data, hashchk, &batch, &dcpSize, &dptr, cposPtr) != FTI_SCES ) {
+        close( fd );
+        return FTI_NSCS;
+      }
 
       if( currentdbvar->hascontent ) {
         memcpy( currentdbvar->hash, hashchk, MD5_DIGEST_LENGTH );
@@ -1040,6 +1346,16 @@ int FTIFF_WriteFTIFF(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
   } while( isnextdb );
 
+  if ( FTIFF_FlushWrites( &batch ) != FTI_SCES ) {
+    close( fd );
+    return FTI_NSCS;
+  }
+
+  // the meta data follows the compressed chunks (keep the file size even for RS)
+  if ( cposPtr ) {
+    dataSize = ( cpos + 7 ) & ~((uintptr_t) 7);
+  }
+
   // important for reading and writing operations
   FTI_Exec->FTIFFMeta.dataSize = dataSize;
 
@@ -1054,6 +1370,10 @@ int FTIFF_WriteFTIFF(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   FTIFF_writeMetaDataFTIFF( FTI_Exec, fd );
 
   fdatasync( fd );
+  // the data is on disk, drop the local ckpt. from the page cache
+  if ( FTI_Conf->directIO && !(level == 4 && FTI_Ckpt[4].isInline) ) {
+    posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+  }
   close( fd );
 
   return FTI_SCES;
@@ -1462,23 +1782,38 @@ int FTIFF_Recover( FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data, FTIT_checkp
 
       srcptr = (char*) fmmap + currentdbvar->fptr;
 
-      MD5_Init( &mdContext );
-      cpycnt = 0;
-      while ( cpycnt < currentdbvar->chunksize ) {
-        cpybuf = currentdbvar->chunksize - cpycnt;
-        cpynow = ( cpybuf > membs ) ? membs : cpybuf;
-        cpycnt += cpynow;
+      if ( currentdbvar->codec != FTI_COMP_NONE ) {
+#ifdef GPUSUPPORT
+        bool toDevice = isDevice;
+#else
+        bool toDevice = false;
+#endif
+        if ( FTIFF_ReadCompressedChunk( currentdbvar, (unsigned char*) fmmap, st.st_size, 
+              (unsigned char*) destptr, toDevice, hash ) != FTI_SCES ) {
+          // leads to the corruption warning below
+          memset( hash, 0x0, MD5_DIGEST_LENGTH );
+        }
+        destptr += currentdbvar->chunksize;
+      } else {
+        MD5_Init( &mdContext );
+        cpycnt = 0;
+        while ( cpycnt < currentdbvar->chunksize ) {
+          cpybuf = currentdbvar->chunksize - cpycnt;
+          cpynow = ( cpybuf > membs ) ? membs : cpybuf;
+          cpycnt += cpynow;
 #ifdef GPUSUPPORT        
-        if ( isDevice )
-          FTI_copy_to_device_async(destptr,srcptr, cpynow);  
-        else
-          memcpy( destptr, srcptr, cpynow );
+          if ( isDevice )
+            FTI_copy_to_device_async(destptr,srcptr, cpynow);  
+          else
+            memcpy( destptr, srcptr, cpynow );
 #else
-        memcpy( destptr, srcptr, cpynow );
+          memcpy( destptr, srcptr, cpynow );
 #endif
-        MD5_Update( &mdContext, srcptr , cpynow );
-        destptr += cpynow;
-        srcptr += cpynow;
+          MD5_Update( &mdContext, srcptr , cpynow );
+          destptr += cpynow;
+          srcptr += cpynow;
+        }
+        MD5_Final( hash, &mdContext );
       }
 
       // debug information
@@ -1491,8 +1826,6 @@ int FTIFF_Recover( FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data, FTIT_checkp
           (uintptr_t)FTI_Data[currentdbvar->idx].ptr, (uintptr_t)destptr);
       FTI_Print(str, FTI_DBUG);
 
-      MD5_Final( hash, &mdContext );
-
       // JUST TESTING - print checksum current dataset.
       char checkSum[MD5_DIGEST_STRING_LENGTH];
       int ii = 0, i;
@@ -1669,16 +2002,26 @@ int FTIFF_RecoverVar( int id, FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data,
         destptr = (char*) FTI_Data[currentdbvar->idx].ptr + currentdbvar->dptr;
         srcptr = (char*) fmmap + currentdbvar->fptr;
 
-        MD5_Init( &mdContext );
-        cpycnt = 0;
-        while ( cpycnt < currentdbvar->chunksize ) {
-          cpybuf = currentdbvar->chunksize - cpycnt;
-          cpynow = ( cpybuf > membs ) ? membs : cpybuf;
-          cpycnt += cpynow;
-          memcpy( destptr, srcptr, cpynow );
-          MD5_Update( &mdContext, destptr, cpynow );
-          destptr += cpynow;
-          srcptr += cpynow;
+        if ( currentdbvar->codec != FTI_COMP_NONE ) {
+          if ( FTIFF_ReadCompressedChunk( currentdbvar, (unsigned char*) fmmap, st.st_size, 
+                (unsigned char*) destptr, false, hash ) != FTI_SCES ) {
+            // leads to the corruption warning below
+            memset( hash, 0x0, MD5_DIGEST_LENGTH );
+          }
+          destptr += currentdbvar->chunksize;
+        } else {
+          MD5_Init( &mdContext );
+          cpycnt = 0;
+          while ( cpycnt < currentdbvar->chunksize ) {
+            cpybuf = currentdbvar->chunksize - cpycnt;
+            cpynow = ( cpybuf > membs ) ? membs : cpybuf;
+            cpycnt += cpynow;
+            memcpy( destptr, srcptr, cpynow );
+            MD5_Update( &mdContext, destptr, cpynow );
+            destptr += cpynow;
+            srcptr += cpynow;
+          }
+          MD5_Final( hash, &mdContext );
         }
 
         // debug information
@@ -1691,8 +2034,6 @@ int FTIFF_RecoverVar( int id, FTIT_execution *FTI_Exec, FTIT_dataset *FTI_Data,
             (uintptr_t)FTI_Data[currentdbvar->idx].ptr, (uintptr_t)destptr);
         FTI_Print(str, FTI_DBUG);
 
-        MD5_Final( hash, &mdContext );
-
         if ( memcmp( currentdbvar->hash, hash, MD5_DIGEST_LENGTH ) != 0 ) {
           snprintf( strerr, FTI_BUFS, "FTIFF: FTIFF_RecoverVar - dataset with id:%i has been corrupted! Discard recovery.", currentdbvar->id);
           FTI_Print(strerr, FTI_WARN);
@@ -2887,6 +3228,9 @@ void FTIFF_GetHashdbvar( unsigned char *hash, FTIFF_dbvar *dbvar )
   MD5_Update( &md5Ctx, &(dbvar->fptr), sizeof(uintptr_t) );
   MD5_Update( &md5Ctx, &(dbvar->chunksize), sizeof(long) );
   MD5_Update( &md5Ctx, &(dbvar->containersize), sizeof(long) );
+  MD5_Update( &md5Ctx, &(dbvar->cfptr), sizeof(uintptr_t) );
+  MD5_Update( &md5Ctx, &(dbvar->csize), sizeof(long) );
+  MD5_Update( &md5Ctx, &(dbvar->codec), sizeof(int) );
   MD5_Update( &md5Ctx, dbvar->hash, MD5_DIGEST_LENGTH );
   MD5_Final( hash, &md5Ctx );
 }
@@ -3075,6 +3419,12 @@ int FTIFF_DeserializeDbVarMeta( FTIFF_dbvar* dbvar, char* buffer_ser )
   pos += sizeof(long);
   memcpy( &(dbvar->containersize)   , buffer_ser + pos, sizeof(long));
   pos += sizeof(long);
+  memcpy( &(dbvar->cfptr)           , buffer_ser + pos, sizeof(uintptr_t));
+  pos += sizeof(uintptr_t);
+  memcpy( &(dbvar->csize)           , buffer_ser + pos, sizeof(long));
+  pos += sizeof(long);
+  memcpy( &(dbvar->codec)           , buffer_ser + pos, sizeof(int));
+  pos += sizeof(int);
   memcpy( dbvar->hash               , buffer_ser + pos, MD5_DIGEST_LENGTH);
 
   return FTI_SCES;
@@ -3176,6 +3526,12 @@ int FTIFF_SerializeDbVarMeta( FTIFF_dbvar* dbvar, char* buffer_ser )
   pos += sizeof(long);
   memcpy( buffer_ser + pos, &(dbvar->containersize)   , sizeof(long));
   pos += sizeof(long);
+  memcpy( buffer_ser + pos, &(dbvar->cfptr)           , sizeof(uintptr_t));
+  pos += sizeof(uintptr_t);
+  memcpy( buffer_ser + pos, &(dbvar->csize)           , sizeof(long));
+  pos += sizeof(long);
+  memcpy( buffer_ser + pos, &(dbvar->codec)           , sizeof(int));
+  pos += sizeof(int);
   memcpy( buffer_ser + pos, dbvar->hash               , MD5_DIGEST_LENGTH);
 
   return FTI_SCES;
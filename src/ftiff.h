@@ -46,12 +46,17 @@
 #endif
 #include <assert.h>
 #include <string.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #define MBR_CNT(TYPE) int TYPE ## _mbrCnt
 #define MBR_BLK_LEN(TYPE) int TYPE ## _mbrBlkLen[]
 #define MBR_TYPES(TYPE) MPI_Datatype TYPE ## _mbrTypes[]
 #define MBR_DISP(TYPE) MPI_Aint TYPE ## _mbrDisp[]
 
+#define FTIFF_IO_DEPTH 64          /**< Max. chunks in a vectored write.    */
+#define FTIFF_IO_GAP 32768         /**< Max. clean bytes written to merge.  */
+
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
 #define DBG_MSG(MSG,RANK,...) do { \
@@ -126,6 +131,22 @@ typedef struct FTIFF_L3Info {
     long RSfs;  // maxFs
 } FTIFF_L3Info;
 
+/** @typedef    FTIFF_writeBatch
+ *  @brief      Chunk writes queued for a single vectored write.
+ *
+ *  The queued chunks are contiguous in the file, they are written with
+ *  one pwritev once the next chunk is not adjacent or the queue is full.
+ *  The memory of the queued chunks must stay valid until the flush.
+ */
+typedef struct FTIFF_writeBatch {
+    int             fd;                 /**< Checkpoint file.               */
+    char*           fn;                 /**< Name of the checkpoint file.   */
+    off_t           offset;             /**< File offset of the first chunk.*/
+    size_t          size;               /**< Bytes queued.                  */
+    int             nbIov;              /**< Number of chunks queued.       */
+    struct iovec    iov[FTIFF_IO_DEPTH]; /**< Chunks queued.                */
+} FTIFF_writeBatch;
+
 /**
 
   +-------------------------------------------------------------------------+
@@ -197,4 +218,7 @@ void FTIFF_GetHashdb( unsigned char *hash, FTIFF_db *db );
 void FTIFF_GetHashdbvar( unsigned char *hash, FTIFF_dbvar *dbvar );
 void FTIFF_SetHashChunk( FTIFF_dbvar *dbvar, FTIT_dataset* FTI_Data ); 
 void FTIFF_PrintDataStructure( int rank, FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data );
+void FTIFF_InitWriteBatch( FTIFF_writeBatch* batch, int fd, char* fn );
+int FTIFF_QueueWrite( FTIFF_writeBatch* batch, void* buf, size_t size, off_t offset );
+int FTIFF_FlushWrites( FTIFF_writeBatch* batch );
 #endif
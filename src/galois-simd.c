@@ -0,0 +1,585 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   galois-simd.c
+ *  @date   October, 2018
+ *  @brief  Vectorized and multithreaded GF(2^16) region kernels for the RS
+ *          encoding and decoding.
+ *
+ *  The kernels compute exactly the same products as the jerasure function
+ *  'galois_w16_region_multiply' (the split tables are derived from
+ *  'galois_single_multiply'), thus, the encoded data is byte-identical.
+ *  The SIMD kernel is selected at runtime according to the CPU features.
+ */
+
+#include "interface.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#   define FTI_GF_X86
+#   include <immintrin.h>
+#endif
+
+typedef void (*FTIT_gfmultfunc)(const FTIT_gfTable* table, const uint8_t* src,
+        uint8_t* dst, long nbytes, int add);
+typedef void (*FTIT_gfxorfunc)(const uint8_t* src, uint8_t* dst, long nbytes);
+
+/** 
+ * @brief job description of a matrix dot product. 
+ **/
+typedef struct FTIT_gfDotprodJob {
+    int                 k;              /**< Number of sources              */
+    FTIT_gfTable*       tables;         /**< Split tables of the matrix row */
+    char**              sptrs;          /**< Source regions                 */
+    uint8_t*            dptr;           /**< Destination region             */
+    long                size;           /**< Region size                    */
+} FTIT_gfDotprodJob;
+
+/** 
+ * @brief job description passed to the thread pool. 
+ **/
+typedef struct FTIT_gfJob {
+    const FTIT_gfTable* table;          /**< NULL for XOR                   */
+    const uint8_t*      src;            /**< Source region                  */
+    uint8_t*            dst;            /**< Destination region             */
+    long                nbytes;         /**< Region size                    */
+    int                 add;            /**< TRUE to add product to dst     */
+} FTIT_gfJob;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Scalar GF(2^16) region multiplication using the split tables.
+  @param      table           Split tables of the factor.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size (multiple of 2).
+  @param      add             TRUE to XOR the product to dst.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_GfMultScalar(const FTIT_gfTable* table, const uint8_t* src,
+        uint8_t* dst, long nbytes, int add)
+{
+    long i;
+    for (i = 0; i + 2 <= nbytes; i += 2) {
+        uint16_t w, p;
+        memcpy(&w, src + i, 2);
+        p = table->word[0][w & 0xf] ^ table->word[1][(w >> 4) & 0xf] ^
+            table->word[2][(w >> 8) & 0xf] ^ table->word[3][w >> 12];
+        if (add) {
+            uint16_t d;
+            memcpy(&d, dst + i, 2);
+            p ^= d;
+        }
+        memcpy(dst + i, &p, 2);
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Scalar region XOR.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_GfXorScalar(const uint8_t* src, uint8_t* dst, long nbytes)
+{
+    long i = 0;
+    for (; i + 8 <= nbytes; i += 8) {
+        uint64_t s, d;
+        memcpy(&s, src + i, 8);
+        memcpy(&d, dst + i, 8);
+        d ^= s;
+        memcpy(dst + i, &d, 8);
+    }
+    for (; i < nbytes; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+#ifdef FTI_GF_X86
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      SSSE3 GF(2^16) region multiplication (split table 16,4).
+  @param      table           Split tables of the factor.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size (multiple of 2).
+  @param      add             TRUE to XOR the product to dst.
+
+  The low and high bytes of 16 words are separated into two vectors, the
+  four nibbles are looked up with 'pshufb' and the result bytes are
+  interleaved back into words.
+
+ **/
+/*-------------------------------------------------------------------------*/
+__attribute__((target("ssse3")))
+static void FTI_GfMultSsse3(const FTIT_gfTable* table, const uint8_t* src,
+        uint8_t* dst, long nbytes, int add)
+{
+    __m128i tlo[4], thi[4];
+    int j;
+    for (j = 0; j < 4; j++) {
+        tlo[j] = _mm_loadu_si128((const __m128i*)table->lo[j]);
+        thi[j] = _mm_loadu_si128((const __m128i*)table->hi[j]);
+    }
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i lowByte = _mm_set1_epi16(0x00ff);
+
+    long i = 0;
+    for (; i + 32 <= nbytes; i += 32) {
+        __m128i v0 = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i v1 = _mm_loadu_si128((const __m128i*)(src + i + 16));
+        __m128i lo = _mm_packus_epi16(_mm_and_si128(v0, lowByte), _mm_and_si128(v1, lowByte));
+        __m128i hi = _mm_packus_epi16(_mm_srli_epi16(v0, 8), _mm_srli_epi16(v1, 8));
+        __m128i n0 = _mm_and_si128(lo, nibble);
+        __m128i n1 = _mm_and_si128(_mm_srli_epi16(lo, 4), nibble);
+        __m128i n2 = _mm_and_si128(hi, nibble);
+        __m128i n3 = _mm_and_si128(_mm_srli_epi16(hi, 4), nibble);
+        __m128i rlo = _mm_xor_si128(
+                _mm_xor_si128(_mm_shuffle_epi8(tlo[0], n0), _mm_shuffle_epi8(tlo[1], n1)),
+                _mm_xor_si128(_mm_shuffle_epi8(tlo[2], n2), _mm_shuffle_epi8(tlo[3], n3)));
+        __m128i rhi = _mm_xor_si128(
+                _mm_xor_si128(_mm_shuffle_epi8(thi[0], n0), _mm_shuffle_epi8(thi[1], n1)),
+                _mm_xor_si128(_mm_shuffle_epi8(thi[2], n2), _mm_shuffle_epi8(thi[3], n3)));
+        __m128i r0 = _mm_unpacklo_epi8(rlo, rhi);
+        __m128i r1 = _mm_unpackhi_epi8(rlo, rhi);
+        if (add) {
+            r0 = _mm_xor_si128(r0, _mm_loadu_si128((const __m128i*)(dst + i)));
+            r1 = _mm_xor_si128(r1, _mm_loadu_si128((const __m128i*)(dst + i + 16)));
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), r0);
+        _mm_storeu_si128((__m128i*)(dst + i + 16), r1);
+    }
+    FTI_GfMultScalar(table, src + i, dst + i, nbytes - i, add);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      AVX2 GF(2^16) region multiplication (split table 16,4).
+  @param      table           Split tables of the factor.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size (multiple of 2).
+  @param      add             TRUE to XOR the product to dst.
+
+  Same as the SSSE3 kernel on 256-bit vectors. Pack and unpack operate
+  per 128-bit lane, hence, the word order is restored by the unpack.
+
+ **/
+/*-------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static void FTI_GfMultAvx2(const FTIT_gfTable* table, const uint8_t* src,
+        uint8_t* dst, long nbytes, int add)
+{
+    __m256i tlo[4], thi[4];
+    int j;
+    for (j = 0; j < 4; j++) {
+        tlo[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table->lo[j]));
+        thi[j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table->hi[j]));
+    }
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i lowByte = _mm256_set1_epi16(0x00ff);
+
+    long i = 0;
+    for (; i + 64 <= nbytes; i += 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(src + i + 32));
+        __m256i lo = _mm256_packus_epi16(_mm256_and_si256(v0, lowByte), _mm256_and_si256(v1, lowByte));
+        __m256i hi = _mm256_packus_epi16(_mm256_srli_epi16(v0, 8), _mm256_srli_epi16(v1, 8));
+        __m256i n0 = _mm256_and_si256(lo, nibble);
+        __m256i n1 = _mm256_and_si256(_mm256_srli_epi16(lo, 4), nibble);
+        __m256i n2 = _mm256_and_si256(hi, nibble);
+        __m256i n3 = _mm256_and_si256(_mm256_srli_epi16(hi, 4), nibble);
+        __m256i rlo = _mm256_xor_si256(
+                _mm256_xor_si256(_mm256_shuffle_epi8(tlo[0], n0), _mm256_shuffle_epi8(tlo[1], n1)),
+                _mm256_xor_si256(_mm256_shuffle_epi8(tlo[2], n2), _mm256_shuffle_epi8(tlo[3], n3)));
+        __m256i rhi = _mm256_xor_si256(
+                _mm256_xor_si256(_mm256_shuffle_epi8(thi[0], n0), _mm256_shuffle_epi8(thi[1], n1)),
+                _mm256_xor_si256(_mm256_shuffle_epi8(thi[2], n2), _mm256_shuffle_epi8(thi[3], n3)));
+        __m256i r0 = _mm256_unpacklo_epi8(rlo, rhi);
+        __m256i r1 = _mm256_unpackhi_epi8(rlo, rhi);
+        if (add) {
+            r0 = _mm256_xor_si256(r0, _mm256_loadu_si256((const __m256i*)(dst + i)));
+            r1 = _mm256_xor_si256(r1, _mm256_loadu_si256((const __m256i*)(dst + i + 32)));
+        }
+        _mm256_storeu_si256((__m256i*)(dst + i), r0);
+        _mm256_storeu_si256((__m256i*)(dst + i + 32), r1);
+    }
+    FTI_GfMultScalar(table, src + i, dst + i, nbytes - i, add);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      AVX2 region XOR.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size.
+
+ **/
+/*-------------------------------------------------------------------------*/
+__attribute__((target("avx2")))
+static void FTI_GfXorAvx2(const uint8_t* src, uint8_t* dst, long nbytes)
+{
+    long i = 0;
+    for (; i + 32 <= nbytes; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(s, d));
+    }
+    FTI_GfXorScalar(src + i, dst + i, nbytes - i);
+}
+
+#endif // FTI_GF_X86
+
+/** 
+ * @brief kernels selected by 'FTI_GfInit'. 
+ **/
+static FTIT_gfmultfunc gfMult = FTI_GfMultScalar;
+static FTIT_gfxorfunc gfXor = FTI_GfXorScalar;
+static const char* gfKernelName = "scalar";
+static bool gfInitialized = false;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Selects the GF kernels according to the CPU features.
+
+  Must be called before the kernels are used from several threads. The
+  SIMD kernels may be disabled with the environment variable
+  'FTI_GF_DISABLE_SIMD'.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_GfInit()
+{
+    if (gfInitialized) {
+        return;
+    }
+    gfInitialized = true;
+
+    // make sure the jerasure field is initialized by a single thread
+    galois_single_multiply(1, 1, 16);
+
+    if (getenv("FTI_GF_DISABLE_SIMD") != NULL) {
+        return;
+    }
+#ifdef FTI_GF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        gfMult = FTI_GfMultAvx2;
+        gfXor = FTI_GfXorAvx2;
+        gfKernelName = "avx2";
+    }
+    else if (__builtin_cpu_supports("ssse3")) {
+        gfMult = FTI_GfMultSsse3;
+        gfKernelName = "ssse3";
+    }
+#endif
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the name of the selected GF kernel.
+  @return     const char*     Kernel name.
+
+ **/
+/*-------------------------------------------------------------------------*/
+const char* FTI_GfKernelName()
+{
+    FTI_GfInit();
+    return gfKernelName;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the split tables for a constant factor.
+  @param      table           Tables to initialize.
+  @param      multby          Constant factor in GF(2^16).
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_GfInitTable(FTIT_gfTable* table, int multby)
+{
+    FTI_GfInit();
+    table->multby = multby;
+    int i, n;
+    for (i = 0; i < 4; i++) {
+        for (n = 0; n < 16; n++) {
+            uint16_t p = (uint16_t)galois_single_multiply(n << (4 * i), multby, 16);
+            table->word[i][n] = p;
+            table->lo[i][n] = p & 0xff;
+            table->hi[i][n] = p >> 8;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Thread pool function executing a part of a region job.
+  @param      arg             Pointer to the job.
+  @param      tid             Thread id.
+  @param      nbThreads       Number of threads.
+
+  The region is split in stripes of equal size (multiple of 64 bytes).
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_GfRegionWorker(void* arg, int tid, int nbThreads)
+{
+    FTIT_gfJob* job = (FTIT_gfJob*)arg;
+    long stripe = (job->nbytes + nbThreads - 1) / nbThreads;
+    stripe = (stripe + 63) & ~63L;
+    long start = stripe * tid;
+    if (start >= job->nbytes) {
+        return;
+    }
+    long nbytes = (start + stripe > job->nbytes) ? job->nbytes - start : stripe;
+    if (job->table == NULL) {
+        gfXor(job->src + start, job->dst + start, nbytes);
+    } else {
+        gfMult(job->table, job->src + start, job->dst + start, nbytes, job->add);
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Executes a region job, in parallel if worthwhile.
+  @param      pool            Thread pool (may be NULL).
+  @param      job             The job.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_GfRunJob(FTIT_threadPool* pool, FTIT_gfJob* job)
+{
+    if (pool == NULL || pool->nbActive == 1 || job->nbytes < 2 * FTI_GF_MIN_STRIPE) {
+        FTI_GfRegionWorker(job, 0, 1);
+        return;
+    }
+    FTI_RunThreadPool(pool, FTI_GfRegionWorker, job);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Multiplies a region with a constant in GF(2^16).
+  @param      pool            Thread pool (may be NULL).
+  @param      table           Split tables of the factor.
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size (multiple of 2).
+  @param      add             TRUE to XOR the product to dst.
+
+  Equivalent to 'galois_w16_region_multiply(src, multby, nbytes, dst, add)'.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_GfRegionMultiply(FTIT_threadPool* pool, FTIT_gfTable* table,
+        char* src, char* dst, long nbytes, int add)
+{
+    FTIT_gfJob job;
+    job.table = table;
+    job.src = (const uint8_t*)src;
+    job.dst = (uint8_t*)dst;
+    job.nbytes = nbytes;
+    job.add = add;
+    FTI_GfRunJob(pool, &job);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      XORs a region into another.
+  @param      pool            Thread pool (may be NULL).
+  @param      src             Source region.
+  @param      dst             Destination region.
+  @param      nbytes          Region size.
+
+  Equivalent to 'galois_region_xor(src, dst, nbytes)'.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_GfRegionXor(FTIT_threadPool* pool, char* src, char* dst, long nbytes)
+{
+    FTIT_gfJob job;
+    job.table = NULL;
+    job.src = (const uint8_t*)src;
+    job.dst = (uint8_t*)dst;
+    job.nbytes = nbytes;
+    job.add = 1;
+    FTI_GfRunJob(pool, &job);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Thread pool function executing a part of a dot product.
+  @param      arg             Pointer to the job.
+  @param      tid             Thread id.
+  @param      nbThreads       Number of threads.
+
+  Every thread computes the complete dot product for its stripe of the
+  destination region, hence, the stripe stays in cache for all sources.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_GfDotprodWorker(void* arg, int tid, int nbThreads)
+{
+    FTIT_gfDotprodJob* job = (FTIT_gfDotprodJob*)arg;
+    long stripe = (job->size + nbThreads - 1) / nbThreads;
+    stripe = (stripe + 63) & ~63L;
+    long start = stripe * tid;
+    if (start >= job->size) {
+        return;
+    }
+    long nbytes = (start + stripe > job->size) ? job->size - start : stripe;
+    uint8_t* dptr = job->dptr + start;
+    int init = 0;
+    int i;
+
+    // same order of operations as 'jerasure_matrix_dotprod'
+    for (i = 0; i < job->k; i++) {
+        if (job->tables[i].multby == 1) {
+            const uint8_t* sptr = (const uint8_t*)job->sptrs[i] + start;
+            if (init == 0) {
+                memcpy(dptr, sptr, nbytes);
+                init = 1;
+            } else {
+                gfXor(sptr, dptr, nbytes);
+            }
+        }
+    }
+    for (i = 0; i < job->k; i++) {
+        if (job->tables[i].multby != 0 && job->tables[i].multby != 1) {
+            const uint8_t* sptr = (const uint8_t*)job->sptrs[i] + start;
+            gfMult(&job->tables[i], sptr, dptr, nbytes, init);
+            init = 1;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the dot product of a matrix row with the regions.
+  @param      pool            Thread pool (may be NULL).
+  @param      k               Number of sources.
+  @param      tables          Split tables of the matrix row (k entries).
+  @param      src_ids         Source ids (NULL -> data_ptrs[0..k-1]).
+  @param      dest_id         Destination id.
+  @param      data_ptrs       Data regions.
+  @param      coding_ptrs     Coding regions.
+  @param      size            Region size (multiple of 2).
+
+  Equivalent to 'jerasure_matrix_dotprod' for w = 16, the ids are
+  interpreted the same way (id < k -> data, else coding).
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_GfMatrixDotprod(FTIT_threadPool* pool, int k, FTIT_gfTable* tables,
+        int* src_ids, int dest_id, char** data_ptrs, char** coding_ptrs, long size)
+{
+    char* sptrs[k];
+    int i;
+    for (i = 0; i < k; i++) {
+        if (src_ids == NULL) {
+            sptrs[i] = data_ptrs[i];
+        } else if (src_ids[i] < k) {
+            sptrs[i] = data_ptrs[src_ids[i]];
+        } else {
+            sptrs[i] = coding_ptrs[src_ids[i] - k];
+        }
+    }
+
+    FTIT_gfDotprodJob job;
+    job.k = k;
+    job.tables = tables;
+    job.sptrs = sptrs;
+    job.dptr = (uint8_t*)((dest_id < k) ? data_ptrs[dest_id] : coding_ptrs[dest_id - k]);
+    job.size = size;
+
+    if (pool == NULL || pool->nbActive == 1 || size < 2 * FTI_GF_MIN_STRIPE) {
+        FTI_GfDotprodWorker(&job, 0, 1);
+        return;
+    }
+    FTI_RunThreadPool(pool, FTI_GfDotprodWorker, &job);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the decoding matrix for an erasure pattern.
+  @param      matrix          Coding matrix (k x k).
+  @param      erased          Erasure flags (2k entries, data then coding).
+  @param      k               Number of data devices (at most 32).
+  @param      w               Word size.
+  @return     int*            Inverted matrix or NULL if not invertible.
+
+  The decoding matrix is built from the rows of the surviving devices
+  (first k survivors) and inverted with 'jerasure_invert_matrix'. The
+  returned matrix must be freed by the caller.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int* FTI_GfGetDecodingMatrix(int* matrix, int* erased, int k, int w)
+{
+    int i, j;
+    int* dm_ids = talloc(int, k);
+    int* tmpmat = talloc(int, k * k);
+    int* decMatrix = talloc(int, k * k);
+    j = 0;
+    for (i = 0; j < k; i++) {
+        if (erased[i] == 0) {
+            dm_ids[j] = i;
+            j++;
+        }
+    }
+    for (i = 0; i < k; i++) {
+        if (dm_ids[i] < k) {
+            for (j = 0; j < k; j++) {
+                tmpmat[i * k + j] = 0;
+            }
+            tmpmat[i * k + dm_ids[i]] = 1;
+        }
+        else {
+            for (j = 0; j < k; j++) {
+                tmpmat[i * k + j] = matrix[(dm_ids[i] - k) * k + j];
+            }
+        }
+    }
+    int res = jerasure_invert_matrix(tmpmat, decMatrix, k, w);
+    free(tmpmat);
+    free(dm_ids);
+    if (res < 0) {
+        free(decMatrix);
+        return NULL;
+    }
+
+    return decMatrix;
+}
@@ -0,0 +1,73 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   galois-simd.h
+ *  @date   October, 2018
+ *  @brief  Header for the vectorized GF(2^16) region kernels.
+ */
+
+#ifndef _FTI_GALOIS_SIMD_H
+#define _FTI_GALOIS_SIMD_H
+
+#include <stdint.h>
+#include "thread-pool.h"
+
+/** Minimal number of bytes per thread for region operations.              */
+#define FTI_GF_MIN_STRIPE 65536
+
+/** @typedef    FTIT_gfTable
+ *  @brief      Split tables for the multiplication with a constant.
+ *
+ *  The product of a 16-bit word w = (n3,n2,n1,n0) with 'multby' is
+ *  computed as T0[n0]^T1[n1]^T2[n2]^T3[n3], with Ti[n] = multby*(n<<4i).
+ *  The tables are stored as 16-bit words for the scalar kernel and split
+ *  into low and high bytes for the byte shuffle of the SIMD kernels.
+ */
+typedef struct FTIT_gfTable {
+    int             multby;             /**< Constant factor                */
+    uint16_t        word[4][16];        /**< Split tables (16-bit words)    */
+    uint8_t         lo[4][16];          /**< Low bytes of the split tables  */
+    uint8_t         hi[4][16];          /**< High bytes of the split tables */
+} FTIT_gfTable;
+
+void FTI_GfInit();
+const char* FTI_GfKernelName();
+void FTI_GfInitTable(FTIT_gfTable* table, int multby);
+void FTI_GfRegionMultiply(FTIT_threadPool* pool, FTIT_gfTable* table,
+        char* src, char* dst, long nbytes, int add);
+void FTI_GfRegionXor(FTIT_threadPool* pool, char* src, char* dst, long nbytes);
+void FTI_GfMatrixDotprod(FTIT_threadPool* pool, int k, FTIT_gfTable* tables,
+        int* src_ids, int dest_id, char** data_ptrs, char** coding_ptrs, long size);
+int* FTI_GfGetDecodingMatrix(int* matrix, int* erased, int k, int w);
+
+#endif
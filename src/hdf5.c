@@ -848,10 +848,14 @@ int FTI_RecoverVarHDF5(FTIT_execution* FTI_Exec, FTIT_checkpoint* FTI_Ckpt,
         FTI_OpenGroup(FTI_Exec->H5groups[rootGroup->childrenID[i]], file_id, FTI_Exec->H5groups);
     }
 
-    for (i = 0; i < FTI_Exec->nbVar; i++) {
-        if (FTI_Data[i].id == id) {
-            break;
+    i = FTI_GetDatasetIdx(id);
+    if (i == -1) {
+        FTI_Print("Variables must be protected before they can be recovered.", FTI_EROR);
+        for (i = 0; i < FTI_Exec->H5groups[0]->childrenNo; i++) {
+            FTI_CloseGroup(FTI_Exec->H5groups[rootGroup->childrenID[i]], FTI_Exec->H5groups);
         }
+        H5Fclose(file_id);
+        return FTI_NREC;
     }
 
     hid_t h5Type = FTI_Data[i].type->h5datatype;
@@ -69,6 +69,11 @@ int FTI_WritePosixVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* F
     int res;
     memcpy( &fd, FTI_Exec->iCPInfo.fh, sizeof(FTI_PO_FH) );
 
+    // variables may be added in any order, checksum is computed at finalize
+    WritePosixInfo_t write_info;
+    write_info.f = fd;
+    write_info.integrity = NULL;
+
     char str[FTI_BUFS];
 
     long offset = 0;
@@ -84,7 +89,7 @@ int FTI_WritePosixVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* F
             }
             if ( !(FTI_Data[i].isDevicePtr) ){
                 FTI_Print(str,FTI_INFO);
-                if (( res = FTI_Try(write_posix(FTI_Data[i].ptr, FTI_Data[i].size, fd),"Storing Data to Checkpoint file")) != FTI_SCES){
+                if (( res = FTI_Try(write_posix(FTI_Data[i].ptr, FTI_Data[i].size, &write_info),"Storing Data to Checkpoint file")) != FTI_SCES){
                     snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
                     FTI_Print(str, FTI_EROR);
                     fclose(fd);
@@ -97,7 +102,7 @@ int FTI_WritePosixVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* F
             else {
                 FTI_Print(str,FTI_INFO);
                 if ((res = FTI_Try(
-                                FTI_TransferDeviceMemToFileAsync(&FTI_Data[i],  write_posix, fd),
+                                FTI_TransferDeviceMemToFileAsync(&FTI_Data[i],  write_posix, &write_info),
                                 "moving data from GPU to storage")) != FTI_SCES) {
                     snprintf(str, FTI_BUFS, "Dataset #%d could not be written.", FTI_Data[i].id);
                     FTI_Print(str, FTI_EROR);
@@ -176,11 +181,6 @@ int FTI_InitMpiICP(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     FTI_Print("I/O mode: MPI-IO.", FTI_DBUG);
     char str[FTI_BUFS], mpi_err[FTI_BUFS];
 
-    // enable collective buffer optimization
-    MPI_Info info;
-    MPI_Info_create(&info);
-    MPI_Info_set(info, "romio_cb_write", "enable");
-
     /* 
      * update ckpt file name (neccessary for the restart!)
      * not very nice TODO we should think about another mechanism
@@ -188,10 +188,6 @@ int FTI_InitMpiICP(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     snprintf(FTI_Exec->meta[0].ckptFile, FTI_BUFS,
             "Ckpt%d-Rank%d.fti", FTI_Exec->ckptID, FTI_Topo->myRank);
 
-    // TODO enable to set stripping unit in the config file (Maybe also other hints)
-    // set stripping unit to 4MB
-    MPI_Info_set(info, "stripping_unit", "4194304");
-
     char gfn[FTI_BUFS], ckptFile[FTI_BUFS];
     snprintf(ckptFile, FTI_BUFS, "Ckpt%d-mpiio.fti", FTI_Exec->ckptID);
     snprintf(gfn, FTI_BUFS, "%s/%s", FTI_Conf->gTmpDir, ckptFile);
@@ -214,7 +210,8 @@ int FTI_InitMpiICP(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
 #endif
-    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, info, &pfh);
+    // hints from the configuration (collective buffering, striping)
+    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, FTI_Conf->mpiioInfo, &pfh);
 
     // check if successful
     if (res != 0) {
@@ -243,7 +240,6 @@ int FTI_InitMpiICP(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     FTI_Exec->iCPInfo.offset = offset;
 
     memcpy( FTI_Exec->iCPInfo.fh, &pfh, sizeof(FTI_MI_FH) );
-    MPI_Info_free(&info);
 
     return FTI_SCES;
 
@@ -271,6 +267,7 @@ int FTI_WriteMpiVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* FTI
 
     write_info.offset = FTI_Exec->iCPInfo.offset; 
     write_info.FTI_Conf = FTI_Conf;
+    write_info.integrity = NULL;
 
     int i;
     for (i = 0; i < FTI_Exec->nbVar; i++) {
@@ -446,12 +443,7 @@ int FTI_WriteFtiffVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* F
     long dataSize = 0;
     long pureDataSize = 0;
 
-    int pvar_idx = -1, pvar_idx_;
-    for( pvar_idx_=0; pvar_idx_<FTI_Exec->nbVar; pvar_idx_++ ) {
-        if( FTI_Data[pvar_idx_].id == varID ) {
-            pvar_idx = pvar_idx_;
-        }
-    }
+    int pvar_idx = FTI_GetDatasetIdx(varID);
     if( pvar_idx == -1 ) {
         FTI_Print("FTI_WriteFtiffVar: Illegal ID", FTI_WARN);
         return FTI_NSCS;
@@ -488,7 +480,13 @@ int FTI_WriteFtiffVar(int varID, FTIT_configuration* FTI_Conf, FTIT_execution* F
                 if( dbvar->hascontent ) 
                     pureDataSize += dbvar->chunksize;
 
-                FTI_ProcessDBVar(FTI_Exec, FTI_Conf, dbvar , FTI_Data, hashchk, fd, FTI_Exec->iCPInfo.fn , &dcpSize, &dptr);
+                // the variable may change after the call, write it right away
+                FTIFF_writeBatch batch;
+                FTIFF_InitWriteBatch( &batch, fd, FTI_Exec->iCPInfo.fn );
+                if ( FTI_ProcessDBVar(FTI_Exec, FTI_Conf, dbvar , FTI_Data, hashchk, &batch, &dcpSize, &dptr, NULL) != FTI_SCES
+                        || FTIFF_FlushWrites( &batch ) != FTI_SCES ) {
+                    return FTI_NSCS;
+                }
                 // create hash for datachunk and assign to member 'hash'
                 if( dbvar->hascontent ) {
                     memcpy( dbvar->hash, hashchk, MD5_DIGEST_LENGTH );
@@ -61,11 +61,19 @@
 #endif
 
 #include "stage.h"
+#include "thread-pool.h"
+#include "galois-simd.h"
+#include "pipeline.h"
+#include "registry.h"
+#include "stats.h"
+#include "compress.h"
+#include "fast-hash.h"
 
 #include <stdint.h>
 #include "../deps/md5/md5.h"
 
 #define CHUNK_SIZE 131072    /**< MD5 algorithm chunk size.      */
+#define VERIFY_CHUNK_SIZE 4194304 /**< Read size of checksum checks. */
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -97,6 +105,12 @@
 /** Malloc macro.                                                          */
 #define talloc(type, num) (type *)malloc(sizeof(type) * (num))
 
+/** Initial sleep of the idle head between two polls (usec).              */
+#define FTI_HEAD_POLL_MIN 1
+
+/** Number of blocks in flight per direction during the L2 exchange.      */
+#define FTI_PTNER_WINDOW 4
+
 extern int FTI_filemetastructsize;	/**< size of FTIFF_metaInfo in file */
 extern int FTI_dbstructsize;		/**< size of FTIFF_db in file       */
 extern int FTI_dbvarstructsize;		/**< size of FTIFF_dbvar in file    */
@@ -124,12 +138,28 @@ int FTI_WritePar(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 int FTI_WritePosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
         FTIT_dataset* FTI_Data);
+int FTI_WritePosixDcp(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
+        FTIT_dataset* FTI_Data);
+int FTI_WriteMPIDcp(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
+        FTIT_dataset* FTI_Data);
 int FTI_PostCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
 int FTI_Listen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
 int FTI_HandleCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
+int FTI_HeadPreempt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
+int FTI_WaitCkptRequests(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, int maxPending);
+int FTI_PrepareCkptGen(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int level);
+int FTI_SendCkptRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int value);
+void FTI_FinalizeCkptRequests(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo);
 int FTI_HandleStageRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int source);
 
@@ -143,6 +173,7 @@ int FTI_TestConfig(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 int FTI_TestDirectories(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo);
 int FTI_CreateDirs(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
+void FTI_SetTmpDirs(FTIT_configuration* FTI_Conf, int gen);
 int FTI_LoadConf(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt,
         FTIT_injection *FTI_Inje);
@@ -190,6 +221,9 @@ int FTI_LoadL4CkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exe
 
 int FTI_Local(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
+void FTI_FreePtnerDelta();
+int FTI_ExchangeCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_checkpoint* FTI_Ckpt, int destination, int source, int postFlag);
 int FTI_Ptner(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
 int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
@@ -228,12 +262,18 @@ int FTI_CheckErasures(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         int *erased);
 int FTI_RecoverFiles(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt);
+int FTI_InitRecoverVar(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_checkpoint* FTI_Ckpt);
+int FTI_RecoverVarMapped(FTIT_execution* FTI_Exec, FTIT_dataset* data);
+void FTI_FinalizeRecoverVar();
 
 int FTI_Checksum(FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data,
       FTIT_configuration* FTI_Conf, char* checksum);
 int FTI_VerifyChecksum(char* fileName, char* checksumToCmp);
 int FTI_Try(int result, char* message);
 void FTI_MallocMeta(FTIT_execution* FTI_Exec, FTIT_topology* FTI_Topo);
+int FTI_ReallocMetaVars(FTIT_execution* FTI_Exec, int nbProc, int nbVar);
+int FTI_GetMetaVarIdx(FTIT_execution* FTI_Exec, int level, int id);
 void FTI_FreeMeta(FTIT_execution* FTI_Exec);
 void FTI_FreeTypesAndGroups(FTIT_execution* FTI_Exec);
 #ifdef ENABLE_HDF5
@@ -299,10 +339,11 @@ typedef void*               FTI_ADDRPTR;        /**< void ptr type
 
 //INCREMENTAL CHECKPOINTING FOR FTIFF
 int FTI_ProcessDBVar(FTIT_execution *FTI_Exec, FTIT_configuration *FTI_Conf, FTIFF_dbvar *currentdbvar, 
-                     FTIT_dataset *FTI_Data, unsigned char *hashchk, int fd, char *fn, long *dcpSize, unsigned char **dptr);
+                     FTIT_dataset *FTI_Data, unsigned char *hashchk, FTIFF_writeBatch *batch, long *dcpSize, unsigned char **dptr,
+                     uintptr_t *cpos);
 
 int FTI_InitDcp(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data);
-int FTI_FinalizeDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec ); 
+int FTI_FinalizeDcp( FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data ); 
 int FTI_InitNextHashData(FTIT_DataDiffHash *hashes);
 int FTI_FreeDataDiff( FTIT_DataDiffHash *dhash);
 dcpBLK_t FTI_GetDiffBlockSize(); 
@@ -312,9 +353,15 @@ int FTI_InitBlockHashArray( FTIFF_dbvar* dbvar );
 int FTI_CollapseBlockHashArray( FTIT_DataDiffHash* hashes, long chunkSize); 
 int FTI_ExpandBlockHashArray( FTIT_DataDiffHash* dataHash, long chunkSize ); 
 long FTI_CalcNumHashes( long chunkSize ); 
-int FTI_HashCmp( long hashIdx, FTIFF_dbvar* dbvar, unsigned char *ptr );
+int FTI_HashCmp( long hashIdx, FTIT_DataDiffHash* hashes, unsigned char *ptr );
+int FTI_ComputeDcpHashes( FTIT_DataDiffHash* hashes, unsigned char* ptr, size_t offset, size_t nbytes );
+void FTI_ClearDcpHashes();
 int FTI_UpdateDcpChanges(FTIT_dataset* FTI_Data, FTIT_execution* FTI_Exec); 
 int FTI_ReceiveDataChunk(unsigned char** buffer_addr, size_t* buffer_size, FTIFF_dbvar* dbvar,  FTIT_dataset* FTI_Data, unsigned char *startAddr, size_t *totalBytes ); 
+int FTI_InitDataDcpHash( FTIT_dataset* data, bool* reset );
+int FTI_FreeDataDcpHashes( FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data );
+int FTI_NextDirtyRegion( FTIT_DataDiffHash* hashes, unsigned char* ptr, long* hashIdx,
+        long* offset, long* size );
 
 
 // INCREMENTAL CHECKPOINTING
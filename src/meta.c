@@ -38,6 +38,330 @@
 
 #include "interface.h"
 
+/** Magic string at the beginning of the binary metadata files.          */
+#define FTI_META_MAGIC "FTIMETA"
+/** Version of the binary metadata format.                               */
+#define FTI_META_VERSION 1
+/** Type of the appended section holding the RSed file checksums.        */
+#define FTI_META_SEC_RSED 1
+
+/** @typedef    FTIT_metaHeader
+ *  @brief      Header of the binary metadata file.
+ *
+ *  The header is followed by groupSize FTIT_metaRecord, the variable
+ *  sizes (long[groupSize][nbVar]) and the variable IDs
+ *  (int[groupSize][nbVar]). Sections (FTIT_metaSection) can be appended
+ *  after that without rewriting the file.
+ */
+typedef struct FTIT_metaHeader {
+    char            magic[8];           /**< FTI_META_MAGIC                 */
+    int             version;            /**< FTI_META_VERSION               */
+    int             groupSize;          /**< Number of records.             */
+    int             nbVar;              /**< Variables per record.          */
+    int             reserved;           /**< Padding, always 0.             */
+    long            maxFs;              /**< Max. file size in the group.   */
+} FTIT_metaHeader;
+
+/** @typedef    FTIT_metaRecord
+ *  @brief      Fixed-size record of one process of the group.
+ */
+typedef struct FTIT_metaRecord {
+    char            ckptFile[FTI_BUFS]; /**< Checkpoint file name.          */
+    long            fs;                 /**< Checkpoint file size.          */
+    char            checksum[MD5_DIGEST_STRING_LENGTH]; /**< File checksum. */
+} FTIT_metaRecord;
+
+/** @typedef    FTIT_metaSection
+ *  @brief      Header of a section appended to the metadata file.
+ */
+typedef struct FTIT_metaSection {
+    int             type;               /**< FTI_META_SEC_*                 */
+    int             count;              /**< Number of entries.             */
+} FTIT_metaSection;
+
+/** @typedef    FTIT_metaMap
+ *  @brief      Metadata file opened for reading (binary or INI).
+ */
+typedef struct FTIT_metaMap {
+    void*           addr;               /**< Mapping of a binary file.      */
+    size_t          size;               /**< Size of the mapping.           */
+    dictionary*     ini;                /**< Dictionary of an INI file.     */
+    FTIT_metaHeader* head;              /**< Header of a binary file.       */
+    FTIT_metaRecord* recs;              /**< Records of a binary file.      */
+    long*           varSizes;           /**< Variable sizes.                */
+    int*            varIDs;             /**< Variable IDs.                  */
+    char*           rsChecksums;        /**< Last appended RSed checksums.  */
+} FTIT_metaMap;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It returns the size of the fixed part of a binary metadata file.
+  @param      groupSize       Number of records.
+  @param      nbVar           Number of variables per record.
+  @return     size_t          Size in bytes.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static size_t FTI_MetaBaseSize(int groupSize, int nbVar)
+{
+    return sizeof(FTIT_metaHeader)
+        + (size_t)groupSize * sizeof(FTIT_metaRecord)
+        + (size_t)groupSize * nbVar * (sizeof(long) + sizeof(int));
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It opens a metadata file for reading.
+  @param      fn              Path to the metadata file.
+  @param      map             Map to fill.
+  @return     integer         FTI_SCES if successful.
+
+  Binary metadata files are mapped into memory and validated, the appended
+  sections are scanned for the RSed checksums. Files without the binary
+  header are parsed with iniparser (INI export, see Advanced:meta_ini).
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_OpenMetaFile(char* fn, FTIT_metaMap* map)
+{
+    memset(map, 0, sizeof(FTIT_metaMap));
+
+    int fd = open(fn, O_RDONLY);
+    if (fd == -1) {
+        FTI_Print("Metadata file could NOT be opened.", FTI_WARN);
+        return FTI_NSCS;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        FTI_Print("Metadata file could NOT be stat.", FTI_WARN);
+        close(fd);
+        return FTI_NSCS;
+    }
+
+    char magic[sizeof(FTI_META_MAGIC)];
+    if (st.st_size < (off_t) sizeof(FTIT_metaHeader) ||
+            read(fd, magic, sizeof(magic)) != sizeof(magic) ||
+            memcmp(magic, FTI_META_MAGIC, sizeof(magic)) != 0) {
+        close(fd);
+        map->ini = iniparser_load(fn);
+        if (map->ini == NULL) {
+            FTI_Print("Iniparser failed to parse the metadata file.", FTI_WARN);
+            return FTI_NSCS;
+        }
+        return FTI_SCES;
+    }
+
+    map->size = st.st_size;
+    map->addr = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map->addr == MAP_FAILED) {
+        map->addr = NULL;
+        FTI_Print("Metadata file could NOT be mapped.", FTI_WARN);
+        return FTI_NSCS;
+    }
+
+    map->head = (FTIT_metaHeader*) map->addr;
+    size_t base = FTI_MetaBaseSize(map->head->groupSize, map->head->nbVar);
+    if (map->head->version != FTI_META_VERSION || map->head->groupSize <= 0
+            || map->head->nbVar < 0 || base > map->size) {
+        FTI_Print("Metadata file is corrupted or has an unknown version.", FTI_WARN);
+        munmap(map->addr, map->size);
+        map->addr = NULL;
+        return FTI_NSCS;
+    }
+    map->recs = (FTIT_metaRecord*) (map->head + 1);
+    map->varSizes = (long*) (map->recs + map->head->groupSize);
+    map->varIDs = (int*) (map->varSizes + (size_t)map->head->groupSize * map->head->nbVar);
+
+    // appended sections, the last one of a type is the valid one
+    size_t pos = base;
+    while (pos + sizeof(FTIT_metaSection) <= map->size) {
+        FTIT_metaSection* sec = (FTIT_metaSection*) ((char*)map->addr + pos);
+        pos += sizeof(FTIT_metaSection);
+        size_t len = (size_t)sec->count * MD5_DIGEST_STRING_LENGTH;
+        if (sec->type != FTI_META_SEC_RSED || sec->count < 0 || pos + len > map->size) {
+            FTI_Print("Metadata file has an invalid appended section.", FTI_WARN);
+            break;
+        }
+        if (sec->count == map->head->groupSize) {
+            map->rsChecksums = (char*)map->addr + pos;
+        }
+        pos += len;
+    }
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It releases a metadata file opened with FTI_OpenMetaFile.
+  @param      map             Map to release.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_CloseMetaFile(FTIT_metaMap* map)
+{
+    if (map->addr != NULL) {
+        munmap(map->addr, map->size);
+    }
+    if (map->ini != NULL) {
+        iniparser_freedict(map->ini);
+    }
+    memset(map, 0, sizeof(FTIT_metaMap));
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the string entry of a group member from the metadata.
+  @param      map             Opened metadata file.
+  @param      rank            Rank in the group.
+  @param      key             INI key (Ckpt_file_name, Ckpt_checksum or RSed_checksum).
+  @param      out             Buffer to fill.
+  @param      len             Length of the buffer.
+  @return     integer         FTI_SCES if the entry exists.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_GetMetaString(FTIT_metaMap* map, int rank, const char* key,
+        char* out, int len)
+{
+    const char* val = NULL;
+    if (map->ini != NULL) {
+        char str[FTI_BUFS];
+        snprintf(str, FTI_BUFS, "%d:%s", rank, key);
+        val = iniparser_getstring(map->ini, str, NULL);
+    }
+    else if (rank >= 0 && rank < map->head->groupSize) {
+        if (strcmp(key, "Ckpt_file_name") == 0) {
+            val = map->recs[rank].ckptFile;
+        }
+        else if (strcmp(key, "Ckpt_checksum") == 0) {
+            val = map->recs[rank].checksum;
+        }
+        else if (map->rsChecksums != NULL) {
+            val = map->rsChecksums + (size_t)rank * MD5_DIGEST_STRING_LENGTH;
+        }
+    }
+    if (val == NULL) {
+        out[0] = '\0';
+        return FTI_NSCS;
+    }
+    strncpy(out, val, len - 1);
+    out[len - 1] = '\0';
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the checkpoint file size of a group member.
+  @param      map             Opened metadata file.
+  @param      rank            Rank in the group.
+  @return     long            File size, -1 if not found.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static long FTI_GetMetaFileSize(FTIT_metaMap* map, int rank)
+{
+    if (map->ini != NULL) {
+        char str[FTI_BUFS];
+        snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", rank);
+        return iniparser_getlint(map->ini, str, -1);
+    }
+    if (rank < 0 || rank >= map->head->groupSize) {
+        return -1;
+    }
+    return map->recs[rank].fs;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the maximum checkpoint file size of the group.
+  @param      map             Opened metadata file.
+  @return     long            Max. file size, -1 if not found.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static long FTI_GetMetaMaxFs(FTIT_metaMap* map)
+{
+    if (map->ini != NULL) {
+        return iniparser_getlint(map->ini, "0:Ckpt_file_maxs", -1);
+    }
+    return map->head->maxFs;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the ID and size of a protected variable.
+  @param      map             Opened metadata file.
+  @param      rank            Rank in the group.
+  @param      k               Position of the variable.
+  @param      id              Pointer to fill with the ID.
+  @param      size            Pointer to fill with the size.
+  @return     integer         FTI_SCES if the variable exists.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_GetMetaVar(FTIT_metaMap* map, int rank, int k, int* id, long* size)
+{
+    if (map->ini != NULL) {
+        char str[FTI_BUFS];
+        snprintf(str, FTI_BUFS, "%d:Var%d_id", rank, k);
+        *id = iniparser_getint(map->ini, str, -1);
+        if (*id == -1) {
+            return FTI_NSCS;
+        }
+        snprintf(str, FTI_BUFS, "%d:Var%d_size", rank, k);
+        *size = iniparser_getlint(map->ini, str, -1);
+        return FTI_SCES;
+    }
+    if (rank < 0 || rank >= map->head->groupSize || k >= map->head->nbVar) {
+        return FTI_NSCS;
+    }
+    *id = map->varIDs[(size_t)rank * map->head->nbVar + k];
+    *size = map->varSizes[(size_t)rank * map->head->nbVar + k];
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It reads the metadata of one process into the meta arrays.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      map             Opened metadata file.
+  @param      level           Level of the meta arrays.
+  @param      j               Process slot (0 for application processes).
+  @param      nbProc          Number of process slots of the meta arrays.
+  @return     integer         FTI_SCES if successful.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_ReadMetaEntry(FTIT_execution* FTI_Exec, FTIT_topology* FTI_Topo,
+        FTIT_metaMap* map, int level, int j, int nbProc)
+{
+    int ptner = (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize;
+
+    FTI_GetMetaString(map, FTI_Topo->groupRank, "Ckpt_file_name",
+            &FTI_Exec->meta[level].ckptFile[j * FTI_BUFS], FTI_BUFS);
+    FTI_Exec->meta[level].fs[j] = FTI_GetMetaFileSize(map, FTI_Topo->groupRank);
+    FTI_Exec->meta[level].pfs[j] = FTI_GetMetaFileSize(map, ptner);
+    FTI_Exec->meta[level].maxFs[j] = FTI_GetMetaMaxFs(map);
+
+    int k, id;
+    long size;
+    for (k = 0; FTI_GetMetaVar(map, FTI_Topo->groupRank, k, &id, &size) == FTI_SCES; k++) {
+        //Variable exists
+        if (FTI_ReallocMetaVars(FTI_Exec, nbProc, k + 1) != FTI_SCES) {
+            return FTI_NSCS;
+        }
+        FTI_Exec->meta[level].varID[j * FTI_Exec->nbVarMax + k] = id;
+        FTI_Exec->meta[level].varSize[j * FTI_Exec->nbVarMax + k] = size;
+    }
+    //Save number of variables in metadata
+    FTI_Exec->meta[level].nbVar[j] = k;
+
+    return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It gets the checksums from metadata.
@@ -76,28 +400,22 @@ int FTI_GetChecksums(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTI_Print("FTI metadata file NOT accessible.", FTI_WARN);
         return FTI_NSCS;
     }
-    dictionary* ini = iniparser_load(mfn);
-    if (ini == NULL) {
-        FTI_Print("Iniparser failed to parse the metadata file.", FTI_WARN);
+    FTIT_metaMap map;
+    if (FTI_OpenMetaFile(mfn, &map) != FTI_SCES) {
         return FTI_NSCS;
     }
 
     //Get checksum of checkpoint file
-    snprintf(str, FTI_BUFS, "%d:Ckpt_checksum", FTI_Topo->groupRank);
-    char* checksumTemp = iniparser_getstring(ini, str, "");
-    strncpy(checksum, checksumTemp, MD5_DIGEST_STRING_LENGTH);
+    FTI_GetMetaString(&map, FTI_Topo->groupRank, "Ckpt_checksum", checksum, MD5_DIGEST_STRING_LENGTH);
 
     //Get checksum of partner checkpoint file
-    snprintf(str, FTI_BUFS, "%d:Ckpt_checksum", (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize);
-    checksumTemp = iniparser_getstring(ini, str, "");
-    strncpy(ptnerChecksum, checksumTemp, MD5_DIGEST_STRING_LENGTH);
+    FTI_GetMetaString(&map, (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize,
+            "Ckpt_checksum", ptnerChecksum, MD5_DIGEST_STRING_LENGTH);
 
     //Get checksum of Reed-Salomon file
-    snprintf(str, FTI_BUFS, "%d:RSed_checksum", FTI_Topo->groupRank);
-    checksumTemp = iniparser_getstring(ini, str, "");
-    strncpy(rsChecksum, checksumTemp, MD5_DIGEST_STRING_LENGTH);
+    FTI_GetMetaString(&map, FTI_Topo->groupRank, "RSed_checksum", rsChecksum, MD5_DIGEST_STRING_LENGTH);
 
-    iniparser_freedict(ini);
+    FTI_CloseMetaFile(&map);
 
     return FTI_SCES;
 }
@@ -114,7 +432,8 @@ int FTI_GetChecksums(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   @return     integer         FTI_SCES if successful.
 
   This function should be executed only by one process per group. It
-  writes the RSed checksum to the metadata file.
+  writes the RSed checksum to the metadata file. Binary metadata files
+  are not rewritten, the checksums are appended as a new section.
 
  **/
 /*-------------------------------------------------------------------------*/
@@ -143,6 +462,33 @@ int FTI_WriteRSedChecksum(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
     }
 
     snprintf(fileName, FTI_BUFS, "%s/sector%d-group%d.fti", FTI_Conf->mTmpDir, FTI_Topo->sectorID, groupID);
+
+    if (!FTI_Conf->metaIni) {
+        snprintf(str, FTI_BUFS, "Appending RSed checksums to metadata file (%s)...", fileName);
+        FTI_Print(str, FTI_DBUG);
+
+        size_t len = sizeof(FTIT_metaSection) + (size_t)FTI_Topo->groupSize * MD5_DIGEST_STRING_LENGTH;
+        char* buf = talloc(char, len);
+        FTIT_metaSection sec = { FTI_META_SEC_RSED, FTI_Topo->groupSize };
+        memcpy(buf, &sec, sizeof(FTIT_metaSection));
+        memcpy(buf + sizeof(FTIT_metaSection), checksums, (size_t)FTI_Topo->groupSize * MD5_DIGEST_STRING_LENGTH);
+        free(checksums);
+
+        int fd = open(fileName, O_WRONLY | O_APPEND);
+        if (fd == -1) {
+            FTI_Print("Metadata file could NOT be opened.", FTI_WARN);
+            free(buf);
+            return FTI_NSCS;
+        }
+        ssize_t written = write(fd, buf, len);
+        free(buf);
+        if (close(fd) != 0 || written != (ssize_t) len) {
+            FTI_Print("Metadata file could NOT be written.", FTI_WARN);
+            return FTI_NSCS;
+        }
+        return FTI_SCES;
+    }
+
     dictionary* ini = iniparser_load(fileName);
     if (ini == NULL) {
         FTI_Print("Temporary metadata file could NOT be parsed", FTI_WARN);
@@ -215,50 +561,22 @@ int FTI_LoadTmpMeta(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             snprintf(str, FTI_BUFS, "Getting FTI metadata file (%s)...", metaFileName);
             FTI_Print(str, FTI_DBUG);
             if (access(metaFileName, R_OK) == 0) {
-                dictionary* ini = iniparser_load(metaFileName);
-                if (ini == NULL) {
-                    FTI_Print("Iniparser failed to parse the metadata file.", FTI_WARN);
+                FTIT_metaMap map;
+                if (FTI_OpenMetaFile(metaFileName, &map) != FTI_SCES) {
                     return FTI_NSCS;
                 }
-                else {
-                    FTI_Exec->meta[0].exists[j] = 1;
-
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_name", FTI_Topo->groupRank);
-                    char* ckptFileName = iniparser_getstring(ini, str, NULL);
-                    snprintf(&FTI_Exec->meta[0].ckptFile[j * FTI_BUFS], FTI_BUFS, "%s", ckptFileName);
-
-                    //update head's ckptID
-                    sscanf(&FTI_Exec->meta[0].ckptFile[j * FTI_BUFS], "Ckpt%d", &FTI_Exec->ckptID);
-                    if (FTI_Exec->ckptID < biggestCkptID) {
-                        FTI_Exec->ckptID = biggestCkptID;
-                    }
-
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", FTI_Topo->groupRank);
-                    FTI_Exec->meta[0].fs[j] = iniparser_getlint(ini, str, -1);
+                FTI_Exec->meta[0].exists[j] = 1;
 
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize);
-                    FTI_Exec->meta[0].pfs[j] = iniparser_getlint(ini, str, -1);
-
-                    FTI_Exec->meta[0].maxFs[j] = iniparser_getlint(ini, "0:Ckpt_file_maxs", -1);
-
-                    int k;
-                    for (k = 0; k < FTI_BUFS; k++) {
-                        snprintf(str, FTI_BUFS, "%d:Var%d_id", FTI_Topo->groupRank, k);
-                        int id = iniparser_getint(ini, str, -1);
-                        if (id == -1) {
-                            //No more variables
-                            break;
-                        }
-                        //Variable exists
-                        FTI_Exec->meta[0].varID[j * FTI_BUFS + k] = id;
-
-                        snprintf(str, FTI_BUFS, "%d:Var%d_size", FTI_Topo->groupRank, k);
-                        FTI_Exec->meta[0].varSize[j * FTI_BUFS + k] = iniparser_getlint(ini, str, -1);
-                    }
-                    //Save number of variables in metadata
-                    FTI_Exec->meta[0].nbVar[j] = k;
+                int res = FTI_ReadMetaEntry(FTI_Exec, FTI_Topo, &map, 0, j, FTI_Topo->nodeSize);
+                FTI_CloseMetaFile(&map);
+                if (res != FTI_SCES) {
+                    return FTI_NSCS;
+                }
 
-                    iniparser_freedict(ini);
+                //update head's ckptID
+                sscanf(&FTI_Exec->meta[0].ckptFile[j * FTI_BUFS], "Ckpt%d", &FTI_Exec->ckptID);
+                if (FTI_Exec->ckptID < biggestCkptID) {
+                    FTI_Exec->ckptID = biggestCkptID;
                 }
             }
             else {
@@ -303,46 +621,18 @@ int FTI_LoadMeta(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             snprintf(str, FTI_BUFS, "Getting FTI metadata file (%s)...", metaFileName);
             FTI_Print(str, FTI_DBUG);
             if (access(metaFileName, R_OK) == 0) {
-                dictionary* ini = iniparser_load(metaFileName);
-                if (ini == NULL) {
-                    FTI_Print("Iniparser failed to parse the metadata file.", FTI_WARN);
+                FTIT_metaMap map;
+                if (FTI_OpenMetaFile(metaFileName, &map) != FTI_SCES) {
                     return FTI_NSCS;
                 }
-                else {
-                    snprintf(str, FTI_BUFS, "Meta for level %d exists.", i);
-                    FTI_Print(str, FTI_DBUG);
-                    FTI_Exec->meta[i].exists[0] = 1;
-
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_name", FTI_Topo->groupRank);
-                    char* ckptFileName = iniparser_getstring(ini, str, NULL);
-                    snprintf(FTI_Exec->meta[i].ckptFile, FTI_BUFS, "%s", ckptFileName);
-
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", FTI_Topo->groupRank);
-                    FTI_Exec->meta[i].fs[0] = iniparser_getlint(ini, str, -1);
-
-                    snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize);
-                    FTI_Exec->meta[i].pfs[0] = iniparser_getlint(ini, str, -1);
-
-                    FTI_Exec->meta[i].maxFs[0] = iniparser_getlint(ini, "0:Ckpt_file_maxs", -1);
-
-                    int k;
-                    for (k = 0; k < FTI_BUFS; k++) {
-                        snprintf(str, FTI_BUFS, "%d:Var%d_id", FTI_Topo->groupRank, k);
-                        int id = iniparser_getint(ini, str, -1);
-                        if (id == -1) {
-                            //No more variables
-                            break;
-                        }
-                        //Variable exists
-                        FTI_Exec->meta[i].varID[k] = id;
-
-                        snprintf(str, FTI_BUFS, "%d:Var%d_size", FTI_Topo->groupRank, k);
-                        FTI_Exec->meta[i].varSize[k] = iniparser_getlint(ini, str, -1);
-                    }
-                    //Save number of variables in metadata
-                    FTI_Exec->meta[i].nbVar[0] = k;
+                snprintf(str, FTI_BUFS, "Meta for level %d exists.", i);
+                FTI_Print(str, FTI_DBUG);
+                FTI_Exec->meta[i].exists[0] = 1;
 
-                    iniparser_freedict(ini);
+                int res = FTI_ReadMetaEntry(FTI_Exec, FTI_Topo, &map, i, 0, 1);
+                FTI_CloseMetaFile(&map);
+                if (res != FTI_SCES) {
+                    return FTI_NSCS;
                 }
             }
         }
@@ -353,7 +643,6 @@ int FTI_LoadMeta(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         for (i = 0; i < 5; i++) {        //for each level
             int j;
             for (j = 1; j < FTI_Topo->nodeSize; j++) { //for all body processes
-                dictionary* ini;
                 char metaFileName[FTI_BUFS], str[FTI_BUFS];
                 if (i == 0) {
                     snprintf(metaFileName, FTI_BUFS, "%s/sector%d-group%d.fti", FTI_Conf->mTmpDir, FTI_Topo->sectorID, j);
@@ -363,52 +652,27 @@ int FTI_LoadMeta(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                 snprintf(str, FTI_BUFS, "Getting FTI metadata file (%s)...", metaFileName);
                 FTI_Print(str, FTI_DBUG);
                 if (access(metaFileName, R_OK) == 0) {
-                    ini = iniparser_load(metaFileName);
-                    if (ini == NULL) {
-                        FTI_Print("Iniparser failed to parse the metadata file.", FTI_WARN);
+                    FTIT_metaMap map;
+                    if (FTI_OpenMetaFile(metaFileName, &map) != FTI_SCES) {
+                        return FTI_NSCS;
+                    }
+                    snprintf(str, FTI_BUFS, "Meta for level %d exists.", i);
+                    FTI_Print(str, FTI_DBUG);
+                    FTI_Exec->meta[i].exists[j] = 1;
+
+                    int res = FTI_ReadMetaEntry(FTI_Exec, FTI_Topo, &map, i, j, FTI_Topo->nodeSize);
+                    FTI_CloseMetaFile(&map);
+                    if (res != FTI_SCES) {
                         return FTI_NSCS;
                     }
-                    else {
-                        snprintf(str, FTI_BUFS, "Meta for level %d exists.", i);
-                        FTI_Print(str, FTI_DBUG);
-                        FTI_Exec->meta[i].exists[j] = 1;
-
-                        snprintf(str, FTI_BUFS, "%d:Ckpt_file_name", FTI_Topo->groupRank);
-                        char* ckptFileName = iniparser_getstring(ini, str, NULL);
-                        snprintf(&FTI_Exec->meta[i].ckptFile[j * FTI_BUFS], FTI_BUFS, "%s", ckptFileName);
-
-                        //update heads ckptID
-                        sscanf(&FTI_Exec->meta[i].ckptFile[j * FTI_BUFS], "Ckpt%d", &FTI_Exec->ckptID);
-                        if (FTI_Exec->ckptID < biggestCkptID) {
-                            FTI_Exec->ckptID = biggestCkptID;
-                        }
-
-                        snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", FTI_Topo->groupRank);
-                        FTI_Exec->meta[i].fs[j] = iniparser_getlint(ini, str, -1);
-
-                        snprintf(str, FTI_BUFS, "%d:Ckpt_file_size", (FTI_Topo->groupRank + FTI_Topo->groupSize - 1) % FTI_Topo->groupSize);
-                        FTI_Exec->meta[i].pfs[j] = iniparser_getlint(ini, str, -1);
-
-                        FTI_Exec->meta[i].maxFs[j] = iniparser_getlint(ini, "0:Ckpt_file_maxs", -1);
-                        int k;
-                        for (k = 0; k < FTI_BUFS; k++) {
-                            snprintf(str, FTI_BUFS, "%d:Var%d_id", FTI_Topo->groupRank, k);
-                            int id = iniparser_getint(ini, str, -1);
-                            if (id == -1) {
-                                //No more variables
-                                break;
-                            }
-                            //Variable exists
-                            FTI_Exec->meta[i].varID[j * FTI_BUFS + k] = id;
-
-                            snprintf(str, FTI_BUFS, "%d:Var%d_size", FTI_Topo->groupRank, k);
-                            FTI_Exec->meta[i].varSize[j * FTI_BUFS + k] = iniparser_getlint(ini, str, -1);
-                        }
-                        //Save number of variables in metadata
-                        FTI_Exec->meta[i].nbVar[j] = k;
-
-                        iniparser_freedict(ini);
+
+                    //update heads ckptID (the newest ckpt. is the one to post-process)
+                    int ckptID = 0;
+                    sscanf(&FTI_Exec->meta[i].ckptFile[j * FTI_BUFS], "Ckpt%d", &ckptID);
+                    if (ckptID > biggestCkptID) {
+                        biggestCkptID = ckptID;
                     }
+                    FTI_Exec->ckptID = biggestCkptID;
                 }
             }
         }
@@ -446,18 +710,21 @@ int FTI_LoadL4CkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exe
         return FTI_NSCS;
     }
     
-    if ( ((int)(ini->n)-6) < 0 ) {
+    if ( ini->n == 0 ) {
         FTI_Print("Unexpected checkpoint meta data file structure.", FTI_EROR);
         return FTI_NSCS;
     }
     
     char currCkpt[FTI_BUFS];
     
-    // ini->key[2] must be the level field
+    // the sections are the keys without ':', the number of fields may vary
     int ckptID;
     int i=0;
     bool hasL4Ckpt = false;
-    for(; i<ini->n; i+=6) {
+    for(; i<ini->n; i++) {
+        if( ini->key[i] == NULL || strchr( ini->key[i], ':' ) != NULL ) {
+            continue;
+        }
         memset( currCkpt, 0x0, FTI_BUFS );
         strncpy( currCkpt, ini->key[i], FTI_BUFS-1 );
         char level_key[FTI_BUFS];
@@ -503,14 +770,20 @@ int FTI_LoadCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         return FTI_NSCS;
     }
     
-    char lastCkpt[FTI_BUFS];
-    if ( ((int)(ini->n)-6) < 0 ) {
+    // the last section is the last checkpoint
+    int last = ini->n - 1;
+    while ( last >= 0 && (ini->key[last] == NULL || strchr( ini->key[last], ':' ) != NULL) ) {
+        last--;
+    }
+    if ( last < 0 ) {
         FTI_Print("Unexpected checkpoint meta data file structure.", FTI_EROR);
+        dictionary_del(ini);
         return FTI_NSCS;
     }
-    
+
+    char lastCkpt[FTI_BUFS];
     memset( lastCkpt, 0x0, FTI_BUFS );
-    strncpy( lastCkpt, ini->key[ini->n-6], FTI_BUFS-1);
+    strncpy( lastCkpt, ini->key[last], FTI_BUFS-1);
     
     int ckptID;
     sscanf(lastCkpt, "checkpoint_id.%d", &ckptID ); 
@@ -535,6 +808,16 @@ int FTI_LoadCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         } else {    
             FTI_Ckpt[4].isDcp = (bool) isDcp;
         }
+        // the block hashes are not stored, they are rebuilt after the restart
+        // whatever the mode, thus the mode tag is only reported
+        snprintf( key, FTI_BUFS, "%s:dcp_mode", lastCkpt );
+        int dcpMode = iniparser_getint( ini, key, -1 );
+        if ( isDcp && !FTI_Topo->amIaHead && (FTI_Topo->splitRank == 0) && (dcpMode != -1) &&
+                (dcpMode + FTI_DCP_MODE_OFFSET != FTI_GetDcpMode()) ) {
+            snprintf( str, FTI_BUFS, "dCP checkpoint %d was written with dCP mode %d, now using dCP mode %d.",
+                    ckptID, dcpMode, FTI_GetDcpMode() - FTI_DCP_MODE_OFFSET );
+            FTI_Print( str, FTI_INFO );
+        }
     }
 
     //FTI_Exec->ckptLvel = ckptLvel;
@@ -559,6 +842,7 @@ int FTI_LoadCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     - number of processes participating in the checkpoint
     - I/O mode
     - dCP enabled/disabled
+    - dCP hash mode (dCP checkpoints only)
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_WriteCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
@@ -616,6 +900,11 @@ int FTI_WriteCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
     snprintf( key, FTI_BUFS, "%s:is_dcp", section );
     snprintf( value, FTI_BUFS, "%s", (FTI_Ckpt[FTI_Exec->ckptLvel].isDcp) ? "true" : "false" );
     iniparser_set( ini, key, value ); 
+    if ( FTI_Ckpt[FTI_Exec->ckptLvel].isDcp ) {
+        snprintf( key, FTI_BUFS, "%s:dcp_mode", section );
+        snprintf( value, FTI_BUFS, "%d", FTI_GetDcpMode() - FTI_DCP_MODE_OFFSET );
+        iniparser_set( ini, key, value ); 
+    }
 
     fstream = fopen( fn, "w" );
     if ( fstream == NULL ) {
@@ -640,7 +929,7 @@ int FTI_WriteCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
 
 /*-------------------------------------------------------------------------*/
 /**
-  @brief      It writes the metadata to recover the data after a failure.
+  @brief      It writes the metadata in the INI format.
   @param      FTI_Conf        Configuration metadata.
   @param      FTI_Exec        Execution metadata.
   @param      FTI_Topo        Topology metadata.
@@ -650,20 +939,17 @@ int FTI_WriteCkptMetaData(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec
   @param      checksums       Checksums array.
   @param      allVarIDs       IDs of vars from all processes in group.
   @param      allVarSizes     Sizes of vars from all processes in group.
+  @param      fn              Path to the metadata file.
   @return     integer         FTI_SCES if successful.
 
-  This function should be executed only by one process per group. It
-  writes the metadata file used to recover in case of failure.
+  Human readable export of the metadata, used when Advanced:meta_ini is set.
 
  **/
 /*-------------------------------------------------------------------------*/
-int FTI_WriteMetadata(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+static int FTI_WriteMetadataIni(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, long* fs, long mfs, char* fnl,
-        char* checksums, int* allVarIDs, long* allVarSizes)
+        char* checksums, int* allVarIDs, long* allVarSizes, char* fn)
 {
-    // no metadata files for FTI-FF
-    if ( FTI_Conf->ioMode == FTI_IO_FTIFF ) { return FTI_SCES; }
-
 	char str[FTI_BUFS], buf[FTI_BUFS];
     snprintf(buf, FTI_BUFS, "%s/Topology.fti", FTI_Conf->metadDir);
     snprintf(str, FTI_BUFS, "Temporary load of topology file (%s)...", buf);
@@ -709,43 +995,131 @@ int FTI_WriteMetadata(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     // Remove topology section
     iniparser_unset(ini, "topology");
+
+    FILE* fd = fopen(fn, "w");
+    if (fd == NULL) {
+        FTI_Print("Metadata file could NOT be opened.", FTI_WARN);
+
+        iniparser_freedict(ini);
+
+        return FTI_NSCS;
+    }
+
+    // Write metadata
+    iniparser_dump_ini(ini, fd);
+
+    if (fclose(fd) != 0) {
+        FTI_Print("Metadata file could NOT be closed.", FTI_WARN);
+
+        iniparser_freedict(ini);
+
+        return FTI_NSCS;
+    }
+
+    iniparser_freedict(ini);
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It writes the metadata to recover the data after a failure.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Topo        Topology metadata.
+  @param      fs              Pointer to the list of checkpoint sizes.
+  @param      mfs             The maximum checkpoint file size.
+  @param      fnl             Pointer to the list of checkpoint names.
+  @param      checksums       Checksums array.
+  @param      allVarIDs       IDs of vars from all processes in group.
+  @param      allVarSizes     Sizes of vars from all processes in group.
+  @return     integer         FTI_SCES if successful.
+
+  This function should be executed only by one process per group. It
+  writes the metadata file used to recover in case of failure. The file
+  is binary (see FTIT_metaHeader) and is written with a single write,
+  unless the INI export is requested with Advanced:meta_ini.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_WriteMetadata(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_topology* FTI_Topo, long* fs, long mfs, char* fnl,
+        char* checksums, int* allVarIDs, long* allVarSizes)
+{
+    // no metadata files for FTI-FF
+    if ( FTI_Conf->ioMode == FTI_IO_FTIFF ) { return FTI_SCES; }
+
+	char str[FTI_BUFS], fn[FTI_BUFS];
     if (mkdir(FTI_Conf->mTmpDir, 0777) == -1) {
         if (errno != EEXIST) {
             FTI_Print("Cannot create directory", FTI_EROR);
         }
     }
 
-    snprintf(buf, FTI_BUFS, "%s/sector%d-group%d.fti", FTI_Conf->mTmpDir, FTI_Topo->sectorID, FTI_Topo->groupID);
-    if (remove(buf) == -1) {
+    snprintf(fn, FTI_BUFS, "%s/sector%d-group%d.fti", FTI_Conf->mTmpDir, FTI_Topo->sectorID, FTI_Topo->groupID);
+    if (remove(fn) == -1) {
         if (errno != ENOENT) {
             FTI_Print("Cannot remove sector-group.fti", FTI_EROR);
         }
     }
 
-    snprintf(str, FTI_BUFS, "Creating metadata file (%s)...", buf);
+    snprintf(str, FTI_BUFS, "Creating metadata file (%s)...", fn);
     FTI_Print(str, FTI_DBUG);
 
-    FILE* fd = fopen(buf, "w");
-    if (fd == NULL) {
-        FTI_Print("Metadata file could NOT be opened.", FTI_WARN);
-
-        iniparser_freedict(ini);
+    if (FTI_Conf->metaIni) {
+        return FTI_WriteMetadataIni(FTI_Conf, FTI_Exec, FTI_Topo, fs, mfs, fnl,
+                checksums, allVarIDs, allVarSizes, fn);
+    }
 
+    // Build the whole file in memory
+    int groupSize = FTI_Topo->groupSize;
+    int nbVar = FTI_Exec->nbVar;
+    size_t len = FTI_MetaBaseSize(groupSize, nbVar);
+    char* buf = (char*) calloc(len, 1);
+    if (buf == NULL) {
+        FTI_Print("Failed to allocate the metadata buffer.", FTI_WARN);
         return FTI_NSCS;
     }
 
-    // Write metadata
-    iniparser_dump_ini(ini, fd);
+    FTIT_metaHeader* head = (FTIT_metaHeader*) buf;
+    memcpy(head->magic, FTI_META_MAGIC, sizeof(FTI_META_MAGIC));
+    head->version = FTI_META_VERSION;
+    head->groupSize = groupSize;
+    head->nbVar = nbVar;
+    head->maxFs = mfs;
 
-    if (fclose(fd) != 0) {
-        FTI_Print("Metadata file could NOT be closed.", FTI_WARN);
+    FTIT_metaRecord* recs = (FTIT_metaRecord*) (head + 1);
+    int i;
+    for (i = 0; i < groupSize; i++) {
+        strncpy(recs[i].ckptFile, fnl + (i * FTI_BUFS), FTI_BUFS - 1);
+        recs[i].fs = fs[i];
+        strncpy(recs[i].checksum, checksums + (i * MD5_DIGEST_STRING_LENGTH), MD5_DIGEST_STRING_LENGTH - 1);
+    }
+    long* varSizes = (long*) (recs + groupSize);
+    int* varIDs = (int*) (varSizes + (size_t)groupSize * nbVar);
+    memcpy(varSizes, allVarSizes, (size_t)groupSize * nbVar * sizeof(long));
+    memcpy(varIDs, allVarIDs, (size_t)groupSize * nbVar * sizeof(int));
 
-        iniparser_freedict(ini);
+    int fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        FTI_Print("Metadata file could NOT be opened.", FTI_WARN);
+        free(buf);
+        return FTI_NSCS;
+    }
 
+    // Write metadata
+    ssize_t written = write(fd, buf, len);
+    free(buf);
+    if (written != (ssize_t) len) {
+        FTI_Print("Metadata file could NOT be written.", FTI_WARN);
+        close(fd);
         return FTI_NSCS;
     }
 
-    iniparser_freedict(ini);
+    if (close(fd) != 0) {
+        FTI_Print("Metadata file could NOT be closed.", FTI_WARN);
+        return FTI_NSCS;
+    }
 
     return FTI_SCES;
 }
@@ -832,8 +1206,16 @@ int FTI_CreateMetadata(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     strncpy(str, FTI_Exec->meta[0].ckptFile, FTI_BUFS); // Gather all the file names
     MPI_Gather(str, FTI_BUFS, MPI_CHAR, ckptFileNames, FTI_BUFS, MPI_CHAR, 0, FTI_Exec->groupComm);
 
+    // use the checksum computed during the write if there is one
     char checksum[MD5_DIGEST_STRING_LENGTH];
-    FTI_Checksum(FTI_Exec, FTI_Data, FTI_Conf, checksum);
+    if (FTI_Exec->integrity[0] != '\0') {
+        strncpy(checksum, FTI_Exec->integrity, MD5_DIGEST_STRING_LENGTH);
+        FTI_Exec->integrity[0] = '\0';
+    } else {
+        double ts = FTI_StatsStart();
+        FTI_Checksum(FTI_Exec, FTI_Data, FTI_Conf, checksum);
+        FTI_StatsStop(FTI_STAT_CHECKSUM, FTI_Exec->ckptLvel, ts, FTI_Exec->ckptSize);
+    }
 
     //TODO checksums of HDF5 files
 #ifdef ENABLE_HDF5
@@ -0,0 +1,305 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   pipeline.c
+ *  @date   October, 2018
+ *  @brief  File copy engines used by the L4 flush, the staging and the
+ *          checksum checks.
+ */
+#define _GNU_SOURCE
+
+#include "interface.h"
+
+#include <unistd.h>
+#ifdef HAVE_SENDFILE
+#   include <sys/sendfile.h>
+#endif
+
+/** 
+ * @brief ring of buffers shared by the reader thread and the writer. 
+ **/
+typedef struct FTIT_pipeline {
+    FILE*               lfd;            /**< File to read                   */
+    long                fs;             /**< Number of bytes to read        */
+    long                chunkSize;      /**< Size of the buffers            */
+    int                 nbBuffers;      /**< Number of buffers              */
+    char**              buffers;        /**< Buffers of the ring            */
+    size_t*             sizes;          /**< Bytes held by each buffer      */
+    int                 filled;         /**< Buffers ready to be written    */
+    bool                readError;      /**< TRUE if the reader failed      */
+    bool                abort;          /**< TRUE if the writer failed      */
+    pthread_mutex_t     lock;           /**< Protects the fields above      */
+    pthread_cond_t      notEmpty;       /**< Signals a filled buffer        */
+    pthread_cond_t      notFull;        /**< Signals a released buffer      */
+} FTIT_pipeline;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Main loop of the reader thread.
+  @param      arg             Pointer to the pipeline.
+  @return     void*           NULL.
+
+  The reader fills the buffers of the ring in order and blocks while all
+  buffers are waiting to be written.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void* FTI_PipelineReader(void* arg)
+{
+    FTIT_pipeline* pipe = (FTIT_pipeline*)arg;
+    long pos = 0;
+    int idx = 0;
+
+    while (pos < pipe->fs) {
+        pthread_mutex_lock(&pipe->lock);
+        while (pipe->filled == pipe->nbBuffers && !pipe->abort) {
+            pthread_cond_wait(&pipe->notFull, &pipe->lock);
+        }
+        bool abort = pipe->abort;
+        pthread_mutex_unlock(&pipe->lock);
+        if (abort) {
+            break;
+        }
+
+        long bSize = pipe->chunkSize;
+        if ((pipe->fs - pos) < bSize) {
+            bSize = pipe->fs - pos;
+        }
+        size_t bytes = fread(pipe->buffers[idx], sizeof(char), bSize, pipe->lfd);
+
+        pthread_mutex_lock(&pipe->lock);
+        if (ferror(pipe->lfd) || bytes == 0) {
+            pipe->readError = true;
+            pthread_cond_signal(&pipe->notEmpty);
+            pthread_mutex_unlock(&pipe->lock);
+            break;
+        }
+        pipe->sizes[idx] = bytes;
+        pipe->filled++;
+        pthread_cond_signal(&pipe->notEmpty);
+        pthread_mutex_unlock(&pipe->lock);
+
+        pos = pos + bytes;
+        idx = (idx + 1) % pipe->nbBuffers;
+    }
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Copies a file in chunks, overlapping reading and writing.
+  @param      lfd             File to read from.
+  @param      fs              Number of bytes to copy.
+  @param      chunkSize       Size of a chunk.
+  @param      nbBuffers       Number of chunks in flight.
+  @param      write           Function writing a chunk.
+  @param      opaque          Argument passed to the write function.
+  @return     integer         FTI_SCES if successful.
+
+  With more than one buffer, a reader thread loads the next chunks of
+  the file while the calling thread writes the chunks already read.
+  Hence, the copy takes about max(read, write) instead of the sum. The
+  write function is always called in the calling thread, thus, it may
+  use MPI. With one buffer (or if the reader thread cannot be created)
+  the chunks are read and written alternately.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_PipelinedCopy(FILE* lfd, long fs, long chunkSize, int nbBuffers,
+        FTIT_pipewrite write, void* opaque)
+{
+    FTIT_pipeline pipe;
+    pthread_t reader;
+    long pos = 0;
+    int i, res = FTI_SCES;
+
+    if (nbBuffers > 1 && fs > chunkSize) {
+        pipe.lfd = lfd;
+        pipe.fs = fs;
+        pipe.chunkSize = chunkSize;
+        pipe.nbBuffers = nbBuffers;
+        pipe.buffers = talloc(char*, nbBuffers);
+        pipe.sizes = talloc(size_t, nbBuffers);
+        for (i = 0; i < nbBuffers; i++) {
+            pipe.buffers[i] = talloc(char, chunkSize);
+        }
+        pipe.filled = 0;
+        pipe.readError = false;
+        pipe.abort = false;
+        pthread_mutex_init(&pipe.lock, NULL);
+        pthread_cond_init(&pipe.notEmpty, NULL);
+        pthread_cond_init(&pipe.notFull, NULL);
+
+        bool threaded = (pthread_create(&reader, NULL, FTI_PipelineReader, &pipe) == 0);
+        if (threaded) {
+            int idx = 0;
+            while (pos < fs) {
+                pthread_mutex_lock(&pipe.lock);
+                while (pipe.filled == 0 && !pipe.readError) {
+                    pthread_cond_wait(&pipe.notEmpty, &pipe.lock);
+                }
+                bool readError = (pipe.filled == 0);
+                pthread_mutex_unlock(&pipe.lock);
+                if (readError) {
+                    FTI_Print("Cannot read from the ckpt. file.", FTI_EROR);
+                    res = FTI_NSCS;
+                    break;
+                }
+
+                res = write(pipe.buffers[idx], pipe.sizes[idx], opaque);
+                if (res != FTI_SCES) {
+                    break;
+                }
+                pos = pos + pipe.sizes[idx];
+                idx = (idx + 1) % nbBuffers;
+
+                pthread_mutex_lock(&pipe.lock);
+                pipe.filled--;
+                pthread_cond_signal(&pipe.notFull);
+                pthread_mutex_unlock(&pipe.lock);
+            }
+
+            // stop the reader if the copy failed
+            pthread_mutex_lock(&pipe.lock);
+            pipe.abort = true;
+            pthread_cond_signal(&pipe.notFull);
+            pthread_mutex_unlock(&pipe.lock);
+            pthread_join(reader, NULL);
+        }
+        else {
+            FTI_Print("Cannot create the reader thread, copying serially.", FTI_WARN);
+        }
+
+        pthread_mutex_destroy(&pipe.lock);
+        pthread_cond_destroy(&pipe.notEmpty);
+        pthread_cond_destroy(&pipe.notFull);
+        for (i = 0; i < nbBuffers; i++) {
+            free(pipe.buffers[i]);
+        }
+        free(pipe.buffers);
+        free(pipe.sizes);
+
+        if (threaded) {
+            return res;
+        }
+    }
+
+    // Serial copy: read and write alternately
+    char* readData = talloc(char, chunkSize);
+    long bSize = chunkSize;
+    while (pos < fs) {
+        if ((fs - pos) < chunkSize) {
+            bSize = fs - pos;
+        }
+
+        size_t bytes = fread(readData, sizeof(char), bSize, lfd);
+        if (ferror(lfd) || bytes == 0) {
+            FTI_Print("Cannot read from the ckpt. file.", FTI_EROR);
+            free(readData);
+            return FTI_NSCS;
+        }
+
+        if (write(readData, bytes, opaque) != FTI_SCES) {
+            free(readData);
+            return FTI_NSCS;
+        }
+        pos = pos + bytes;
+    }
+    free(readData);
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Copies a file inside the kernel.
+  @param      fdIn            File descriptor to read from.
+  @param      fdOut           File descriptor to write to.
+  @param      fs              Number of bytes to copy.
+  @return     off_t           Bytes copied or -1 on error.
+
+  The data is copied from the current offset of 'fdIn' to the current
+  offset of 'fdOut' without passing through user space. First,
+  'copy_file_range' is tried, which lets reflink capable file systems
+  share the blocks. If it is not supported for the two files,
+  'sendfile' is used. If neither works, the function returns the bytes
+  copied so far (0 if nothing was copied). Both offsets are advanced
+  by this amount and the caller completes the copy with buffered I/O.
+  The function returns -1 only on an I/O error.
+
+ **/
+/*-------------------------------------------------------------------------*/
+off_t FTI_KernelCopy(int fdIn, int fdOut, off_t fs)
+{
+    off_t pos = 0;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    ssize_t bytes = 0;
+    while (pos < fs) {
+        bytes = copy_file_range(fdIn, NULL, fdOut, NULL, fs - pos, 0);
+        if (bytes <= 0) {
+            break;
+        }
+        pos = pos + bytes;
+    }
+    if (pos == fs) {
+        return pos;
+    }
+    if (bytes == -1 && errno != ENOSYS && errno != EXDEV && errno != EINVAL
+            && errno != EOPNOTSUPP && errno != EBADF) {
+        return -1;
+    }
+    errno = 0;
+#endif
+
+#ifdef HAVE_SENDFILE
+    ssize_t sent = 0;
+    while (pos < fs) {
+        sent = sendfile(fdOut, fdIn, NULL, fs - pos);
+        if (sent <= 0) {
+            break;
+        }
+        pos = pos + sent;
+    }
+    if (pos == fs) {
+        return pos;
+    }
+    if (sent == -1 && errno != ENOSYS && errno != EINVAL) {
+        return -1;
+    }
+    errno = 0;
+#endif
+
+    return pos;
+}
@@ -37,6 +37,7 @@
  */
 
 #include "interface.h"
+#include "utility.h"
 
 /*-------------------------------------------------------------------------*/
 /**
@@ -58,122 +59,377 @@ int FTI_Local(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     return FTI_SCES;
 }
 
+/** Partner copy state of one process for the delta L2 exchange.           */
+typedef struct FTIT_ptnerDelta {
+    int             sentID;     /**< Ckpt. ID of the last file sent.       */
+    int             recvID;     /**< Ckpt. ID of the last Ptner file.      */
+    long            nbBlocks;   /**< Number of blocks of the last file.    */
+    unsigned char*  hashes;     /**< MD5 digest of each block sent.        */
+} FTIT_ptnerDelta;
+
+static FTIT_ptnerDelta* FTI_PtnerDelta = NULL; //one entry per process handled
+static int FTI_PtnerDeltaSize = 0;
+
 /*-------------------------------------------------------------------------*/
 /**
-  @brief      It sends Ckpt file.
-  @param      FTI_Conf        Configuration metadata.
-  @param      FTI_Exec        Execution metadata.
-  @param      FTI_Ckpt        Checkpoint metadata.
-  @param      destination     destination group rank
-  @param      postFlag        0 if postckpt done by approc, > 0 if by head
-  @return     integer         FTI_SCES if successful.
-
-  This function sends ckpt file to partner process. Partner should call
-  FTI_RecvPtner to receive this file.
+  @brief      It returns the size of a block of a file.
+  @param      block           Index of the block.
+  @param      bs              Block size.
+  @param      size            File size.
+  @return     integer         Size of the block.
 
  **/
 /*-------------------------------------------------------------------------*/
-int FTI_SendCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_checkpoint* FTI_Ckpt,
-        int destination, int postFlag)
+static inline int FTI_PtnerBlockSize(long block, int bs, long size)
 {
-    char lfn[FTI_BUFS], str[FTI_BUFS];
-    snprintf(lfn, FTI_BUFS, "%s/%s", FTI_Conf->lTmpDir, &FTI_Exec->meta[0].ckptFile[postFlag * FTI_BUFS]);
+    long rem = size - block * bs;
+    return (rem > bs) ? bs : (int)rem;
+}
 
-    //PostFlag is set to 0 if Post-processing is inline and set to processes nodeID if Post-processing done by head
-    if (postFlag) {
-        snprintf(str, FTI_BUFS, "L2 trying to access process's %d ckpt. file (%s).", postFlag, lfn);
-    }
-    else {
-        snprintf(str, FTI_BUFS, "L2 trying to access local ckpt. file (%s).", lfn);
-    }
-    FTI_Print(str, FTI_DBUG);
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It hashes every block of the local ckpt. file.
+  @param      lfd             Local ckpt. file.
+  @param      size            File size.
+  @param      bs              Block size.
+  @param      buf             Buffer of at least bs bytes.
+  @param      hashes          MD5 digests of the blocks (out).
+  @return     integer         FTI_SCES if successful.
 
-    FILE* lfd = fopen(lfn, "rb");
-    if (lfd == NULL) {
-        FTI_Print("FTI failed to open L2 Ckpt. file.", FTI_DBUG);
-        return FTI_NSCS;
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_HashPtnerBlocks(FILE* lfd, long size, int bs, char* buf,
+        unsigned char* hashes)
+{
+    long nbBlocks = (size + bs - 1) / bs;
+    long b;
+    for (b = 0; b < nbBlocks; b++) {
+        size_t bSize = FTI_PtnerBlockSize(b, bs, size);
+        if (fread(buf, sizeof(char), bSize, lfd) != bSize || ferror(lfd)) {
+            FTI_Print("Error reading data from L2 ckpt file", FTI_DBUG);
+            return FTI_NSCS;
+        }
+        MD5((unsigned char*)buf, bSize, &hashes[b * MD5_DIGEST_LENGTH]);
     }
+    return FTI_SCES;
+}
 
-    char* buffer = talloc(char, FTI_Conf->blockSize);
-    long toSend = FTI_Exec->meta[0].fs[postFlag]; //remaining data to send
-    while (toSend > 0) {
-        int sendSize = (toSend > FTI_Conf->blockSize) ? FTI_Conf->blockSize : toSend;
-        int bytes = fread(buffer, sizeof(char), sendSize, lfd);
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It copies the previous Ptner file to the new checkpoint.
+  @param      src             Previous Ptner file.
+  @param      dst             New Ptner file.
+  @param      buf             Buffer of at least bs bytes.
+  @param      bs              Block size.
+  @return     integer         FTI_SCES if successful.
 
-        if (ferror(lfd)) {
-            FTI_Print("Error reading data from L2 ckpt file", FTI_DBUG);
+  The previous Ptner file belongs to the last committed L2 checkpoint and
+  must stay intact until the new checkpoint is committed. The copy is
+  done in the kernel if supported, on reflink capable file systems only
+  the blocks patched afterwards take up new space.
 
-            free(buffer);
-            fclose(lfd);
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_CopyPtnerFile(char* src, char* dst, char* buf, int bs)
+{
+    FILE* sfd = fopen(src, "rb");
+    if (sfd == NULL) {
+        return FTI_NSCS;
+    }
+    FILE* dfd = fopen(dst, "wb");
+    if (dfd == NULL) {
+        fclose(sfd);
+        return FTI_NSCS;
+    }
 
-            return FTI_NSCS;
+    int res = FTI_SCES;
+    struct stat st;
+    off_t copied = -1;
+    if (fstat(fileno(sfd), &st) == 0) {
+        copied = FTI_KernelCopy(fileno(sfd), fileno(dfd), st.st_size);
+    }
+    if (copied == -1) {
+        res = FTI_NSCS;
+    }
+    else if (copied < st.st_size) {
+        fseeko(sfd, copied, SEEK_SET);
+        fseeko(dfd, copied, SEEK_SET);
+        size_t bytes;
+        while (res == FTI_SCES && (bytes = fread(buf, sizeof(char), bs, sfd)) > 0) {
+            if (fwrite(buf, sizeof(char), bytes, dfd) != bytes) {
+                res = FTI_NSCS;
+            }
         }
+        if (ferror(sfd)) {
+            res = FTI_NSCS;
+        }
+    }
 
-        MPI_Send(buffer, bytes, MPI_CHAR, destination, FTI_Conf->generalTag, FTI_Exec->groupComm);
-        toSend -= bytes;
+    fclose(sfd);
+    if (fclose(dfd) != 0) {
+        res = FTI_NSCS;
     }
+    return res;
+}
 
-    free(buffer);
-    fclose(lfd);
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It frees the state of the delta L2 exchange.
 
-    return FTI_SCES;
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FreePtnerDelta()
+{
+    int i;
+    for (i = 0; i < FTI_PtnerDeltaSize; i++) {
+        free(FTI_PtnerDelta[i].hashes);
+    }
+    free(FTI_PtnerDelta);
+    FTI_PtnerDelta = NULL;
+    FTI_PtnerDeltaSize = 0;
 }
 
 /*-------------------------------------------------------------------------*/
 /**
-  @brief      It receives Ptner file.
+  @brief      It exchanges the ckpt. files with the partner processes.
   @param      FTI_Conf        Configuration metadata.
   @param      FTI_Exec        Execution metadata.
   @param      FTI_Ckpt        Checkpoint metadata.
-  @param      source          souce group rank
+  @param      destination     destination group rank
+  @param      source          source group rank
   @param      postFlag        0 if postckpt done by approc, > 0 if by head
   @return     integer         FTI_SCES if successful.
 
-  This function receives ckpt file from partner process and saves it as
-  Ptner file. Partner should call FTI_SendCkpt to send file.
+  This function sends the ckpt. file to the destination process and, at
+  the same time, receives the ckpt. file of the source process and saves
+  it as Ptner file. Both directions are pipelined with up to
+  FTI_PTNER_WINDOW blocks in flight, so that reading the local file and
+  writing the Ptner file overlap with the transfers.
+
+  With delta L2 enabled, the partners first tell each other which Ptner
+  file they still hold. If the destination holds the copy of the last file
+  sent, only the blocks whose MD5 digest changed are sent, and the
+  destination copies its previous copy into the new checkpoint and patches
+  the copy. The previous copy is left untouched, so that the last L2
+  checkpoint stays recoverable until the new one is committed. Otherwise
+  the whole file is sent.
+
+  If one of the files cannot be accessed, the exchange is still carried
+  out until the end, so that the partners do not wait forever, and
+  FTI_NSCS is returned.
 
  **/
 /*-------------------------------------------------------------------------*/
-int FTI_RecvPtner(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec, FTIT_checkpoint* FTI_Ckpt,
-        int source, int postFlag)
+int FTI_ExchangeCkpt(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_checkpoint* FTI_Ckpt, int destination, int source, int postFlag)
 {
+    char lfn[FTI_BUFS], pfn[FTI_BUFS], str[FTI_BUFS];
+    snprintf(lfn, FTI_BUFS, "%s/%s", FTI_Conf->lTmpDir, &FTI_Exec->meta[0].ckptFile[postFlag * FTI_BUFS]);
+
     //heads need to use ckptFile to get ckptID and rank
     int ckptID, rank;
     sscanf(&FTI_Exec->meta[0].ckptFile[postFlag * FTI_BUFS], "Ckpt%d-Rank%d.fti", &ckptID, &rank);
-
-    char pfn[FTI_BUFS], str[FTI_BUFS];
     snprintf(pfn, FTI_BUFS, "%s/Ckpt%d-Pcof%d.fti", FTI_Conf->lTmpDir, ckptID, rank);
-    snprintf(str, FTI_BUFS, "L2 trying to access Ptner file (%s).", pfn);
+
+    //PostFlag is set to 0 if Post-processing is inline and set to processes nodeID if Post-processing done by head
+    if (postFlag) {
+        snprintf(str, FTI_BUFS, "L2 trying to access process's %d ckpt. file (%s) and Ptner file (%s).", postFlag, lfn, pfn);
+    }
+    else {
+        snprintf(str, FTI_BUFS, "L2 trying to access local ckpt. file (%s) and Ptner file (%s).", lfn, pfn);
+    }
     FTI_Print(str, FTI_DBUG);
 
-    FILE* pfd = fopen(pfn, "wb");
+    int res = FTI_SCES;
+    FILE* lfd = fopen(lfn, "rb");
+    if (lfd == NULL) {
+        FTI_Print("FTI failed to open L2 Ckpt. file.", FTI_DBUG);
+        res = FTI_NSCS;
+    }
+
+    // requests [0, FTI_PTNER_WINDOW) are the sends, the others the receives
+    int bs = FTI_Conf->blockSize;
+    char* sendBuf = talloc(char, (long)FTI_PTNER_WINDOW * bs);
+    char* recvBuf = talloc(char, (long)FTI_PTNER_WINDOW * bs);
+    long fs = FTI_Exec->meta[0].fs[postFlag]; //size of the file to send
+    long pfs = FTI_Exec->meta[0].pfs[postFlag]; //size of the file to receive
+    long nbSendBlocks = (fs + bs - 1) / bs;
+
+    // changed blocks to send and to receive, NULL for the whole file
+    long *sendIdx = NULL, *recvIdx = NULL;
+    long nbSendIdx = -1, nbRecvIdx = -1;
+    unsigned char* hashes = NULL; //MD5 digests of the blocks sent
+    FTIT_ptnerDelta* delta = (FTI_Conf->l2Delta) ? &FTI_PtnerDelta[postFlag] : NULL;
+    if (delta != NULL) {
+        char prev[FTI_BUFS];
+        snprintf(prev, FTI_BUFS, "%s/Ckpt%d-Pcof%d.fti", FTI_Ckpt[2].dir, delta->recvID, rank);
+        int have = (delta->recvID >= 0 && access(prev, R_OK) == 0) ? delta->recvID : -1;
+        int peerHave;
+        MPI_Sendrecv(&have, 1, MPI_INT, source, FTI_Conf->generalTag,
+                &peerHave, 1, MPI_INT, destination, FTI_Conf->generalTag,
+                FTI_Exec->groupComm, MPI_STATUS_IGNORE);
+
+        hashes = talloc(unsigned char, nbSendBlocks * MD5_DIGEST_LENGTH);
+        if (res == FTI_SCES && peerHave >= 0 && peerHave == delta->sentID) {
+            res = FTI_HashPtnerBlocks(lfd, fs, bs, sendBuf, hashes);
+            if (res == FTI_SCES) {
+                sendIdx = talloc(long, nbSendBlocks);
+                nbSendIdx = 0;
+                long b;
+                for (b = 0; b < nbSendBlocks; b++) {
+                    if (b >= delta->nbBlocks || memcmp(&hashes[b * MD5_DIGEST_LENGTH],
+                                &delta->hashes[b * MD5_DIGEST_LENGTH], MD5_DIGEST_LENGTH) != 0) {
+                        sendIdx[nbSendIdx++] = b;
+                    }
+                }
+            }
+        }
+
+        MPI_Sendrecv(&nbSendIdx, 1, MPI_LONG, destination, FTI_Conf->generalTag,
+                &nbRecvIdx, 1, MPI_LONG, source, FTI_Conf->generalTag,
+                FTI_Exec->groupComm, MPI_STATUS_IGNORE);
+        if (nbRecvIdx >= 0) {
+            recvIdx = talloc(long, nbRecvIdx + 1);
+        }
+        MPI_Sendrecv(sendIdx, (nbSendIdx > 0) ? nbSendIdx : 0, MPI_LONG, destination, FTI_Conf->generalTag,
+                recvIdx, (nbRecvIdx > 0) ? nbRecvIdx : 0, MPI_LONG, source, FTI_Conf->generalTag,
+                FTI_Exec->groupComm, MPI_STATUS_IGNORE);
+
+        if (sendIdx != NULL) {
+            snprintf(str, FTI_BUFS, "L2 sending %ld of %ld blocks to the partner.", nbSendIdx, nbSendBlocks);
+            FTI_Print(str, FTI_DBUG);
+        }
+        // the new Ptner file starts as a copy of the previous one
+        if (recvIdx != NULL && FTI_CopyPtnerFile(prev, pfn, recvBuf, bs) != FTI_SCES) {
+            FTI_Print("FTI failed to copy the previous L2 ptner file.", FTI_DBUG);
+            res = FTI_NSCS;
+        }
+    }
+
+    FILE* pfd = fopen(pfn, (recvIdx != NULL) ? "r+b" : "wb");
     if (pfd == NULL) {
         FTI_Print("FTI failed to open L2 ptner file.", FTI_DBUG);
-        return FTI_NSCS;
+        res = FTI_NSCS;
+    }
+    else if (recvIdx != NULL && ftruncate(fileno(pfd), pfs) == -1) {
+        FTI_Print("FTI failed to truncate L2 ptner file.", FTI_DBUG);
+        res = FTI_NSCS;
     }
 
-    char* buffer = talloc(char, FTI_Conf->blockSize);
-    unsigned long toRecv = FTI_Exec->meta[0].pfs[postFlag]; //remaining data to receive
-    while (toRecv > 0) {
-        int recvSize = (toRecv > FTI_Conf->blockSize) ? FTI_Conf->blockSize : toRecv;
-        MPI_Recv(buffer, recvSize, MPI_CHAR, source, FTI_Conf->generalTag, FTI_Exec->groupComm, MPI_STATUS_IGNORE);
-        fwrite(buffer, sizeof(char), recvSize, pfd);
-
-        if (ferror(pfd)) {
-            FTI_Print("Error writing data to L2 ptner file", FTI_DBUG);
+    MPI_Request req[2 * FTI_PTNER_WINDOW];
+    int recvSize[FTI_PTNER_WINDOW], recvDone[FTI_PTNER_WINDOW];
+    long recvBlock[FTI_PTNER_WINDOW];
+    long toSend = (sendIdx != NULL) ? nbSendIdx : nbSendBlocks; //remaining blocks to send
+    long toRecv = (recvIdx != NULL) ? nbRecvIdx : (pfs + bs - 1) / bs; //remaining blocks to receive
+    long nbSent = 0, nbPosted = 0;
+    int i;
+    for (i = 0; i < FTI_PTNER_WINDOW; i++) {
+        req[i] = MPI_REQUEST_NULL;
+        req[FTI_PTNER_WINDOW + i] = MPI_REQUEST_NULL;
+        recvDone[i] = 0;
+    }
 
-            free(buffer);
-            fclose(pfd);
+    // messages between two processes do not overtake each other, hence
+    // the blocks are received in the order the receives are posted
+    for (i = 0; i < FTI_PTNER_WINDOW && toRecv > 0; i++) {
+        recvBlock[i] = (recvIdx != NULL) ? recvIdx[nbPosted] : nbPosted;
+        recvSize[i] = FTI_PtnerBlockSize(recvBlock[i], bs, pfs);
+        MPI_Irecv(&recvBuf[(long)i * bs], recvSize[i], MPI_CHAR, source, FTI_Conf->generalTag,
+                FTI_Exec->groupComm, &req[FTI_PTNER_WINDOW + i]);
+        nbPosted++;
+        toRecv--;
+    }
+    int slot = 0, next = 0; //next send slot, oldest pending receive
+    while (1) {
+        for (i = 0; i < FTI_PTNER_WINDOW && toSend > 0; i++, slot = (slot + 1) % FTI_PTNER_WINDOW) {
+            if (req[slot] != MPI_REQUEST_NULL) {
+                continue;
+            }
+            long block = (sendIdx != NULL) ? sendIdx[nbSent] : nbSent;
+            int sendSize = FTI_PtnerBlockSize(block, bs, fs);
+            if (res == FTI_SCES) {
+                if (sendIdx != NULL && fseeko(lfd, (off_t)block * bs, SEEK_SET) != 0) {
+                    FTI_Print("Error seeking in L2 ckpt file", FTI_DBUG);
+                    res = FTI_NSCS;
+                }
+                int bytes = (res == FTI_SCES) ? fread(&sendBuf[(long)slot * bs], sizeof(char), sendSize, lfd) : 0;
+                if (res == FTI_SCES && (ferror(lfd) || bytes != sendSize)) {
+                    FTI_Print("Error reading data from L2 ckpt file", FTI_DBUG);
+                    res = FTI_NSCS;
+                }
+                if (res == FTI_SCES && hashes != NULL && sendIdx == NULL) {
+                    MD5((unsigned char*)&sendBuf[(long)slot * bs], sendSize, &hashes[block * MD5_DIGEST_LENGTH]);
+                }
+            }
+            MPI_Isend(&sendBuf[(long)slot * bs], sendSize, MPI_CHAR, destination, FTI_Conf->generalTag,
+                    FTI_Exec->groupComm, &req[slot]);
+            nbSent++;
+            toSend--;
+        }
 
-            return FTI_NSCS;
+        int idx;
+        MPI_Waitany(2 * FTI_PTNER_WINDOW, req, &idx, MPI_STATUS_IGNORE);
+        if (idx == MPI_UNDEFINED) {
+            break; //all transfers completed
+        }
+        if (idx < FTI_PTNER_WINDOW) {
+            continue; //send slot is free again
+        }
+        recvDone[idx - FTI_PTNER_WINDOW] = 1;
+
+        // write the received blocks in order and reuse their buffers
+        while (recvDone[next]) {
+            recvDone[next] = 0;
+            if (res == FTI_SCES && recvIdx != NULL &&
+                    fseeko(pfd, (off_t)recvBlock[next] * bs, SEEK_SET) != 0) {
+                FTI_Print("Error seeking in L2 ptner file", FTI_DBUG);
+                res = FTI_NSCS;
+            }
+            if (res == FTI_SCES) {
+                size_t written;
+                FTI_FI_FWRITE(written, &recvBuf[(long)next * bs], sizeof(char), recvSize[next], pfd, pfn);
+                if (ferror(pfd) || written != (size_t) recvSize[next]) {
+                    FTI_Print("Error writing data to L2 ptner file", FTI_DBUG);
+                    res = FTI_NSCS;
+                }
+            }
+            if (toRecv > 0) {
+                recvBlock[next] = (recvIdx != NULL) ? recvIdx[nbPosted] : nbPosted;
+                recvSize[next] = FTI_PtnerBlockSize(recvBlock[next], bs, pfs);
+                MPI_Irecv(&recvBuf[(long)next * bs], recvSize[next], MPI_CHAR, source, FTI_Conf->generalTag,
+                        FTI_Exec->groupComm, &req[FTI_PTNER_WINDOW + next]);
+                nbPosted++;
+                toRecv--;
+            }
+            next = (next + 1) % FTI_PTNER_WINDOW;
         }
-        toRecv -= recvSize;
     }
 
-    free(buffer);
-    fclose(pfd);
+    free(sendBuf);
+    free(recvBuf);
+    free(sendIdx);
+    free(recvIdx);
+    if (lfd != NULL) {
+        fclose(lfd);
+    }
+    if (pfd != NULL && fclose(pfd) != 0) {
+        FTI_Print("FTI failed to close L2 ptner file.", FTI_DBUG);
+        res = FTI_NSCS;
+    }
 
-    return FTI_SCES;
+    // the partners hold the copies of this exchange from now on
+    if (delta != NULL && res == FTI_SCES) {
+        free(delta->hashes);
+        delta->hashes = hashes;
+        delta->nbBlocks = nbSendBlocks;
+        delta->sentID = ckptID;
+        delta->recvID = ckptID;
+    }
+    else {
+        free(hashes);
+    }
+
+    return res;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -211,28 +467,24 @@ int FTI_Ptner(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         endProc = 1;
     }
 
+    int i;
+    if (FTI_Conf->l2Delta && FTI_PtnerDelta == NULL) {
+        FTI_PtnerDelta = talloc(FTIT_ptnerDelta, endProc);
+        FTI_PtnerDeltaSize = endProc;
+        for (i = 0; i < endProc; i++) {
+            FTI_PtnerDelta[i].sentID = -1;
+            FTI_PtnerDelta[i].recvID = -1;
+            FTI_PtnerDelta[i].nbBlocks = 0;
+            FTI_PtnerDelta[i].hashes = NULL;
+        }
+    }
+
     int source = FTI_Topo->left; //receive Ckpt file from this process
     int destination = FTI_Topo->right; //send Ckpt file to this process
-    int i;
     for (i = startProc; i < endProc; i++) {
-        if (FTI_Topo->groupRank % 2) { //first send, then receive
-            int res = FTI_SendCkpt(FTI_Conf, FTI_Exec, FTI_Ckpt, destination, i);
-            if (res != FTI_SCES) {
-                return FTI_NSCS;
-            }
-            res = FTI_RecvPtner(FTI_Conf, FTI_Exec, FTI_Ckpt, source, i);
-            if (res != FTI_SCES) {
-                return FTI_NSCS;
-            }
-        } else { //first receive, then send
-            int res = FTI_RecvPtner(FTI_Conf, FTI_Exec, FTI_Ckpt, source, i);
-            if (res != FTI_SCES) {
-                return FTI_NSCS;
-            }
-            res = FTI_SendCkpt(FTI_Conf, FTI_Exec, FTI_Ckpt, destination, i);
-            if (res != FTI_SCES) {
-                return FTI_NSCS;
-            }
+        int res = FTI_ExchangeCkpt(FTI_Conf, FTI_Exec, FTI_Ckpt, destination, source, i);
+        if (res != FTI_SCES) {
+            return FTI_NSCS;
         }
     }
     return FTI_SCES;
@@ -273,6 +525,12 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         endProc = 1;
     }
 
+    // the encoding of each block is split among the threads of the pool
+    FTIT_threadPool* pool = FTI_GetThreadPool(FTI_Conf->rsThreads);
+    char str[FTI_BUFS];
+    snprintf(str, FTI_BUFS, "L3 encoding with %d thread(s), GF kernel: %s.", pool->nbActive, FTI_GfKernelName());
+    FTI_Print(str, FTI_DBUG);
+
     int proc;
     for (proc = startProc; proc < endProc; proc++) {
         int ckptID, rank;
@@ -282,7 +540,6 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         snprintf(lfn, FTI_BUFS, "%s/%s", FTI_Conf->lTmpDir, &FTI_Exec->meta[0].ckptFile[proc * FTI_BUFS]);
         snprintf(efn, FTI_BUFS, "%s/Ckpt%d-RSed%d.fti", FTI_Conf->lTmpDir, ckptID, rank);
 
-        char str[FTI_BUFS];
         snprintf(str, FTI_BUFS, "L3 trying to access local ckpt. file (%s).", lfn);
         FTI_Print(str, FTI_DBUG);
 
@@ -344,6 +601,7 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         char* coding = talloc(char, bs);
         char* data = talloc(char, 2 * bs);
         int* matrix = talloc(int, FTI_Topo->groupSize* FTI_Topo->groupSize);
+        FTIT_gfTable* tables = talloc(FTIT_gfTable, FTI_Topo->groupSize);
 
         int i;
         for (i = 0; i < FTI_Topo->groupSize; i++) {
@@ -353,6 +611,11 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             }
         }
 
+        // split tables for the coefficients of my row of the matrix
+        for (i = 0; i < FTI_Topo->groupSize; i++) {
+            FTI_GfInitTable(&tables[i], matrix[FTI_Topo->groupRank * FTI_Topo->groupSize + i]);
+        }
+
 
 
         int remBsize = bs;
@@ -373,13 +636,11 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             }
 
             // Reading checkpoint files
-            bzero(coding, bs);
-            bzero(myData, bs);
-            bzero(data, 2*bs);
             size_t bytes = fread(myData, sizeof(char), remBsize, lfd);
             if (ferror(lfd)) {
                 FTI_Print("FTI failed to read from L3 ckpt. file.", FTI_EROR);
 
+                free(tables);
                 free(data);
                 free(matrix);
                 free(coding);
@@ -390,6 +651,13 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                 return FTI_NSCS;
             }
 
+            // the last block is padded with zeros (coding is always
+            // overwritten by the first encoding step), the blocks received
+            // are padded after each receive
+            if (bytes < bs) {
+                bzero(&(data[bytes]), bs - bytes);
+            }
+
             int dest = FTI_Topo->groupRank;
             i = FTI_Topo->groupRank;
             int offset = 0;
@@ -403,8 +671,15 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                     memcpy(&(data[offset * bs]), myData, sizeof(char) * bytes);
                 }
                 else {
+                    MPI_Status status;
+                    int count;
                     MPI_Wait(&reqSend, MPI_STATUS_IGNORE);
-                    MPI_Wait(&reqRecv, MPI_STATUS_IGNORE);
+                    MPI_Wait(&reqRecv, &status);
+                    // the file of the peer may be shorter than this block
+                    MPI_Get_count(&status, MPI_CHAR, &count);
+                    if (count < bs) {
+                        bzero(&(data[offset * bs + count]), bs - count);
+                    }
                 }
 
                 // At every loop *but* the last one we send the data
@@ -423,13 +698,13 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                         init = 1;
                     }
                     else {
-                        galois_region_xor(&(data[offset * bs]), coding, bs);
+                        FTI_GfRegionXor(pool, &(data[offset * bs]), coding, bs);
                     }
                 }
 
                 // Then the data that needs to be multiplied by a factor
                 if (matVal != 0 && matVal != 1) {
-                    galois_w16_region_multiply(&(data[offset * bs]), matVal, bs, coding, init);
+                    FTI_GfRegionMultiply(pool, &tables[i], &(data[offset * bs]), coding, bs, init);
                     init = 1;
                 }
 
@@ -482,6 +757,7 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             if( buffer_ser == NULL ) {
                 snprintf( str, FTI_BUFS, "FTI_RSenc - failed to allocate %d bytes for 'buffer_ser'", FTI_dbvarstructsize );
                 FTI_Print(str, FTI_EROR);
+                free(tables);
                 free(data);
                 free(matrix);
                 free(coding);
@@ -494,6 +770,7 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             if( FTIFF_SerializeFileMeta( FTIFFMeta, buffer_ser ) != FTI_SCES ) {
                 FTI_Print("FTI_RSenc - failed to serialize 'currentdbvar'", FTI_EROR);
                 free(buffer_ser);
+                free(tables);
                 free(data);
                 free(matrix);
                 free(coding);
@@ -508,6 +785,7 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
                 snprintf(str, FTI_BUFS, "FTI_RSenc - could not write metadata in file: %s", efn);
                 FTI_Print(str, FTI_EROR);
                 errno=0;
+                free(tables);
                 free(data);
                 free(matrix);
                 free(coding);
@@ -520,6 +798,7 @@ int FTI_RSenc(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
         }
 
+        free(tables);
         free(data);
         free(matrix);
         free(coding);
@@ -561,7 +840,7 @@ return FTI_SCES;
 int FTI_Flush(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, FTIT_checkpoint* FTI_Ckpt, int level)
 {
-    if (!FTI_Topo->amIaHead && level == 0) {
+    if (level == 0 && (!FTI_Topo->amIaHead || FTI_Ckpt[4].isInline)) {
         return FTI_SCES; //inline L4 saves directly to PFS (nothing to flush)
     }
 
@@ -705,6 +984,27 @@ int FTI_ArchiveL4Ckpt( FTIT_configuration* FTI_Conf, FTIT_execution *FTI_Exec, F
 
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Writes a chunk of a local ckpt. file to the PFS file.
+  @param      src             The chunk to write.
+  @param      size            Size of the chunk.
+  @param      opaque          File pointer of the PFS file.
+  @return     integer         FTI_SCES if successful.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_FlushWritePosix(void* src, size_t size, void* opaque)
+{
+    FILE* gfd = (FILE*)opaque;
+    fwrite(src, sizeof(char), size, gfd);
+    if (ferror(gfd)) {
+        FTI_Print("L4 cannot write to the ckpt. file in the PFS.", FTI_EROR);
+        return FTI_NSCS;
+    }
+    return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It flushes the local ckpt. files in to the PFS using POSIX.
@@ -772,37 +1072,30 @@ int FTI_FlushPosix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             return FTI_NSCS;
         }
 
-        char *readData = talloc(char, FTI_Conf->transferSize);
-        long bSize = FTI_Conf->transferSize;
         long fs = FTI_Exec->meta[level].fs[proc];
         snprintf(str, FTI_BUFS, "Local file size for proc %d: %ld", proc, fs);
         FTI_Print(str, FTI_DBUG);
-        long pos = 0;
-        // Checkpoint files exchange
-        while (pos < fs) {
-            if ((fs - pos) < FTI_Conf->transferSize)
-                bSize = fs - pos;
-
-            size_t bytes = fread(readData, sizeof(char), bSize, lfd);
-            if (ferror(lfd)) {
-                FTI_Print("L4 cannot read from the ckpt. file.", FTI_EROR);
-                free(readData);
-                fclose(lfd);
-                fclose(gfd);
-                return FTI_NSCS;
-            }
-
-            fwrite(readData, sizeof(char), bytes, gfd);
-            if (ferror(gfd)) {
-                FTI_Print("L4 cannot write to the ckpt. file in the PFS.", FTI_EROR);
-                free(readData);
+        // Checkpoint files exchange (in-kernel copy if supported)
+        off_t copied = FTI_KernelCopy(fileno(lfd), fileno(gfd), fs);
+        if (copied == -1) {
+            FTI_Print("L4 cannot copy the ckpt. file to the PFS.", FTI_EROR);
+            fclose(lfd);
+            fclose(gfd);
+            return FTI_NSCS;
+        }
+        if (copied < fs) {
+            fseek(lfd, copied, SEEK_SET);
+            fseek(gfd, copied, SEEK_SET);
+            if (FTI_PipelinedCopy(lfd, fs - copied, FTI_Conf->transferSize, FTI_Conf->flushBuffers,
+                        FTI_FlushWritePosix, gfd) != FTI_SCES) {
                 fclose(lfd);
                 fclose(gfd);
                 return FTI_NSCS;
             }
-            pos = pos + bytes;
         }
-        free(readData);
+        if (FTI_Conf->directIO) { // the local file is not read again
+            posix_fadvise(fileno(lfd), 0, 0, POSIX_FADV_DONTNEED);
+        }
         fclose(lfd);
         fclose(gfd);
     }
@@ -828,14 +1121,6 @@ int FTI_FlushMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 {
     int res;
     FTI_Print("Starting checkpoint post-processing L4 using MPI-IO.", FTI_DBUG);
-    // enable collective buffer optimization
-    MPI_Info info;
-    MPI_Info_create(&info);
-    MPI_Info_set(info, "romio_cb_write", "enable");
-    // TODO enable to set stripping unit in the config file (Maybe also other hints)
-    // set stripping unit to 4MB
-    MPI_Info_set(info, "stripping_unit", "4194304");
-
     // open parallel file (collective call)
     MPI_File pfh; // MPI-IO file handle
     char gfn[FTI_BUFS], str[FTI_BUFS], ckptFile[FTI_BUFS];
@@ -857,17 +1142,16 @@ int FTI_FlushMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         }
     }
 #endif
-    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, info, &pfh);
+    // hints from the configuration (collective buffering, striping)
+    res = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_WRONLY|MPI_MODE_CREATE, FTI_Conf->mpiioInfo, &pfh);
     if (res != 0) {
         errno = 0;
         char mpi_err[FTI_BUFS];
         MPI_Error_string(res, mpi_err, NULL);
         snprintf(str, FTI_BUFS, "Unable to create file during MPI-IO flush [MPI ERROR - %i] %s", res, mpi_err);
         FTI_Print(str, FTI_EROR);
-        MPI_Info_free(&info);
         return FTI_NSCS;
     }
-    MPI_Info_free(&info);
 
     int proc, startProc, endProc;
     if (FTI_Topo->amIaHead) {
@@ -918,52 +1202,33 @@ int FTI_FlushMPI(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             return FTI_NSCS;
         }
 
-        char* readData = talloc(char, FTI_Conf->transferSize);
-        long bSize = FTI_Conf->transferSize;
-        long fs = FTI_Exec->meta[level].fs[proc];
+        WriteMPIInfo_t write_info;
+        write_info.FTI_Conf = FTI_Conf;
+        write_info.pfh = pfh;
+        write_info.offset = offset;
+        write_info.err = 0;
+        write_info.integrity = NULL;
 
-        long pos = 0;
+        long fs = FTI_Exec->meta[level].fs[proc];
         // Checkpoint files exchange
-        while (pos < fs) {
-            if ((fs - pos) < FTI_Conf->transferSize) {
-                bSize = fs - pos;
-            }
-
-            size_t bytes = fread(readData, sizeof(char), bSize, lfd);
-            if (ferror(lfd)) {
-                FTI_Print("L4 cannot read from the ckpt. file.", FTI_EROR);
-                free(localFileNames);
-                free(allFileSizes);
-                free(splitRanks);
-                free(readData);
-                fclose(lfd);
-                MPI_File_close(&pfh);
-                return FTI_NSCS;
-            }
-            MPI_Datatype dType;
-            MPI_Type_contiguous(bytes, MPI_BYTE, &dType);
-            MPI_Type_commit(&dType);
-
-            res = MPI_File_write_at(pfh, offset, readData, 1, dType, MPI_STATUS_IGNORE);
-            // check if successful
-            if (res != 0) {
-                errno = 0;
+        if (FTI_PipelinedCopy(lfd, fs, FTI_Conf->transferSize, FTI_Conf->flushBuffers,
+                    write_mpi, &write_info) != FTI_SCES) {
+            if (write_info.err != 0) {
                 char mpi_err[FTI_BUFS];
-                MPI_Error_string(res, mpi_err, NULL);
-                snprintf(str, FTI_BUFS, "Failed to write data to PFS during MPIIO Flush [MPI ERROR - %i] %s", res, mpi_err);
+                MPI_Error_string(write_info.err, mpi_err, NULL);
+                snprintf(str, FTI_BUFS, "Failed to write data to PFS during MPIIO Flush [MPI ERROR - %i] %s", write_info.err, mpi_err);
                 FTI_Print(str, FTI_EROR);
-                free(localFileNames);
-                free(splitRanks);
-                free(allFileSizes);
-                fclose(lfd);
-                MPI_File_close(&pfh);
-                return FTI_NSCS;
             }
-            MPI_Type_free(&dType);
-            offset += bytes;
-            pos = pos + bytes;
+            free(localFileNames);
+            free(allFileSizes);
+            free(splitRanks);
+            fclose(lfd);
+            MPI_File_close(&pfh);
+            return FTI_NSCS;
+        }
+        if (FTI_Conf->directIO) { // the local file is not read again
+            posix_fadvise(fileno(lfd), 0, 0, POSIX_FADV_DONTNEED);
         }
-        free(readData);
         fclose(lfd);
     }
     free(localFileNames);
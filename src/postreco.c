@@ -70,20 +70,22 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
   char** data = talloc(char*, k);
   char** coding = talloc(char*, m);
-  char* dataTmp = talloc(char, FTI_Conf->blockSize* k);
+  char* dataBuf = talloc(char, FTI_Conf->blockSize* k);
+  char* codingBuf = talloc(char, FTI_Conf->blockSize* m);
   int* dm_ids = talloc(int, k);
-  int* decMatrix = talloc(int, k* k);
-  int* tmpmat = talloc(int, k* k);
   int* matrix = talloc(int, k* k);
+  FTIT_gfTable* decTables = talloc(FTIT_gfTable, k);
+  FTIT_gfTable* encTables = talloc(FTIT_gfTable, k);
   int i, j;
   for (i = 0; i < FTI_Topo->groupSize; i++) {
     for (j = 0; j < FTI_Topo->groupSize; j++) {
       matrix[i * FTI_Topo->groupSize + j] = galois_single_divide(1, i ^ (FTI_Topo->groupSize + j), FTI_Conf->l3WordSize);
     }
   }
+  // the blocks of the group are gathered in place
   for (i = 0; i < m; i++) {
-    coding[i] = talloc(char, FTI_Conf->blockSize);
-    data[i] = talloc(char, FTI_Conf->blockSize);
+    coding[i] = codingBuf + i * bs;
+    data[i] = dataBuf + i * bs;
   }
   j = 0;
   for (i = 0; j < k; i++) {
@@ -92,40 +94,32 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
       j++;
     }
   }
-  // Building the matrix
-  for (i = 0; i < k; i++) {
-    if (dm_ids[i] < k) {
-      for (j = 0; j < k; j++) {
-        tmpmat[i * k + j] = 0;
-      }
-      tmpmat[i * k + dm_ids[i]] = 1;
-    }
-    else {
-      for (j = 0; j < k; j++) {
-        tmpmat[i * k + j] = matrix[(dm_ids[i] - k) * k + j];
-      }
-    }
-  }
 
   // Inversing the matrix
-  if (jerasure_invert_matrix(tmpmat, decMatrix, k, FTI_Conf->l3WordSize) < 0) {
+  int* decMatrix = FTI_GfGetDecodingMatrix(matrix, erased, k, FTI_Conf->l3WordSize);
+  if (decMatrix == NULL) {
     FTI_Print("Error inversing matrix", FTI_DBUG);
 
-    for (i = 0; i < m; i++) {
-      free(coding[i]);
-      free(data[i]);
-    }
-    free(tmpmat);
     free(dm_ids);
-    free(decMatrix);
     free(matrix);
+    free(decTables);
+    free(encTables);
     free(data);
-    free(dataTmp);
+    free(dataBuf);
     free(coding);
+    free(codingBuf);
 
     return FTI_NSCS;
   }
 
+  // Split tables of the decoding and encoding rows of this rank
+  for (i = 0; i < k; i++) {
+    FTI_GfInitTable(&decTables[i], decMatrix[FTI_Topo->groupRank * k + i]);
+    FTI_GfInitTable(&encTables[i], matrix[FTI_Topo->groupRank * k + i]);
+  }
+  free(decMatrix);
+  FTIT_threadPool* pool = FTI_GetThreadPool(FTI_Conf->rsThreads);
+
   FILE *fd, *efd;
   long maxFs = FTI_Exec->meta[3].maxFs[0];
   long ps = ((maxFs / FTI_Conf->blockSize)) * FTI_Conf->blockSize;
@@ -145,18 +139,14 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     if (truncate(fn, maxFs) == -1) {
       FTI_Print("Error with truncate on checkpoint file", FTI_DBUG);
 
-      for (i = 0; i < m; i++) {
-        free(coding[i]);
-        free(data[i]);
-      }
-
-      free(tmpmat);
       free(dm_ids);
-      free(decMatrix);
       free(matrix);
+      free(decTables);
+      free(encTables);
       free(data);
-      free(dataTmp);
+      free(dataBuf);
       free(coding);
+      free(codingBuf);
 
       return FTI_NSCS;
     }
@@ -199,17 +189,14 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     if (efd) {
       fclose(efd);
     }
-    for (i = 0; i < m; i++) {
-      free(coding[i]);
-      free(data[i]);
-    }
-    free(tmpmat);
     free(dm_ids);
-    free(decMatrix);
     free(matrix);
+    free(decTables);
+    free(encTables);
     free(data);
-    free(dataTmp);
+    free(dataBuf);
     free(coding);
+    free(codingBuf);
 
     return FTI_NSCS;
   }
@@ -219,17 +206,14 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     fclose(fd);
 
-    for (i = 0; i < m; i++) {
-      free(coding[i]);
-      free(data[i]);
-    }
-    free(tmpmat);
     free(dm_ids);
-    free(decMatrix);
     free(matrix);
+    free(decTables);
+    free(encTables);
     free(data);
-    free(dataTmp);
+    free(dataBuf);
     free(coding);
+    free(codingBuf);
 
     return FTI_NSCS;
   }
@@ -246,9 +230,11 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
       remBsize = maxFs - pos;
     }
 
-    // Reading the data
+    // Reading the data (only the tail of the last block needs padding)
     if (erased[FTI_Topo->groupRank] == 0) {
-      bzero(data[FTI_Topo->groupRank], bs);
+      if (remBsize < bs) {
+        bzero(data[FTI_Topo->groupRank] + remBsize, bs - remBsize);
+      }
       fread(data[FTI_Topo->groupRank] + 0, sizeof(char), remBsize, fd);
 
       if (ferror(fd)) {
@@ -257,24 +243,23 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         fclose(fd);
         fclose(efd);
 
-        for (i = 0; i < m; i++) {
-          free(coding[i]);
-          free(data[i]);
-        }
-        free(tmpmat);
         free(dm_ids);
-        free(decMatrix);
         free(matrix);
+        free(decTables);
+        free(encTables);
         free(data);
-        free(dataTmp);
+        free(dataBuf);
         free(coding);
+        free(codingBuf);
 
         return FTI_NSCS;
       }
     }
 
     if (erased[FTI_Topo->groupRank + FTI_Topo->groupSize] == 0) {
-      bzero(coding[FTI_Topo->groupRank], bs);
+      if (remBsize < bs) {
+        bzero(coding[FTI_Topo->groupRank] + remBsize, bs - remBsize);
+      }
       fread(coding[FTI_Topo->groupRank] + 0, sizeof(char), remBsize, efd);
 
       if (ferror(efd)) {
@@ -283,45 +268,32 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         fclose(fd);
         fclose(efd);
 
-        for (i = 0; i < m; i++) {
-          free(coding[i]);
-          free(data[i]);
-        }
-        free(tmpmat);
         free(dm_ids);
-        free(decMatrix);
         free(matrix);
+        free(decTables);
+        free(encTables);
         free(data);
-        free(dataTmp);
+        free(dataBuf);
         free(coding);
+        free(codingBuf);
 
         return FTI_NSCS;
       }
     }
 
-    MPI_Allgather(data[FTI_Topo->groupRank] + 0, bs, MPI_CHAR, dataTmp, bs, MPI_CHAR, FTI_Exec->groupComm);
-    for (i = 0; i < k; i++) {
-      memcpy(data[i] + 0, &(dataTmp[i * bs]), sizeof(char) * bs);
-    }
-
-    MPI_Allgather(coding[FTI_Topo->groupRank] + 0, bs, MPI_CHAR, dataTmp, bs, MPI_CHAR, FTI_Exec->groupComm);
-    for (i = 0; i < k; i++) {
-      memcpy(coding[i] + 0, &(dataTmp[i * bs]), sizeof(char) * bs);
-    }
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, dataBuf, bs, MPI_CHAR, FTI_Exec->groupComm);
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, codingBuf, bs, MPI_CHAR, FTI_Exec->groupComm);
 
     // Decoding the lost data work
     if (erased[FTI_Topo->groupRank]) {
-      jerasure_matrix_dotprod(k, FTI_Conf->l3WordSize, decMatrix + (FTI_Topo->groupRank * k), dm_ids, FTI_Topo->groupRank, data, coding, bs);
+      FTI_GfMatrixDotprod(pool, k, decTables, dm_ids, FTI_Topo->groupRank, data, coding, bs);
     }
 
-    MPI_Allgather(data[FTI_Topo->groupRank] + 0, bs, MPI_CHAR, dataTmp, bs, MPI_CHAR, FTI_Exec->groupComm);
-    for (i = 0; i < k; i++) {
-      memcpy(data[i] + 0, &(dataTmp[i * bs]), sizeof(char) * bs);
-    }
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, dataBuf, bs, MPI_CHAR, FTI_Exec->groupComm);
 
     // Finally, re-encode any erased encoded checkpoint file
     if (erased[FTI_Topo->groupRank + k]) {
-      jerasure_matrix_dotprod(k, FTI_Conf->l3WordSize, matrix + (FTI_Topo->groupRank * k), NULL, FTI_Topo->groupRank + k, data, coding, bs);
+      FTI_GfMatrixDotprod(pool, k, encTables, NULL, FTI_Topo->groupRank + k, data, coding, bs);
     }
     if (erased[FTI_Topo->groupRank]) {
       fwrite(data[FTI_Topo->groupRank] + 0, sizeof(char), remBsize, fd);
@@ -432,32 +404,26 @@ int FTI_Decode(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   if (truncate(fn, fs) == -1) {
     FTI_Print("R3 cannot re-truncate checkpoint file.", FTI_WARN);
 
-    for (i = 0; i < m; i++) {
-      free(coding[i]);
-      free(data[i]);
-    }
-    free(tmpmat);
     free(dm_ids);
-    free(decMatrix);
     free(matrix);
+    free(decTables);
+    free(encTables);
     free(data);
-    free(dataTmp);
+    free(dataBuf);
     free(coding);
+    free(codingBuf);
 
     return FTI_NSCS;
   }
 
-  for (i = 0; i < m; i++) {
-    free(coding[i]);
-    free(data[i]);
-  }
-  free(tmpmat);
   free(dm_ids);
-  free(decMatrix);
   free(matrix);
+  free(decTables);
+  free(encTables);
   free(data);
-  free(dataTmp);
+  free(dataBuf);
   free(coding);
+  free(codingBuf);
 
   return FTI_SCES;
 }
@@ -959,6 +925,9 @@ int FTI_RecoverL4Posix(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 
     snprintf(FTI_Exec->meta[1].ckptFile, FTI_BUFS, "Ckpt%d-Rank%d.fti", FTI_Exec->ckptID, FTI_Topo->myRank);
     snprintf(FTI_Exec->meta[4].ckptFile, FTI_BUFS, "Ckpt%d-Rank%d.fti", FTI_Exec->ckptID, FTI_Topo->myRank);
+    if ( FTI_Ckpt[4].isDcp ) {
+      snprintf(FTI_Exec->meta[4].ckptFile, FTI_BUFS, "%s", FTI_Ckpt[4].dcpName);
+    }
 
 #ifdef ENABLE_HDF5
     if (FTI_Conf->ioMode == FTI_IO_HDF5) {
@@ -1063,23 +1032,26 @@ int FTI_RecoverL4Mpi(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     }
   }
 
-  // enable collective buffer optimization
+  // hints from the configuration and collective buffer optimization
   MPI_Info info;
-  MPI_Info_create(&info);
+  MPI_Info_dup(FTI_Conf->mpiioInfo, &info);
   MPI_Info_set(info, "romio_cb_read", "enable");
 
-  // set stripping unit to 4MB
-  MPI_Info_set(info, "stripping_unit", "4194304");
-
   snprintf(FTI_Exec->meta[1].ckptFile, FTI_BUFS, "Ckpt%d-Rank%d.fti", FTI_Exec->ckptID, FTI_Topo->myRank);
   snprintf(FTI_Exec->meta[4].ckptFile, FTI_BUFS, "Ckpt%d-mpiio.fti", FTI_Exec->ckptID);
   char gfn[FTI_BUFS], lfn[FTI_BUFS];
   snprintf(lfn, FTI_BUFS, "%s/%s", FTI_Ckpt[1].dir, FTI_Exec->meta[1].ckptFile);
-  snprintf(gfn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dir, FTI_Exec->meta[4].ckptFile);
+  if ( FTI_Ckpt[4].isDcp ) {
+    snprintf(FTI_Exec->meta[4].ckptFile, FTI_BUFS, "%s", FTI_Ckpt[4].dcpName);
+    snprintf(gfn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dcpDir, FTI_Exec->meta[4].ckptFile);
+  } else {
+    snprintf(gfn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dir, FTI_Exec->meta[4].ckptFile);
+  }
 
   // open parallel file
   MPI_File pfh;
   int buf = MPI_File_open(FTI_COMM_WORLD, gfn, MPI_MODE_RDWR, info, &pfh);
+  MPI_Info_free(&info);
   // check if successful
   if (buf != 0) {
     errno = 0;
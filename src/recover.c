@@ -82,6 +82,58 @@ int FTI_CheckFile(char* fn, long fs, char* checksum)
     }
 }
 
+/** @typedef    FTIT_fileCheck
+ *  @brief      Consistency check of one file.
+ */
+typedef struct FTIT_fileCheck {
+    int             (*consistency)(char*, long, char*); /**< Check function */
+    char*           fn;                 /**< File to check.                 */
+    long            fs;                 /**< Expected file size.            */
+    char*           checksum;           /**< Expected checksum.             */
+    int             res;                /**< 0 if consistent, 1 otherwise.  */
+} FTIT_fileCheck;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Runs a file check in a separate thread.
+  @param      arg             Pointer to the file check.
+  @return     void*           NULL.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void* FTI_CheckFileThread(void* arg)
+{
+    FTIT_fileCheck* check = (FTIT_fileCheck*)arg;
+    check->res = check->consistency(check->fn, check->fs, check->checksum);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It checks two files of a checkpoint at the same time.
+  @param      first           Check of the checkpoint file.
+  @param      second          Check of the partner or encoded file.
+  @param      threaded        TRUE if the checks may run concurrently.
+
+  The second file is checked in a separate thread while the calling
+  thread checks the first one, so that reading and hashing both files
+  (L2 and L3) takes about as long as for the larger one. If the thread
+  cannot be created, the files are checked one after the other.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_CheckFilePair(FTIT_fileCheck* first, FTIT_fileCheck* second, bool threaded)
+{
+    pthread_t thread;
+    if (threaded && pthread_create(&thread, NULL, FTI_CheckFileThread, second) == 0) {
+        FTI_CheckFileThread(first);
+        pthread_join(thread, NULL);
+        return;
+    }
+    FTI_CheckFileThread(first);
+    FTI_CheckFileThread(second);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It detects all the erasures for a particular level.
@@ -115,6 +167,8 @@ int FTI_CheckErasures(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     snprintf(str, FTI_BUFS, "Checking file %s and its erasures.", ckptFile);
     FTI_Print(str, FTI_DBUG);
     char fn[FTI_BUFS]; //Path to the checkpoint/partner file name
+    char pfn[FTI_BUFS]; //Path to the partner/encoded file name
+    FTIT_fileCheck ckptCheck, ptnerCheck;
     int buf;
     int ckptID, rank; //Variables for proper partner file name
     int (*consistency)(char *, long , char*);
@@ -126,7 +180,9 @@ int FTI_CheckErasures(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
 #else
     consistency = &FTI_CheckFile;
 #endif
-    
+    // the HDF5 library may not be thread-safe
+    bool threaded = (consistency == &FTI_CheckFile);
+
     switch (level) {
         case 1:
             snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[1].dir, ckptFile);
@@ -135,26 +191,32 @@ int FTI_CheckErasures(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
             break;
         case 2:
             snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[2].dir, ckptFile);
-            buf = consistency(fn, fs, checksum);
-            MPI_Allgather(&buf, 1, MPI_INT, erased, 1, MPI_INT, FTI_Exec->groupComm);
-
             sscanf(ckptFile, "Ckpt%d-Rank%d.fti", &ckptID, &rank);
-            snprintf(fn, FTI_BUFS, "%s/Ckpt%d-Pcof%d.fti", FTI_Ckpt[2].dir, ckptID, rank);
-            buf = consistency(fn, pfs, ptnerChecksum);
-            MPI_Allgather(&buf, 1, MPI_INT, erased + FTI_Topo->groupSize, 1, MPI_INT, FTI_Exec->groupComm);
+            snprintf(pfn, FTI_BUFS, "%s/Ckpt%d-Pcof%d.fti", FTI_Ckpt[2].dir, ckptID, rank);
+            ckptCheck = (FTIT_fileCheck){ consistency, fn, fs, checksum, 1 };
+            ptnerCheck = (FTIT_fileCheck){ consistency, pfn, pfs, ptnerChecksum, 1 };
+            FTI_CheckFilePair(&ckptCheck, &ptnerCheck, threaded);
+
+            MPI_Allgather(&ckptCheck.res, 1, MPI_INT, erased, 1, MPI_INT, FTI_Exec->groupComm);
+            MPI_Allgather(&ptnerCheck.res, 1, MPI_INT, erased + FTI_Topo->groupSize, 1, MPI_INT, FTI_Exec->groupComm);
             break;
         case 3:
             snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[3].dir, ckptFile);
-            buf = consistency(fn, fs, checksum);
-            MPI_Allgather(&buf, 1, MPI_INT, erased, 1, MPI_INT, FTI_Exec->groupComm);
-
             sscanf(ckptFile, "Ckpt%d-Rank%d.fti", &ckptID, &rank);
-            snprintf(fn, FTI_BUFS, "%s/Ckpt%d-RSed%d.fti", FTI_Ckpt[3].dir, ckptID, rank);
-            buf = FTI_CheckFile(fn, maxFs, rsChecksum);
-            MPI_Allgather(&buf, 1, MPI_INT, erased + FTI_Topo->groupSize, 1, MPI_INT, FTI_Exec->groupComm);
+            snprintf(pfn, FTI_BUFS, "%s/Ckpt%d-RSed%d.fti", FTI_Ckpt[3].dir, ckptID, rank);
+            ckptCheck = (FTIT_fileCheck){ consistency, fn, fs, checksum, 1 };
+            ptnerCheck = (FTIT_fileCheck){ &FTI_CheckFile, pfn, maxFs, rsChecksum, 1 };
+            FTI_CheckFilePair(&ckptCheck, &ptnerCheck, threaded);
+
+            MPI_Allgather(&ckptCheck.res, 1, MPI_INT, erased, 1, MPI_INT, FTI_Exec->groupComm);
+            MPI_Allgather(&ptnerCheck.res, 1, MPI_INT, erased + FTI_Topo->groupSize, 1, MPI_INT, FTI_Exec->groupComm);
             break;
         case 4:
-            snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dir, ckptFile);
+            if (FTI_Ckpt[4].isDcp) { //dCP file updated in place
+                snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dcpDir, FTI_Ckpt[4].dcpName);
+            } else {
+                snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[4].dir, ckptFile);
+            }
             buf = consistency(fn, fs, checksum);
             MPI_Allgather(&buf, 1, MPI_INT, erased, 1, MPI_INT, FTI_Exec->groupComm);
             break;
@@ -344,3 +406,155 @@ int FTI_RecoverFiles(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         return FTI_SCES;
     }
 }
+
+/** Checkpoint file mapped for FTI_RecoverVar (NULL if not mapped).      */
+static char* recoVarMap = NULL;
+/** Size of the mapping.                                                  */
+static size_t recoVarMapSize = 0;
+/** File offset of each variable, in the order of the metadata.          */
+static long* recoVarOffset = NULL;
+/** Number of entries in recoVarOffset.                                   */
+static int recoVarNb = 0;
+/** TRUE if the recovery state is initialized.                            */
+static bool recoVarInit = false;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It prepares the recovery of single variables.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      FTI_Ckpt        Checkpoint metadata.
+  @return     integer         FTI_SCES if successful.
+
+  The checkpoint file is opened and mapped once and the offsets of all
+  variables are computed from the metadata. The state is kept until
+  FTI_FinalizeRecoverVar is called, i.e. until the recovery phase ends
+  (next checkpoint, FTI_Recover or FTI_Finalize).
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_InitRecoverVar(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
+        FTIT_checkpoint* FTI_Ckpt)
+{
+    if (recoVarInit) {
+        return FTI_SCES;
+    }
+
+    char fn[FTI_BUFS], str[FTI_BUFS];
+    //Recovering from local for L4 case in FTI_Recover
+    if (FTI_Exec->ckptLvel == 4) {
+        snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[1].dir, FTI_Exec->meta[1].ckptFile);
+    }
+    else {
+        snprintf(fn, FTI_BUFS, "%s/%s", FTI_Ckpt[FTI_Exec->ckptLvel].dir, FTI_Exec->meta[FTI_Exec->ckptLvel].ckptFile);
+    }
+
+    snprintf(str, FTI_BUFS, "Mapping FTI checkpoint file (%s)...", fn);
+    FTI_Print(str, FTI_DBUG);
+
+    // offsets of the variables in the file
+    FTIT_metadata* meta = &FTI_Exec->meta[FTI_Exec->ckptLvel];
+    int nbVar = meta->nbVar[0];
+    if (nbVar < (int)FTI_Exec->nbVar) {
+        nbVar = FTI_Exec->nbVar;
+    }
+    if (nbVar > (int)FTI_Exec->nbVarMax) {
+        nbVar = FTI_Exec->nbVarMax;
+    }
+    recoVarOffset = talloc(long, nbVar + 1);
+    long offset = 0;
+    int i;
+    for (i = 0; i < nbVar; i++) {
+        recoVarOffset[i] = offset;
+        offset += meta->varSize[i];
+    }
+    recoVarOffset[nbVar] = offset;
+    recoVarNb = nbVar;
+
+    int fd = open(fn, O_RDONLY);
+    if (fd == -1) {
+        FTI_Print("Could not open FTI checkpoint file.", FTI_EROR);
+        FTI_FinalizeRecoverVar();
+        return FTI_NREC;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        FTI_Print("Could not stat FTI checkpoint file.", FTI_EROR);
+        close(fd);
+        FTI_FinalizeRecoverVar();
+        return FTI_NREC;
+    }
+    recoVarMapSize = st.st_size;
+    if (recoVarMapSize > 0) {
+        recoVarMap = mmap(NULL, recoVarMapSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (recoVarMap == MAP_FAILED) {
+            recoVarMap = NULL;
+            FTI_Print("Could not map FTI checkpoint file.", FTI_EROR);
+            close(fd);
+            FTI_FinalizeRecoverVar();
+            return FTI_NREC;
+        }
+    }
+    // the mapping stays valid after closing the file
+    if (close(fd) != 0) {
+        FTI_Print("Could not close FTI checkpoint file.", FTI_EROR);
+        FTI_FinalizeRecoverVar();
+        return FTI_NREC;
+    }
+
+    recoVarInit = true;
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It recovers one variable from the mapped checkpoint file.
+  @param      FTI_Exec        Execution metadata.
+  @param      data            Dataset to recover.
+  @return     integer         FTI_SCES if successful.
+
+  FTI_InitRecoverVar must have been called before. The size of the
+  dataset is expected to match the metadata (checked by FTI_RecoverVar).
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_RecoverVarMapped(FTIT_execution* FTI_Exec, FTIT_dataset* data)
+{
+    char str[FTI_BUFS];
+    int i = FTI_GetMetaVarIdx(FTI_Exec, FTI_Exec->ckptLvel, data->id);
+    if (!recoVarInit || i < 0 || i >= recoVarNb) {
+        FTI_Print("Variables must be protected before they can be recovered.", FTI_EROR);
+        return FTI_NREC;
+    }
+    if (recoVarOffset[i] + data->size > recoVarMapSize) {
+        FTI_Print("Could not read FTI checkpoint file.", FTI_EROR);
+        return FTI_NREC;
+    }
+
+    snprintf(str, FTI_BUFS, "Recovering var %d ", data->id);
+    FTI_Print(str, FTI_DBUG);
+    if (data->size > 0) {
+        memcpy(data->ptr, recoVarMap + recoVarOffset[i], data->size);
+    }
+
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It releases the state of FTI_InitRecoverVar.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FinalizeRecoverVar()
+{
+    if (recoVarMap != NULL) {
+        munmap(recoVarMap, recoVarMapSize);
+    }
+    free(recoVarOffset);
+    recoVarMap = NULL;
+    recoVarMapSize = 0;
+    recoVarOffset = NULL;
+    recoVarNb = 0;
+    recoVarInit = false;
+}
@@ -0,0 +1,163 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   registry.c
+ *  @date   October, 2018
+ *  @brief  Hash index over the ids of the protected datasets.
+ */
+
+#include "interface.h"
+
+/** Initial number of slots of the registry (power of two).                */
+#define FTI_REGISTRY_MIN 512
+
+/** 
+ * @brief open addressing hash table (created on first registration). 
+ **/
+static FTIT_registryEntry *registry = NULL;
+
+/** Number of slots and number of used slots of the registry.              */
+static int registrySize = 0;
+static int registryCount = 0;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Computes the home slot of a dataset id.
+  @param      id              Id of the dataset.
+  @param      size            Number of slots (power of two).
+  @return     integer         Slot index.
+
+  Multiplicative hashing, consecutive ids are mapped to distinct slots.
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_RegistrySlot(int id, int size)
+{
+    return (int)(((unsigned int) id * 2654435761u) & (unsigned int)(size - 1));
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Inserts an entry without checking the load of the table.
+  @param      table           Slots of the table.
+  @param      size            Number of slots (power of two).
+  @param      id              Id of the dataset.
+  @param      idx             Index of the dataset.
+  @return     integer         1 if a new slot was used, 0 if updated.
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_RegistryPut(FTIT_registryEntry* table, int size, int id, int idx)
+{
+    int slot = FTI_RegistrySlot(id, size);
+    while (table[slot].idx != -1) {
+        if (table[slot].id == id) {
+            table[slot].idx = idx;
+            return 0;
+        }
+        slot = (slot + 1) & (size - 1);
+    }
+    table[slot].id = id;
+    table[slot].idx = idx;
+    return 1;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Registers the index of a protected dataset.
+  @param      id              Id of the dataset.
+  @param      idx             Index of the dataset in the dataset array.
+  @return     integer         FTI_SCES if successful.
+
+  The table is doubled when it gets half full, lookups stay O(1) for any
+  number of protected datasets.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_RegisterDataset(int id, int idx)
+{
+    if (2 * (registryCount + 1) > registrySize) {
+        int size = (registrySize == 0) ? FTI_REGISTRY_MIN : 2 * registrySize;
+        FTIT_registryEntry* table = malloc(sizeof(FTIT_registryEntry) * size);
+        if (table == NULL) {
+            FTI_Print("Unable to allocate memory for the dataset registry.", FTI_EROR);
+            return FTI_NSCS;
+        }
+        int i;
+        for (i = 0; i < size; i++) {
+            table[i].idx = -1;
+        }
+        for (i = 0; i < registrySize; i++) {
+            if (registry[i].idx != -1) {
+                FTI_RegistryPut(table, size, registry[i].id, registry[i].idx);
+            }
+        }
+        free(registry);
+        registry = table;
+        registrySize = size;
+    }
+    registryCount += FTI_RegistryPut(registry, registrySize, id, idx);
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the index of a protected dataset.
+  @param      id              Id of the dataset.
+  @return     integer         Index in the dataset array, -1 if not found.
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_GetDatasetIdx(int id)
+{
+    if (registry == NULL) {
+        return -1;
+    }
+    int slot = FTI_RegistrySlot(id, registrySize);
+    while (registry[slot].idx != -1) {
+        if (registry[slot].id == id) {
+            return registry[slot].idx;
+        }
+        slot = (slot + 1) & (registrySize - 1);
+    }
+    return -1;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Frees the dataset registry.
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FreeDatasetRegistry()
+{
+    free(registry);
+    registry = NULL;
+    registrySize = 0;
+    registryCount = 0;
+}
@@ -673,11 +673,22 @@ int FTI_SyncStage( char* lpath, char *rpath, FTIT_execution *FTI_Exec,
         close( fd_local );
         return FTI_NSCS;
     }
+    // move file to destination (in-kernel copy if supported)
+    off_t pos = FTI_KernelCopy( fd_local, fd_global, eof );
+    if( pos == -1 ) {
+        FTI_SetStatusField( FTI_Exec, FTI_Topo, ID, FTI_SI_FAIL, FTI_SIF_VAL, source );
+        snprintf( errstr, FTI_BUFS, "unable to copy '%s' to '%s'.", lpath, rpath );
+        FTI_Print( errstr, FTI_EROR );
+        errno = 0;
+        close( fd_local );
+        close( fd_global );
+        return FTI_NSCS;
+    }
+
     // allocate buffer
     char *buf = (char*) malloc( bs );
 
-    // move file to destination
-    off_t pos = 0;
+    // copy the remainder with buffered I/O
     ssize_t read_bytes, write_bytes;
     size_t buf_bytes;
     while( pos < eof ) {
@@ -920,6 +931,34 @@ int FTI_HandleStageRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exe
         close( fd_local );
         return FTI_NSCS;
     }
+    // move file to destination (in-kernel copy if supported). The copy is
+    // done in chunks of transfer size, pending checkpoint requests are
+    // served in between.
+    off_t pos = 0;
+    while( pos < eof ) {
+        off_t len = ( (eof - pos) < bs ) ? eof - pos : bs;
+        off_t copied = FTI_KernelCopy( fd_local, fd_global, len );
+        if( copied == -1 ) {
+            pos = -1;
+            break;
+        }
+        pos += copied;
+        if( copied < len ) {
+            break; // copy the remainder with buffered I/O
+        }
+        FTI_HeadPreempt( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt );
+    }
+    if( pos == -1 ) {
+        FTI_FreeStageRequest( FTI_Exec, FTI_Topo, ID, source );
+        FTI_SetStatusField( FTI_Exec, FTI_Topo, ID, FTI_SI_FAIL, FTI_SIF_VAL, source );
+        snprintf( errstr, FTI_BUFS, "unable to copy '%s' to '%s'.", lpath, rpath );
+        FTI_Print( errstr, FTI_EROR );
+        errno = 0;
+        close( fd_local );
+        close( fd_global );
+        return FTI_NSCS;
+    }
+
     // allocate buffer
     char *buf = (char*) malloc( bs );
     if ( buf == NULL ) {
@@ -931,8 +970,7 @@ int FTI_HandleStageRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exe
         return FTI_NSCS;
     }
 
-    // move file to destination
-    off_t pos = 0;
+    // copy the remainder with buffered I/O
     ssize_t read_bytes, write_bytes;
     size_t buf_bytes;
     while( pos < eof ) {
@@ -972,6 +1010,7 @@ int FTI_HandleStageRequest(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exe
             return FTI_NSCS;
         }
         pos += write_bytes;
+        FTI_HeadPreempt( FTI_Conf, FTI_Exec, FTI_Topo, FTI_Ckpt );
     }
 
     // deallocate buffer and close file descriptors
@@ -0,0 +1,222 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   stats.c
+ *  @date   October, 2018
+ *  @brief  Checkpoint statistics and traces.
+ */
+
+#include "interface.h"
+
+/** TRUE if the stats are collected.                                       */
+static bool statsEnabled = false;
+/** Accumulated stats of the process.                                      */
+static FTIT_stats stats;
+/** Reference time of the trace events.                                    */
+static double statsT0 = 0;
+/** Trace events (NULL if no trace is written).                            */
+static FTIT_statsEvent* statsEvents = NULL;
+/** Number of recorded trace events.                                       */
+static long statsNbEvents = 0;
+/** Number of allocated trace events.                                      */
+static long statsMaxEvents = 0;
+
+/** Names of the phases in the trace.                                      */
+static const char* statsPhaseNames[FTI_STAT_NB] = {
+    "wait", "write", "checksum", "sync", "meta", "post", "clean", "recover"
+};
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It initializes the stats of the process.
+  @param      FTI_Conf        Configuration metadata.
+
+  Does nothing unless Advanced:stats or Advanced:trace_file is set. The
+  start times of the trace events are relative to this call, which is
+  done after a barrier in FTI_Init.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_InitStats(FTIT_configuration* FTI_Conf)
+{
+    memset(&stats, 0, sizeof(FTIT_stats));
+    stats.ioMode = FTI_Conf->ioMode;
+    statsEnabled = FTI_Conf->statsEnabled;
+    statsT0 = MPI_Wtime();
+    statsNbEvents = 0;
+    if (statsEnabled && FTI_Conf->traceFile[0] != '\0') {
+        statsMaxEvents = FTI_STATS_EVENTS;
+        statsEvents = talloc(FTIT_statsEvent, statsMaxEvents);
+        if (statsEvents == NULL) {
+            FTI_Print("Unable to allocate memory for the trace, no trace is written.", FTI_WARN);
+            statsMaxEvents = 0;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It returns the start time of a phase.
+  @return     double          Current time, 0 if the stats are disabled.
+
+ **/
+/*-------------------------------------------------------------------------*/
+double FTI_StatsStart()
+{
+    return (statsEnabled) ? MPI_Wtime() : 0;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It accounts a phase started with FTI_StatsStart.
+  @param      phase           Phase (FTI_STAT_*).
+  @param      level           Checkpoint level.
+  @param      start           Value returned by FTI_StatsStart.
+  @param      bytes           Data volume of the phase.
+
+  The phase is added to the stats of its level (if 1-4) and of all levels,
+  and recorded for the trace if one is written.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_StatsStop(int phase, int level, double start, unsigned long long bytes)
+{
+    if (!statsEnabled) {
+        return;
+    }
+    double time = MPI_Wtime() - start;
+    int l;
+    for (l = 0; l <= 4; l++) {
+        if (l == 0 || l == level) {
+            stats.phase[l][phase].count++;
+            stats.phase[l][phase].time += time;
+            stats.phase[l][phase].bytes += bytes;
+        }
+    }
+
+    if (statsMaxEvents == 0) {
+        return;
+    }
+    if (statsNbEvents == statsMaxEvents) {
+        FTIT_statsEvent* events = realloc(statsEvents, 2 * statsMaxEvents * sizeof(FTIT_statsEvent));
+        if (events == NULL) {
+            FTI_Print("Unable to extend the trace, further events are dropped.", FTI_WARN);
+            statsMaxEvents = 0;
+            return;
+        }
+        statsEvents = events;
+        statsMaxEvents *= 2;
+    }
+    FTIT_statsEvent* ev = &statsEvents[statsNbEvents++];
+    ev->phase = phase;
+    ev->level = level;
+    ev->start = start - statsT0;
+    ev->time = time;
+    ev->bytes = bytes;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It copies the stats of the process.
+  @param      dest            Destination of the stats.
+  @return     integer         FTI_SCES if successful.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_CopyStats(FTIT_stats* dest)
+{
+    if (!statsEnabled) {
+        FTI_Print("Stats are disabled, set Advanced:stats = 1 to collect them.", FTI_WARN);
+        return FTI_NSCS;
+    }
+    memcpy(dest, &stats, sizeof(FTIT_stats));
+    return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It writes the trace and releases the stats.
+  @param      FTI_Conf        Configuration metadata.
+  @param      FTI_Topo        Topology metadata.
+  @return     integer         FTI_SCES if successful.
+
+  Each process writes its events to <trace_file>-Rank<rank>.json in the
+  Chrome trace event format, with its global rank as pid. The files use
+  the unterminated array form of the format: only rank 0 opens the array
+  and every event ends with a comma, the closing bracket is omitted. Thus,
+  the files of all processes form one trace once they are concatenated
+  starting with the file of rank 0 (e.g. 'cat <trace_file>-Rank*.json').
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_FinalizeStats(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo)
+{
+    int res = FTI_SCES;
+    if (statsEvents != NULL) {
+        char fn[FTI_BUFS], str[FTI_BUFS];
+        snprintf(fn, FTI_BUFS, "%s-Rank%d.json", FTI_Conf->traceFile, FTI_Topo->myRank);
+        FILE* fd = fopen(fn, "w");
+        if (fd == NULL) {
+            snprintf(str, FTI_BUFS, "Unable to create the trace file (%s).", fn);
+            FTI_Print(str, FTI_WARN);
+            res = FTI_NSCS;
+        }
+        else {
+            if (FTI_Topo->myRank == 0) {
+                fprintf(fd, "[\n");
+            }
+            fprintf(fd, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                    "\"args\":{\"name\":\"Rank %d%s\"}},\n",
+                    FTI_Topo->myRank, FTI_Topo->myRank, (FTI_Topo->amIaHead) ? " (head)" : "");
+            long i;
+            for (i = 0; i < statsNbEvents; i++) {
+                FTIT_statsEvent* ev = &statsEvents[i];
+                fprintf(fd, "{\"name\":\"%s\",\"cat\":\"L%d\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,"
+                        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"level\":%d,\"bytes\":%llu}},\n",
+                        statsPhaseNames[ev->phase], ev->level, FTI_Topo->myRank,
+                        ev->start * 1e6, ev->time * 1e6, ev->level, ev->bytes);
+            }
+            if (fclose(fd) != 0) {
+                snprintf(str, FTI_BUFS, "Unable to write the trace file (%s).", fn);
+                FTI_Print(str, FTI_WARN);
+                res = FTI_NSCS;
+            }
+        }
+        free(statsEvents);
+        statsEvents = NULL;
+    }
+    statsMaxEvents = 0;
+    statsNbEvents = 0;
+    statsEnabled = false;
+    return res;
+}
@@ -0,0 +1,62 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   stats.h
+ *  @date   October, 2018
+ *  @brief  Header for the checkpoint statistics and traces.
+ */
+
+#ifndef _FTI_STATS_H
+#define _FTI_STATS_H
+
+/** Initial number of trace events (doubles when full).                    */
+#define FTI_STATS_EVENTS 256
+
+/** @typedef    FTIT_statsEvent
+ *  @brief      Measured phase kept for the trace.
+ */
+typedef struct FTIT_statsEvent {
+    int             phase;              /**< Phase (FTI_STAT_*)             */
+    int             level;              /**< Checkpoint level               */
+    double          start;              /**< Start time (sec. since init)   */
+    double          time;               /**< Duration (sec.)                */
+    unsigned long long bytes;           /**< Data volume                    */
+} FTIT_statsEvent;
+
+void FTI_InitStats(FTIT_configuration* FTI_Conf);
+double FTI_StatsStart();
+void FTI_StatsStop(int phase, int level, double start, unsigned long long bytes);
+int FTI_CopyStats(FTIT_stats* stats);
+int FTI_FinalizeStats(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo);
+
+#endif
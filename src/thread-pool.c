@@ -0,0 +1,258 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   thread-pool.c
+ *  @date   October, 2018
+ *  @brief  Worker thread pool used to parallelize post-processing kernels.
+ */
+
+#include "interface.h"
+
+/** 
+ * @brief process wide pool (created on first use in 'FTI_GetThreadPool'). 
+ **/
+static FTIT_threadPool *threadPool = NULL;
+
+/** 
+ * @brief number of threads of the pool (set in 'FTI_InitThreadPool'). 
+ **/
+static int threadPoolSize = 1;
+
+/** 
+ * @brief argument passed to the worker threads. 
+ **/
+typedef struct FTIT_workerArg {
+    FTIT_threadPool*    pool;
+    int                 tid;
+} FTIT_workerArg;
+
+static FTIT_workerArg *workerArgs = NULL;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Main loop of the worker threads.
+  @param      arg             Pointer to the worker argument.
+  @return     void*           NULL.
+
+  The worker waits for a new job, executes its part and signals the
+  completion to the calling thread.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void* FTI_ThreadPoolWorker(void* arg)
+{
+    FTIT_threadPool* pool = ((FTIT_workerArg*)arg)->pool;
+    int tid = ((FTIT_workerArg*)arg)->tid;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->generation == seen && !pool->shutdown) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        int nbActive = pool->nbActive;
+        if (tid >= nbActive) {
+            continue; //not part of this job
+        }
+        FTIT_poolfunc func = pool->func;
+        void* funcArg = pool->arg;
+        pthread_mutex_unlock(&pool->lock);
+
+        func(funcArg, tid, nbActive);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Creates the thread pool.
+  @param      nbThreads       Number of threads (incl. the calling thread).
+
+ **/
+/*-------------------------------------------------------------------------*/
+static void FTI_CreateThreadPool(int nbThreads)
+{
+    threadPool = talloc(FTIT_threadPool, 1);
+    threadPool->nbThreads = 1;
+    threadPool->threads = NULL;
+    threadPool->func = NULL;
+    threadPool->arg = NULL;
+    threadPool->generation = 0;
+    threadPool->pending = 0;
+    threadPool->shutdown = false;
+    pthread_mutex_init(&threadPool->lock, NULL);
+    pthread_cond_init(&threadPool->start, NULL);
+    pthread_cond_init(&threadPool->done, NULL);
+
+    if (nbThreads > 1) {
+        threadPool->threads = talloc(pthread_t, nbThreads - 1);
+        workerArgs = talloc(FTIT_workerArg, nbThreads - 1);
+        int i;
+        for (i = 0; i < nbThreads - 1; i++) {
+            workerArgs[i].pool = threadPool;
+            workerArgs[i].tid = i + 1;
+            if (pthread_create(&threadPool->threads[i], NULL, FTI_ThreadPoolWorker, &workerArgs[i]) != 0) {
+                char str[FTI_BUFS];
+                snprintf(str, FTI_BUFS, "Could only create %d of %d threads for the thread pool.", i, nbThreads - 1);
+                FTI_Print(str, FTI_WARN);
+                break;
+            }
+        }
+        threadPool->nbThreads = i + 1;
+    }
+    threadPool->nbActive = threadPool->nbThreads;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Sets the number of threads of the pool.
+  @param      nbThreads       Number of threads (incl. the calling thread).
+
+  The pool is shared by the L3 encoding and decoding and the dCP hashing,
+  hence, it is sized once for the largest of their thread counts. Each
+  user then only employs as many threads as it was configured with.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_InitThreadPool(int nbThreads)
+{
+    FTI_FreeThreadPool();
+    threadPoolSize = (nbThreads < 1) ? 1 : nbThreads;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Returns the thread pool limited to a number of threads.
+  @param      nbThreads       Number of threads (incl. the calling thread).
+  @return     FTIT_threadPool Pointer to the pool.
+
+  The pool is created on the first call with the size set in
+  'FTI_InitThreadPool' and kept alive until 'FTI_FreeThreadPool' is
+  called. The jobs run with 'FTI_RunThreadPool' until the next call
+  only employ the first nbThreads threads of the pool, the others stay
+  idle. If the worker threads cannot be created, the returned pool
+  executes the jobs in the calling thread.
+
+ **/
+/*-------------------------------------------------------------------------*/
+FTIT_threadPool* FTI_GetThreadPool(int nbThreads)
+{
+    if (threadPool == NULL) {
+        FTI_CreateThreadPool(threadPoolSize);
+    }
+    if (nbThreads < 1) {
+        nbThreads = 1;
+    }
+    threadPool->nbActive = (nbThreads < threadPool->nbThreads) ? nbThreads : threadPool->nbThreads;
+    return threadPool;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Executes a function on all threads of the pool.
+  @param      pool            The thread pool.
+  @param      func            Function to execute.
+  @param      arg             Argument passed to the function.
+
+  The calling thread executes its part as thread 0 and returns when all
+  threads have completed the job. Only the threads employed since the
+  last 'FTI_GetThreadPool' call take part in the job.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_RunThreadPool(FTIT_threadPool* pool, FTIT_poolfunc func, void* arg)
+{
+    if (pool->nbActive == 1) {
+        func(arg, 0, 1);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->arg = arg;
+    pool->pending = pool->nbActive - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    func(arg, 0, pool->nbActive);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Terminates the worker threads and frees the pool.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FreeThreadPool()
+{
+    if (threadPool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&threadPool->lock);
+    threadPool->shutdown = true;
+    pthread_cond_broadcast(&threadPool->start);
+    pthread_mutex_unlock(&threadPool->lock);
+
+    int i;
+    for (i = 0; i < threadPool->nbThreads - 1; i++) {
+        pthread_join(threadPool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&threadPool->lock);
+    pthread_cond_destroy(&threadPool->start);
+    pthread_cond_destroy(&threadPool->done);
+    free(threadPool->threads);
+    free(workerArgs);
+    free(threadPool);
+    workerArgs = NULL;
+    threadPool = NULL;
+}
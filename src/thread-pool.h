@@ -0,0 +1,79 @@
+/**
+ *  Copyright (c) 2017 Leonardo A. Bautista-Gomez
+ *  All rights reserved
+ *
+ *  FTI - A multi-level checkpointing library for C/C++/Fortran applications
+ *
+ *  Revision 1.0 : Fault Tolerance Interface (FTI)
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice, this
+ *  list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *
+ *  3. Neither the name of the copyright holder nor the names of its contributors
+ *  may be used to endorse or promote products derived from this software without
+ *  specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ *  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ *  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ *  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ *  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  @file   thread-pool.h
+ *  @date   October, 2018
+ *  @brief  Header for the worker thread pool of the FTI library.
+ */
+
+#ifndef _FTI_THREAD_POOL_H
+#define _FTI_THREAD_POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/** @typedef    FTIT_poolfunc
+ *  @brief      Function executed by every thread of the pool.
+ *
+ *  The function is called with the argument passed to 'FTI_RunThreadPool',
+ *  the id of the calling thread (0 is the calling process) and the total
+ *  number of threads taking part in the execution.
+ */
+typedef void (*FTIT_poolfunc)(void *arg, int tid, int nbThreads);
+
+/** @typedef    FTIT_threadPool
+ *  @brief      Pool of persistent worker threads.
+ *
+ *  The calling thread always takes part in the execution as thread 0,
+ *  hence, a pool of size 1 does not create any thread.
+ */
+typedef struct FTIT_threadPool {
+    int             nbThreads;          /**< Threads incl. calling thread   */
+    int             nbActive;           /**< Threads taking part in jobs    */
+    pthread_t*      threads;            /**< Worker threads                 */
+    pthread_mutex_t lock;               /**< Protects the fields below      */
+    pthread_cond_t  start;              /**< Signals a new job              */
+    pthread_cond_t  done;               /**< Signals job completion         */
+    FTIT_poolfunc   func;               /**< Function of the current job    */
+    void*           arg;                /**< Argument of the current job    */
+    unsigned long   generation;         /**< Job counter                    */
+    int             pending;            /**< Workers still busy with job    */
+    bool            shutdown;           /**< TRUE if workers shall exit     */
+} FTIT_threadPool;
+
+void FTI_InitThreadPool(int nbThreads);
+FTIT_threadPool* FTI_GetThreadPool(int nbThreads);
+void FTI_RunThreadPool(FTIT_threadPool* pool, FTIT_poolfunc func, void* arg);
+void FTI_FreeThreadPool();
+
+#endif
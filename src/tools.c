@@ -72,10 +72,10 @@ int FTI_InitExecVars(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
     + sizeof(long);             /* dbsize */
 
   FTI_dbvarstructsize
-    = 3*sizeof(int)               /* numvars */
+    = 4*sizeof(int)               /* numvars */
     + 2*sizeof(bool)
-    + 2*sizeof(uintptr_t)
-    + 2*sizeof(long)
+    + 3*sizeof(uintptr_t)
+    + 3*sizeof(long)
     + MD5_DIGEST_LENGTH;
 
   // +--------- +
@@ -89,6 +89,9 @@ int FTI_InitExecVars(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   /* int           */ FTI_Exec->ckptIntv              =0;
   /* int           */ FTI_Exec->lastCkptLvel          =0;
   /* int           */ FTI_Exec->wasLastOffline        =0;
+  /* int           */ FTI_Exec->asyncSent             =0;
+  /* int           */ FTI_Exec->asyncDone             =0;
+  /* bool          */ FTI_Exec->postAsync             =0;
   /* double        */ FTI_Exec->iterTime              =0;
   /* double        */ FTI_Exec->lastIterTime          =0;
   /* double        */ FTI_Exec->meanIterTime          =0;
@@ -105,11 +108,13 @@ int FTI_InitExecVars(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   /* unsigned int  */ FTI_Exec->ckptLast              =0;
   /* long          */ FTI_Exec->ckptSize              =0;
   /* unsigned int  */ FTI_Exec->nbVar                 =0;
+  /* unsigned int  */ FTI_Exec->nbVarMax              =FTI_BUFS;
   /* unsigned int  */ FTI_Exec->nbVarStored           =0;
   /* unsigned int  */ FTI_Exec->nbType                =0;
   /* int           */ FTI_Exec->metaAlloc             =0;
   /* int           */ FTI_Exec->initSCES              =0;
   /* char[BUFS]       FTI_Exec->h5SingleFileLast */   memset(FTI_Exec->h5SingleFileLast,0x0,FTI_BUFS);
+  /* char[MD5_DIGEST_STRING_LENGTH] FTI_Exec->integrity */ memset(FTI_Exec->integrity,0x0,MD5_DIGEST_STRING_LENGTH);
   /* FTIT_iCPInfo     FTI_Exec->iCPInfo */            memset(&(FTI_Exec->iCPInfo),0x0,sizeof(FTIT_iCPInfo));
   /* FTIT_metadata[5] FTI_Exec->meta */               memset(FTI_Exec->meta,0x0,5*sizeof(FTIT_metadata));
   /* FTIFF_db      */ FTI_Exec->firstdb               =NULL;
@@ -143,7 +148,19 @@ int FTI_InitExecVars(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
   /* int           */ FTI_Conf->generalTag            =0;
   /* int           */ FTI_Conf->test                  =0;
   /* int           */ FTI_Conf->l3WordSize            =0;
+  /* int           */ FTI_Conf->rsThreads             =0;
+  /* int           */ FTI_Conf->flushBuffers          =0;
+  /* bool          */ FTI_Conf->metaIni               =0;
+  /* long          */ FTI_Conf->headPollMax           =0;
+  /* int           */ FTI_Conf->asyncDepth            =0;
+  /* bool          */ FTI_Conf->directIO              =0;
+  /* bool          */ FTI_Conf->l2Delta               =0;
+  /* bool          */ FTI_Conf->statsEnabled          =0;
+  /* char[BUFS]       FTI_Conf->traceFile */          memset(FTI_Conf->traceFile,0x0,FTI_BUFS);
+  /* int           */ FTI_Conf->dcpThreads            =0;
+  /* MPI_Info      */ FTI_Conf->mpiioInfo             =MPI_INFO_NULL;
   /* int           */ FTI_Conf->ioMode                =0;
+  /* int           */ FTI_Conf->compMode              =0;
   /* char[BUFS]       FTI_Conf->localDir */           memset(FTI_Conf->localDir,0x0,FTI_BUFS);
   /* char[BUFS]       FTI_Conf->glbalDir */           memset(FTI_Conf->glbalDir,0x0,FTI_BUFS);
   /* char[BUFS]       FTI_Conf->metadDir */           memset(FTI_Conf->metadDir,0x0,FTI_BUFS);
@@ -264,6 +281,22 @@ int FTI_Checksum(FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data,
   return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      Adds a chunk read by the pipeline to the MD5 context.
+  @param      src             Chunk of the checkpoint file.
+  @param      size            Size of the chunk.
+  @param      opaque          MD5 context.
+  @return     integer         FTI_SCES.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_ChecksumChunk(void* src, size_t size, void* opaque)
+{
+  MD5_Update ((MD5_CTX*)opaque, src, size);
+  return FTI_SCES;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It compares checksum of the checkpoint file.
@@ -273,7 +306,9 @@ int FTI_Checksum(FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data,
 
   This function calculates checksum of the checkpoint file based on
   MD5 algorithm. It compares calculated hash value with the one saved
-  in the file.
+  in the file. The file is read by a second thread while the chunks
+  already read are hashed, hence, the check takes about the time of
+  the read alone. The file stays in the page cache for the restore.
 
  **/
 /*-------------------------------------------------------------------------*/
@@ -287,13 +322,27 @@ int FTI_VerifyChecksum(char* fileName, char* checksumToCmp)
     return FTI_NSCS;
   }
 
+  struct stat fileStatus;
+  if (fstat(fileno(fd), &fileStatus) != 0) {
+    char str[FTI_BUFS];
+    sprintf(str, "FTI failed to stat file %s to calculate checksum.", fileName);
+    FTI_Print(str, FTI_WARN);
+    fclose (fd);
+    return FTI_NSCS;
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fileno(fd), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
   MD5_CTX mdContext;
   MD5_Init (&mdContext);
 
-  int bytes;
-  unsigned char data[CHUNK_SIZE];
-  while ((bytes = fread (data, 1, CHUNK_SIZE, fd)) != 0) {
-    MD5_Update (&mdContext, data, bytes);
+  if (FTI_PipelinedCopy(fd, fileStatus.st_size, VERIFY_CHUNK_SIZE, 2, FTI_ChecksumChunk, &mdContext) != FTI_SCES) {
+    char str[FTI_BUFS];
+    sprintf(str, "FTI failed to read file %s to calculate checksum.", fileName);
+    FTI_Print(str, FTI_WARN);
+    fclose (fd);
+    return FTI_NSCS;
   }
   unsigned char hash[MD5_DIGEST_LENGTH];
   MD5_Final (hash, &mdContext);
@@ -372,8 +421,8 @@ void FTI_MallocMeta(FTIT_execution* FTI_Exec, FTIT_topology* FTI_Topo)
       FTI_Exec->meta[i].ckptFile = calloc(FTI_BUFS * FTI_Topo->nodeSize, sizeof(char));
       FTI_Exec->meta[i].currentL4CkptFile = calloc(FTI_BUFS * FTI_Topo->nodeSize, sizeof(char));
       FTI_Exec->meta[i].nbVar = calloc(FTI_Topo->nodeSize, sizeof(int));
-      FTI_Exec->meta[i].varID = calloc(FTI_BUFS * FTI_Topo->nodeSize, sizeof(int));
-      FTI_Exec->meta[i].varSize = calloc(FTI_BUFS * FTI_Topo->nodeSize, sizeof(long));
+      FTI_Exec->meta[i].varID = calloc(FTI_Exec->nbVarMax * FTI_Topo->nodeSize, sizeof(int));
+      FTI_Exec->meta[i].varSize = calloc(FTI_Exec->nbVarMax * FTI_Topo->nodeSize, sizeof(long));
     }
   } else {
     for (i = 0; i < 5; i++) {
@@ -384,13 +433,98 @@ void FTI_MallocMeta(FTIT_execution* FTI_Exec, FTIT_topology* FTI_Topo)
       FTI_Exec->meta[i].ckptFile = calloc(FTI_BUFS, sizeof(char));
       FTI_Exec->meta[i].currentL4CkptFile = calloc(FTI_BUFS, sizeof(char));
       FTI_Exec->meta[i].nbVar = calloc(1, sizeof(int));
-      FTI_Exec->meta[i].varID = calloc(FTI_BUFS, sizeof(int));
-      FTI_Exec->meta[i].varSize = calloc(FTI_BUFS, sizeof(long));
+      FTI_Exec->meta[i].varID = calloc(FTI_Exec->nbVarMax, sizeof(int));
+      FTI_Exec->meta[i].varSize = calloc(FTI_Exec->nbVarMax, sizeof(long));
     }
   }
   FTI_Exec->metaAlloc = 1;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It resizes the variable arrays of the metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      nbProc          Number of processes in the metadata.
+  @param      nbVar           Number of variables to store per process.
+  @return     integer         FTI_SCES if successful.
+
+  The arrays 'varID' and 'varSize' hold 'nbVarMax' slots per process. If
+  more variables need to be stored, the number of slots is doubled until
+  it is sufficient and the entries of every process are moved to their
+  new location. 'nbProc' is the node size for the heads, 1 otherwise.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_ReallocMetaVars(FTIT_execution* FTI_Exec, int nbProc, int nbVar)
+{
+  if (nbVar <= FTI_Exec->nbVarMax) {
+    return FTI_SCES;
+  }
+  int oldMax = FTI_Exec->nbVarMax;
+  int newMax = oldMax;
+  while (newMax < nbVar) {
+    newMax *= 2;
+  }
+  if (FTI_Exec->metaAlloc == 1) {
+    int i, j;
+    for (i = 0; i < 5; i++) {
+      int* varID = calloc(newMax * nbProc, sizeof(int));
+      long* varSize = calloc(newMax * nbProc, sizeof(long));
+      if (varID == NULL || varSize == NULL) {
+        FTI_Print("Unable to allocate memory for the variables metadata.", FTI_EROR);
+        free(varID);
+        free(varSize);
+        return FTI_NSCS;
+      }
+      for (j = 0; j < nbProc; j++) {
+        memcpy(&varID[j * newMax], &FTI_Exec->meta[i].varID[j * oldMax], sizeof(int) * oldMax);
+        memcpy(&varSize[j * newMax], &FTI_Exec->meta[i].varSize[j * oldMax], sizeof(long) * oldMax);
+      }
+      free(FTI_Exec->meta[i].varID);
+      free(FTI_Exec->meta[i].varSize);
+      FTI_Exec->meta[i].varID = varID;
+      FTI_Exec->meta[i].varSize = varSize;
+    }
+  }
+  FTI_Exec->nbVarMax = newMax;
+  return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief      It returns the position of a variable in the metadata.
+  @param      FTI_Exec        Execution metadata.
+  @param      level           Level of the metadata.
+  @param      id              Variable ID.
+  @return     integer         Index in 'varID' and 'varSize', -1 if not found.
+
+  The metadata usually stores the variables in the order of protection,
+  hence, the index of the dataset is checked first. The metadata is only
+  searched if the variable is stored at a different position.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_GetMetaVarIdx(FTIT_execution* FTI_Exec, int level, int id)
+{
+  int nbVar = FTI_Exec->meta[level].nbVar[0];
+  if (nbVar < (int)FTI_Exec->nbVar) {
+    nbVar = FTI_Exec->nbVar;
+  }
+  if (nbVar > (int)FTI_Exec->nbVarMax) {
+    nbVar = FTI_Exec->nbVarMax;
+  }
+  int i = FTI_GetDatasetIdx(id);
+  if (i >= 0 && i < nbVar && FTI_Exec->meta[level].varID[i] == id) {
+    return i;
+  }
+  for (i = 0; i < nbVar; i++) {
+    if (FTI_Exec->meta[level].varID[i] == id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief      It frees memory for the metadata.
@@ -1351,11 +1485,13 @@ int FTI_Clean(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 {
   int nodeFlag; //only one process in the node has set it to 1
   int globalFlag = !FTI_Topo->splitRank; //only one process in the FTI_COMM_WORLD has set it to 1
-  globalFlag = (!FTI_Ckpt[4].isDcp && (globalFlag != 0));
+  // the previous checkpoints are kept for FTI-FF dCP, the dCP files of the other I/O modes replace them
+  bool dcpFTIFF = FTI_Ckpt[4].isDcp && (FTI_Conf->ioMode == FTI_IO_FTIFF);
+  globalFlag = (!dcpFTIFF && (globalFlag != 0));
 
 
   nodeFlag = (((!FTI_Topo->amIaHead) && ((FTI_Topo->nodeRank - FTI_Topo->nbHeads) == 0)) || (FTI_Topo->amIaHead)) ? 1 : 0;
-  nodeFlag = (!FTI_Ckpt[4].isDcp && (nodeFlag != 0));
+  nodeFlag = (!dcpFTIFF && (nodeFlag != 0));
 
   if (level == 0) {
     FTI_RmDir(FTI_Conf->mTmpDir, globalFlag);
@@ -1393,7 +1529,15 @@ int FTI_Clean(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 
   // If it is the very last cleaning and we DO NOT keep the last checkpoint
   if (level == 5) {
-    rmdir(FTI_Conf->lTmpDir);
+    // every checkpoint generation has its own temporary directories
+    int gen;
+    for (gen = 0; gen < FTI_Conf->asyncDepth; gen++) {
+      FTI_SetTmpDirs(FTI_Conf, gen);
+      rmdir(FTI_Conf->mTmpDir);
+      rmdir(FTI_Conf->gTmpDir);
+      rmdir(FTI_Conf->lTmpDir);
+    }
+    FTI_SetTmpDirs(FTI_Conf, 0);
     rmdir(FTI_Conf->localDir);
     rmdir(FTI_Conf->glbalDir);
     char buf[FTI_BUFS];
@@ -1414,7 +1558,12 @@ int FTI_Clean(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 
   // If it is the very last cleaning and we DO keep the last checkpoint
   if (level == 6) {
-    rmdir(FTI_Conf->lTmpDir);
+    int gen;
+    for (gen = 0; gen < FTI_Conf->asyncDepth; gen++) {
+      FTI_SetTmpDirs(FTI_Conf, gen);
+      rmdir(FTI_Conf->lTmpDir);
+    }
+    FTI_SetTmpDirs(FTI_Conf, 0);
     rmdir(FTI_Conf->localDir);
   }
 
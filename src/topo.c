@@ -232,70 +232,86 @@ int FTI_ReorderNodes(FTIT_configuration* FTI_Conf, FTIT_topology* FTI_Topo,
 
   This function makes all the processes to detect in which node are they
   located and distributes the information globally to create an uniform
-  mapping structure between processes and nodes.
+  mapping structure between processes and nodes. The processes of a node
+  are found with MPI_Comm_split_type and the nodes are numbered by their
+  lowest rank, so only the node ID of each process and one host name per
+  node are exchanged.
 
  **/
 /*-------------------------------------------------------------------------*/
 int FTI_BuildNodeList(FTIT_configuration* FTI_Conf, FTIT_execution* FTI_Exec,
         FTIT_topology* FTI_Topo, int* nodeList, char* nameList)
 {
-    char* lhn = talloc(char, FTI_BUFS* FTI_Topo->nbProc);
-    memset(lhn + (FTI_Topo->myRank * FTI_BUFS), 0, FTI_BUFS); // To get local hostname
+    // Group the processes sharing a node, ordered by global rank
+    MPI_Comm shmComm;
     if (!FTI_Conf->test) {
-        gethostname(lhn + (FTI_Topo->myRank * FTI_BUFS), FTI_BUFS); // NOT local test
+        MPI_Comm_split_type(FTI_Exec->globalComm, MPI_COMM_TYPE_SHARED, FTI_Topo->myRank, MPI_INFO_NULL, &shmComm); // NOT local test
     }
     else {
-        snprintf(lhn + (FTI_Topo->myRank * FTI_BUFS), FTI_BUFS, "node%d", FTI_Topo->myRank / FTI_Topo->nodeSize); // Local
+        MPI_Comm_split(FTI_Exec->globalComm, FTI_Topo->myRank / FTI_Topo->nodeSize, FTI_Topo->myRank, &shmComm); // Local
+    }
+    int shmRank;
+    MPI_Comm_rank(shmComm, &shmRank);
+
+    // The lowest rank of each node numbers the nodes in order of their first process
+    MPI_Comm leaderComm;
+    MPI_Comm_split(FTI_Exec->globalComm, (shmRank == 0) ? 0 : MPI_UNDEFINED, FTI_Topo->myRank, &leaderComm);
+    int nodeID = 0;
+    if (shmRank == 0) {
+        MPI_Comm_rank(leaderComm, &nodeID);
     }
-    char hname[FTI_BUFS];
-    strncpy(hname, lhn + (FTI_Topo->myRank * FTI_BUFS), FTI_BUFS - 1); // Distributing host names
-    MPI_Allgather(hname, FTI_BUFS, MPI_CHAR, lhn, FTI_BUFS, MPI_CHAR, FTI_Exec->globalComm);
+    MPI_Bcast(&nodeID, 1, MPI_INT, 0, shmComm);
 
-    int nbNodes = 0;
-    int i;
-    for (i = 0; i < FTI_Topo->nbProc; i++) { // Creating the node list: For each process
-        int found = 0;
-        int pos = 0;
-        strncpy(hname, lhn + (i * FTI_BUFS), FTI_BUFS - 1); // Get node name of process i
-        while ((pos < nbNodes) && (found == 0)) { // Search the node name in the current list of node names
-            if (strncmp(&(nameList[pos * FTI_BUFS]), hname, FTI_BUFS) == 0) { // If we find it break out
-                found = 1;
-            }
-            else { // Else move to the next name in the list
-                pos++;
-            }
-        }
-        if (found) { // If we found the node name in the current list...
-            int p = pos * FTI_Topo->nodeSize;
-            while (p < pos * FTI_Topo->nodeSize + FTI_Topo->nodeSize) { // ... we look for empty spot in this node
-                if (nodeList[p] == -1) {
-                    nodeList[p] = i;
-                    break;
-                }
-                else {
-                    p++;
-                }
-            }
+    int* nodeOf = talloc(int, FTI_Topo->nbProc);
+    MPI_Allgather(&nodeID, 1, MPI_INT, nodeOf, 1, MPI_INT, FTI_Exec->globalComm);
+
+    // Creating the node list: every process takes the next spot of its node
+    int* fill = talloc(int, FTI_Topo->nbNodes);
+    memset(fill, 0, FTI_Topo->nbNodes * sizeof(int));
+    int i, res = FTI_SCES;
+    for (i = 0; i < FTI_Topo->nbProc && res == FTI_SCES; i++) {
+        if (nodeOf[i] >= FTI_Topo->nbNodes || fill[nodeOf[i]] == FTI_Topo->nodeSize) {
+            char str[FTI_BUFS];
+            snprintf(str, FTI_BUFS, "Node %d has more than %d processes", nodeOf[i], FTI_Topo->nodeSize);
+            FTI_Print(str, FTI_WARN);
+            res = FTI_NSCS;
         }
-        else { // ... else, we add the new node to the end of the current list of nodes
-            strncpy(&(nameList[pos * FTI_BUFS]), hname, FTI_BUFS - 1);
-            nodeList[pos * FTI_Topo->nodeSize] = i;
-            nbNodes++;
+        else {
+            nodeList[nodeOf[i] * FTI_Topo->nodeSize + fill[nodeOf[i]]] = i;
+            fill[nodeOf[i]]++;
         }
     }
-    for (i = 0; i < FTI_Topo->nbProc; i++) { // Checking that all nodes have nodeSize processes
+    for (i = 0; i < FTI_Topo->nbProc && res == FTI_SCES; i++) { // Checking that all nodes have nodeSize processes
         if (nodeList[i] == -1) {
             char str[FTI_BUFS];
             snprintf(str, FTI_BUFS, "Node %d has no %d processes", i / FTI_Topo->nodeSize, FTI_Topo->nodeSize);
             FTI_Print(str, FTI_WARN);
-            free(lhn);
-            return FTI_NSCS;
+            res = FTI_NSCS;
+        }
+    }
+    if (res == FTI_SCES) { // Distributing host names, one per node
+        char hname[FTI_BUFS];
+        memset(hname, 0, FTI_BUFS);
+        if (shmRank == 0) {
+            if (!FTI_Conf->test) {
+                gethostname(hname, FTI_BUFS - 1); // NOT local test
+            }
+            else {
+                snprintf(hname, FTI_BUFS, "node%d", FTI_Topo->myRank / FTI_Topo->nodeSize); // Local
+            }
+            MPI_Allgather(hname, FTI_BUFS, MPI_CHAR, nameList, FTI_BUFS, MPI_CHAR, leaderComm);
         }
+        MPI_Bcast(nameList, FTI_Topo->nbNodes * FTI_BUFS, MPI_CHAR, 0, shmComm);
     }
 
-    free(lhn);
+    if (leaderComm != MPI_COMM_NULL) {
+        MPI_Comm_free(&leaderComm);
+    }
+    MPI_Comm_free(&shmComm);
+    free(fill);
+    free(nodeOf);
 
-    return FTI_SCES;
+    return res;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <string.h>
 
 #include "interface.h"
@@ -5,37 +6,93 @@
 #include "api_cuda.h"
 #include "utility.h"
 
+/** 
+ * @brief contiguous byte type of the transfer size and its length. 
+ **/
+static MPI_Datatype chunkType = MPI_DATATYPE_NULL;
+static size_t chunkTypeSize = 0;
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Returns a committed contiguous byte type of a chunk length.
+  @param     size   The chunk length in bytes 
+  @return    MPI_Datatype The committed datatype.
+
+  Only one type is cached. It is meant for the transfer size, which does
+  not change during the execution, hence, the type is committed once and
+  not for every chunk written. The shorter tails of the variables are
+  written as 'count = tail' elements of MPI_BYTE instead. If a different
+  length is requested, the cached type is replaced.
+
+ **/
+/*-------------------------------------------------------------------------*/
+MPI_Datatype FTI_GetChunkType(size_t size)
+{
+  if (chunkType != MPI_DATATYPE_NULL && chunkTypeSize == size) {
+    return chunkType;
+  }
+  FTI_FreeChunkTypes();
+
+  MPI_Type_contiguous(size, MPI_BYTE, &chunkType);
+  MPI_Type_commit(&chunkType);
+  chunkTypeSize = size;
+
+  return chunkType;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Frees the datatype cached by 'FTI_GetChunkType'.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FreeChunkTypes()
+{
+  if (chunkType != MPI_DATATYPE_NULL) {
+    MPI_Type_free(&chunkType);
+  }
+  chunkTypeSize = 0;
+}
+
 
 /*-------------------------------------------------------------------------*/
 /**
   @brief     Writes data to a file using the posix library
   @param     src    The location of the data to be written 
   @param     size   The number of bytes that I need to write 
-  @param     opaque A pointer to the File descriptor  
+  @param     opaque A pointer to the struct that describes the posix file 
   @return    integer         FTI_SCES if successful.
 
-  Writes the data to a file using the posix library. 
+  Writes the data to a file using the posix library. If an MD5 context
+  is attached, the data is hashed in chunks of CHUNK_SIZE bytes right
+  after they are written, while they are still in the cache.
 
  **/
 /*-------------------------------------------------------------------------*/
 int write_posix(void *src, size_t size, void *opaque)
 {
-  FILE *fd = (FILE *)opaque;
+  WritePosixInfo_t *write_info = (WritePosixInfo_t *)opaque;
+  FILE *fd = write_info->f;
   size_t written = 0;
-  int fwrite_errno;
+  int fwrite_errno = 0;
   char str[FTI_BUFS];
 
   while (written < size && !ferror(fd)) {
+    size_t bSize = size - written;
+    if (write_info->integrity != NULL && bSize > CHUNK_SIZE) {
+      bSize = CHUNK_SIZE;
+    }
     errno = 0;
-    written += fwrite(((char *)src) + written, 1, size - written, fd);
+    size_t bytes = fwrite(((char *)src) + written, 1, bSize, fd);
     fwrite_errno = errno;
+    if (write_info->integrity != NULL) {
+      MD5_Update(write_info->integrity, ((char *)src) + written, bytes);
+    }
+    written += bytes;
   }
 
   if (ferror(fd)){
-    char error_msg[FTI_BUFS];
-    error_msg[0] = 0;
-    strerror_r(fwrite_errno, error_msg, FTI_BUFS);
-    snprintf(str, FTI_BUFS, "utility:c: (write_posix) Dataset could not be written: %s.", error_msg);
+    snprintf(str, FTI_BUFS, "utility:c: (write_posix) Dataset could not be written: %s.", strerror(fwrite_errno));
     FTI_Print(str, FTI_EROR);
     fclose(fd);
     return FTI_NSCS;
@@ -44,6 +101,145 @@ int write_posix(void *src, size_t size, void *opaque)
     return FTI_SCES;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Writes the staging buffer of a direct I/O file
+  @param     write_info  The direct I/O file
+  @param     size        Number of bytes to write (multiple of FTI_DIO_ALIGN)
+  @return    integer     FTI_SCES if successful.
+
+ **/
+/*-------------------------------------------------------------------------*/
+static int FTI_WriteDirectBuffer(WriteDirectInfo_t *write_info, size_t size)
+{
+  size_t written = 0;
+  while (written < size) {
+    ssize_t bytes = pwrite(write_info->fd, write_info->buf + written, size - written, write_info->offset + written);
+    if (bytes == -1 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      char str[FTI_BUFS];
+      snprintf(str, FTI_BUFS, "utility:c: (write_direct) Dataset could not be written to %s: %s.", write_info->fn, strerror(errno));
+      FTI_Print(str, FTI_EROR);
+      return FTI_NSCS;
+    }
+    written += bytes;
+  }
+  write_info->offset += size;
+  return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Opens a file for direct I/O (O_DIRECT)
+  @param     write_info  The direct I/O file to initialize
+  @param     fn          Name of the file
+  @param     integrity   MD5 context the data is hashed in (or NULL)
+  @return    integer     FTI_SCES if successful.
+
+  The data written with 'write_direct' is collected in an aligned staging
+  buffer, which is written to the file, bypassing the page cache, once it
+  is full. Returns FTI_NSCS without an error message if the file system
+  does not support O_DIRECT, the caller then falls back to buffered I/O.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_OpenDirect(WriteDirectInfo_t *write_info, char *fn, MD5_CTX *integrity)
+{
+#ifdef O_DIRECT
+  write_info->fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, (mode_t) 0600);
+  if (write_info->fd == -1) {
+    return FTI_NSCS;
+  }
+  if (posix_memalign((void **)&write_info->buf, FTI_DIO_ALIGN, FTI_DIO_BUFSIZE) != 0) {
+    close(write_info->fd);
+    return FTI_NSCS;
+  }
+  write_info->fn = fn;
+  write_info->fill = 0;
+  write_info->offset = 0;
+  write_info->integrity = integrity;
+  return FTI_SCES;
+#else
+  return FTI_NSCS;
+#endif
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Writes data to a file opened for direct I/O
+  @param     src    The location of the data to be written 
+  @param     size   The number of bytes that I need to write 
+  @param     opaque A pointer to the WriteDirectInfo_t of the file
+  @return    integer         FTI_SCES if successful.
+
+  The data is copied to the staging buffer, hashed there if an MD5 context
+  is attached, and the buffer is written whenever it is full.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int write_direct(void *src, size_t size, void *opaque)
+{
+  WriteDirectInfo_t *write_info = (WriteDirectInfo_t *)opaque;
+  size_t copied = 0;
+
+  while (copied < size) {
+    size_t bSize = FTI_DIO_BUFSIZE - write_info->fill;
+    if (bSize > size - copied) {
+      bSize = size - copied;
+    }
+    memcpy(write_info->buf + write_info->fill, ((char *)src) + copied, bSize);
+    if (write_info->integrity != NULL) {
+      MD5_Update(write_info->integrity, write_info->buf + write_info->fill, bSize);
+    }
+    write_info->fill += bSize;
+    copied += bSize;
+
+    if (write_info->fill == FTI_DIO_BUFSIZE) {
+      if (FTI_WriteDirectBuffer(write_info, FTI_DIO_BUFSIZE) != FTI_SCES) {
+        return FTI_NSCS;
+      }
+      write_info->fill = 0;
+    }
+  }
+  return FTI_SCES;
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Writes the remaining data and closes a direct I/O file
+  @param     write_info  The direct I/O file
+  @return    integer     FTI_SCES if successful.
+
+  The tail of the file is padded to FTI_DIO_ALIGN bytes for the last
+  write and truncated to the size of the data afterwards. The staging
+  buffer is freed and the file is closed, also if the write failed.
+
+ **/
+/*-------------------------------------------------------------------------*/
+int FTI_CloseDirect(WriteDirectInfo_t *write_info)
+{
+  int res = FTI_SCES;
+  if (write_info->fill > 0) {
+    off_t fs = write_info->offset + write_info->fill;
+    size_t padded = (write_info->fill + FTI_DIO_ALIGN - 1) & ~((size_t)FTI_DIO_ALIGN - 1);
+    memset(write_info->buf + write_info->fill, 0, padded - write_info->fill);
+    res = FTI_WriteDirectBuffer(write_info, padded);
+    if (res == FTI_SCES && ftruncate(write_info->fd, fs) != 0) {
+      FTI_Print("utility:c: (write_direct) Checkpoint file could not be truncated.", FTI_EROR);
+      res = FTI_NSCS;
+    }
+  }
+  free(write_info->buf);
+  write_info->buf = NULL;
+  if (close(write_info->fd) != 0) {
+    FTI_Print("FTI checkpoint file could not be closed.", FTI_EROR);
+    res = FTI_NSCS;
+  }
+  return res;
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief     Writes data to a file using the MPI-IO library
@@ -52,7 +248,8 @@ int write_posix(void *src, size_t size, void *opaque)
   @param     opaque A pointer to the struct that describes the MPI-IO file 
   @return    integer FTI_SCES if successful.
 
-  Writes the data to a file using the MPI library. 
+  Writes the data to a file using the MPI library. If an MD5 context
+  is attached, each transfer chunk is hashed right after it is written.
 
  **/
 /*-------------------------------------------------------------------------*/
@@ -67,17 +264,20 @@ int write_mpi(void *src, size_t size, void *opaque)
       bSize = size - pos;
     }
 
-    MPI_Datatype dType;
-    MPI_Type_contiguous(bSize, MPI_BYTE, &dType);
-    MPI_Type_commit(&dType);
-
-    write_info->err = MPI_File_write_at(write_info->pfh, write_info->offset, src, 1, dType, MPI_STATUS_IGNORE);
+    // the tail is written as bytes, only full chunks use the cached type
+    if (bSize == write_info->FTI_Conf->transferSize) {
+      write_info->err = MPI_File_write_at(write_info->pfh, write_info->offset, src, 1, FTI_GetChunkType(bSize), MPI_STATUS_IGNORE);
+    } else {
+      write_info->err = MPI_File_write_at(write_info->pfh, write_info->offset, src, bSize, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
     // check if successful
     if (write_info->err != 0) {
       errno = 0;
       return FTI_NSCS;
     }
-    MPI_Type_free(&dType);
+    if (write_info->integrity != NULL) {
+      MD5_Update(write_info->integrity, src, bSize);
+    }
     src += bSize;
     write_info->offset += bSize;
     pos = pos + bSize;
@@ -93,24 +293,51 @@ int write_mpi(void *src, size_t size, void *opaque)
   @brief     Writes data to a file using the SION library
   @param     src    The location of the data to be written 
   @param     size   The number of bytes that I need to write 
-  @param     opaque A pointer to the file descriptor  
+  @param     opaque A pointer to the struct that describes the SION file 
   @return    integer FTI_SCES if successful.
 
-  Writes the data to a file using the SION library. 
+  Writes the data to a file using the SION library. If an MD5 context
+  is attached, the data is hashed after it has been written.
 
  **/
 /*-------------------------------------------------------------------------*/
 int write_sion(void *src, size_t size, void *opaque)
 {
-  int *sid= (int *)opaque;
-  int res = sion_fwrite(src, size, 1, *sid);
+  WriteSionInfo_t *write_info = (WriteSionInfo_t *)opaque;
+  int res = sion_fwrite(src, size, 1, write_info->sid);
   if (res < 0 ){
     return FTI_NSCS;
   }
+  if (write_info->integrity != NULL) {
+    MD5_Update(write_info->integrity, src, size);
+  }
   return FTI_SCES;
 }
 #endif
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief     Converts the MD5 context filled during the write to a string
+  @param     integrity The MD5 context updated by the write functions
+  @param     checksum  Hex string of the digest (MD5_DIGEST_STRING_LENGTH)
+
+  Finalizes the MD5 context and stores the digest in the same hex
+  format as FTI_Checksum, so both can be used for the metadata.
+
+ **/
+/*-------------------------------------------------------------------------*/
+void FTI_FinalizeIntegrity(MD5_CTX *integrity, char *checksum)
+{
+  unsigned char hash[MD5_DIGEST_LENGTH];
+  MD5_Final(hash, integrity);
+
+  int i, ii = 0;
+  for(i = 0; i < MD5_DIGEST_LENGTH; i++) {
+    sprintf(&checksum[ii], "%02x", hash[i]);
+    ii += 2;
+  }
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief     copies all data of GPU variables to a CPU memory location 
@@ -7,17 +7,50 @@
 #include "api_cuda.h"
 
 
+typedef struct
+{
+  FILE *f;
+  MD5_CTX *integrity; // NULL if no checksum is computed on write
+} WritePosixInfo_t;
+
+#define FTI_DIO_ALIGN 4096          /**< Alignment of O_DIRECT I/O.         */
+#define FTI_DIO_BUFSIZE 4194304     /**< Staging buffer of O_DIRECT writes. */
+
+typedef struct
+{
+  int fd;
+  char *fn;
+  char *buf;          // aligned staging buffer of FTI_DIO_BUFSIZE bytes
+  size_t fill;        // bytes held by the staging buffer
+  off_t offset;       // file offset of the staging buffer
+  MD5_CTX *integrity; // NULL if no checksum is computed on write
+} WriteDirectInfo_t;
+
 typedef struct
 {
   FTIT_configuration* FTI_Conf;
   MPI_File pfh;
   MPI_Offset offset;
   int err;
+  MD5_CTX *integrity; // NULL if no checksum is computed on write
 } WriteMPIInfo_t;
 
+#ifdef ENABLE_SIONLIB 
+typedef struct
+{
+  int sid;
+  MD5_CTX *integrity; // NULL if no checksum is computed on write
+} WriteSionInfo_t;
+#endif
 
 int write_posix(void *src, size_t size, void *opaque);
+int FTI_OpenDirect(WriteDirectInfo_t *write_info, char *fn, MD5_CTX *integrity);
+int write_direct(void *src, size_t size, void *opaque);
+int FTI_CloseDirect(WriteDirectInfo_t *write_info);
 int write_mpi(void *src, size_t size, void *opaque);
+void FTI_FinalizeIntegrity(MD5_CTX *integrity, char *checksum);
+MPI_Datatype FTI_GetChunkType(size_t size);
+void FTI_FreeChunkTypes();
 int copyDataFromDevive(FTIT_execution* FTI_Exec, FTIT_dataset* FTI_Data);
 
 #ifdef ENABLE_SIONLIB 
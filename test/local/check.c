@@ -128,8 +128,9 @@ int read_data(double* B_chk, size_t* asize_chk, int rank, size_t asize);
 
 int main(int argc, char* argv[]) {
 
-  unsigned char parity, crash, level, state, diff_sizes, enable_icp = -1;
-  int FTI_APP_RANK, result, tmp, success = 1;
+  unsigned char parity, crash, level, state, diff_sizes, enable_icp = -1, recover_var = 0;
+  int FTI_APP_RANK, result, tmp, success = 1, nbExtra = 0, i;
+  int *extra = NULL;
   double *A, *B, *B_chk;
 
   size_t asize, asize_chk;
@@ -162,6 +163,26 @@ int main(int argc, char* argv[]) {
     exit(WRONG_ENVIRONMENT);
   }
 
+  // optional, recover the variables one by one with FTI_RecoverVar
+  env = getenv("RECOVER_VAR");
+  if( env ) {
+    if( !strcmp(env, "ON") ) {
+      recover_var = 1;
+    }
+    else if( strcmp(env, "OFF") ) {
+      exit(WRONG_ENVIRONMENT);
+    }
+  }
+
+  // optional, number of additional scalars, each protected with an own id
+  env = getenv("EXTRA_VARS");
+  if( env ) {
+    nbExtra = atoi(env);
+    if( nbExtra < 0 ) {
+      exit(WRONG_ENVIRONMENT);
+    }
+  }
+
   MPI_Comm_rank(FTI_COMM_WORLD,&FTI_APP_RANK);
 
   dictionary *ini = iniparser_load( argv[1] );
@@ -222,10 +243,21 @@ int main(int argc, char* argv[]) {
   FTI_Protect(1, B, asize, FTI_DBLE);
   FTI_Protect(2, &asize, 1, FTI_INTG);
 
+  if (nbExtra > 0) {
+    extra = (int*) malloc(nbExtra*sizeof(int));
+    for (i = 0; i < nbExtra; i++) {
+      extra[i] = -1;
+      FTI_Protect(3+i, &extra[i], 1, FTI_INTG);
+    }
+  }
+
   state = FTI_Status();
 
   if (state == INIT) {
     init_arrays(A, B, asize);
+    for (i = 0; i < nbExtra; i++) {
+      extra[i] = FTI_APP_RANK*nbExtra + i;
+    }
     write_data(B, &asize, FTI_APP_RANK);
     if ( enable_icp == 1 ) {
       FTI_InitICP( 1, level, 1 );
@@ -255,12 +287,26 @@ int main(int argc, char* argv[]) {
   }
 
   if ( state == RESTART || state == KEEP ) {
-    result = FTI_Recover();
+    if ( recover_var ) {
+      result = FTI_RecoverVar(2);
+      result += FTI_RecoverVar(0);
+      result += FTI_RecoverVar(1);
+      for (i = 0; i < nbExtra; i++) {
+        result += FTI_RecoverVar(3+i);
+      }
+    } else {
+      result = FTI_Recover();
+    }
     if (result != FTI_SCES) {
       exit(RECOVERY_FAILED);
     }
     B_chk = (double*) malloc(asize*sizeof(double));
     result = read_data(B_chk, &asize_chk, FTI_APP_RANK, asize);
+    for (i = 0; i < nbExtra; i++) {
+      if (extra[i] != FTI_APP_RANK*nbExtra + i) {
+        result = -1;
+      }
+    }
     MPI_Barrier(FTI_COMM_WORLD);
     if (result != 0) {
       exit(DATA_CORRUPT);
@@ -284,6 +330,7 @@ int main(int argc, char* argv[]) {
 
   free(A);
   free(B);
+  free(extra);
 
   if (FTI_APP_RANK == 0 && (state == RESTART || state == KEEP)) {
     if (result == 0) {
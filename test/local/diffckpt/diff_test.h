@@ -69,6 +69,7 @@
 
 #define UI_UNIT sizeof(uint32_t)
 #define STATIC_SEED 310793 
+#define NBUFFER_FIXED 5
 
 enum ALLOC_FLAGS {
     ALLOC_FULL,
@@ -113,6 +114,7 @@ typedef struct _dcp_info {
     unsigned long *oldsize;
     int nbuffer;
     int test_mode;
+    bool fixed_layout;
     unsigned char **hash;
     xor_info_t xor_info[NUM_DCKPT];
 } dcp_info_t;
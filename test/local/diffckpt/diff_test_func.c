@@ -73,6 +73,10 @@ void init( dcp_info_t * info, unsigned long alloc_size ) {
 
     headRank = grank - grank%nodeSize;
 
+    // POSIX and MPI-IO store the variables contiguously and require the
+    // same variables on every rank, thus keep the layout fixed for them.
+    info->fixed_layout = ( (int)iniparser_getint(ini, "Basic:ckpt_io", 1) != 3 );
+
     char* env = getenv( "TEST_MODE" );
     if( env ) {
         if( strcmp( env, "ICP" ) == 0 ) {
@@ -110,7 +114,7 @@ void init( dcp_info_t * info, unsigned long alloc_size ) {
     usleep(5000*grank);
     srand(get_seed());
     if ( FTI_Status() == 0 ) {
-        info->nbuffer = rand()%10+1;
+        info->nbuffer = ( info->fixed_layout ) ? NBUFFER_FIXED : rand()%10+1;
     } else {
         FTI_RecoverVar( NBUFFER_ID );
     }
@@ -296,7 +300,7 @@ void allocate_buffers( dcp_info_t * info, unsigned long alloc_size) {
 }    
 unsigned long reallocate_buffers( dcp_info_t * info, unsigned long _alloc_size, enum ALLOC_FLAGS ALLOC_FLAG ) {
     unsigned long alloc_size;
-    if ( ALLOC_FLAG == ALLOC_RANDOM ) {
+    if ( ALLOC_FLAG == ALLOC_RANDOM && !info->fixed_layout ) {
         //srand(get_seed());
         alloc_size = ((unsigned long)(((uint64_t)rand() << 32) | rand()))%_alloc_size+1;
     } else {